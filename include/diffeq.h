@@ -13,9 +13,10 @@
 #ifndef DIFFEQ_H
 #define DIFFEQ_H
 
-#if !defined(DIFFEQ_FLOAT_PRECISION) &&     \
-    !defined(DIFFEQ_DOUBLE_PRECISION) &&    \
-    !defined(DIFFEQ_LONG_DOUBLE_PRECISION)  
+#if !defined(DIFFEQ_FLOAT_PRECISION) &&         \
+    !defined(DIFFEQ_DOUBLE_PRECISION) &&        \
+    !defined(DIFFEQ_LONG_DOUBLE_PRECISION) &&   \
+    !defined(DIFFEQ_DOUBLE_DOUBLE_PRECISION)
 #error Must specify precision
 #endif
 
@@ -26,11 +27,47 @@
 #define     ALGORITHM_EULER         0x001
 #define     ALGORITHM_RK4           0x002
 #define     ALGORITHM_RKF45         0x003
+#define     ALGORITHM_MRIGARK22     0x004
+#define     ALGORITHM_EM            0x005
+#define     ALGORITHM_MILSTEIN      0x006
+#define     ALGORITHM_SRA1          0x007
+#define     ALGORITHM_RB23          0x008
+#define     ALGORITHM_EXPM          0x009
+
+
+#define     DIRECTION_ANY           0
+#define     DIRECTION_RISING        1
+#define     DIRECTION_FALLING       -1
+
+
+#define     BOUNDARY_PERIODIC       0
+#define     BOUNDARY_DIRICHLET      1
+#define     BOUNDARY_NEUMANN        2
 
 
 #include "diffeq/dataframe.h"
 #include "diffeq/ode.h"
+#include "diffeq/dual.h"
+#include "diffeq/expression.h"
+#include "diffeq/bytecode.h"
 #include "diffeq/algorithms/rk.h"
+#include "diffeq/algorithms/rosenbrock.h"
+#include "diffeq/algorithms/parareal.h"
+#include "diffeq/parametric.h"
+#include "diffeq/algorithms/sensitivity.h"
+#include "diffeq/algorithms/adjoint.h"
+#include "diffeq/algorithms/shooting.h"
+#include "diffeq/pde.h"
+#include "diffeq/multirate.h"
+#include "diffeq/algorithms/mri.h"
+#include "diffeq/ensemble.h"
+#include "diffeq/algorithms/batch.h"
+#include "diffeq/linear.h"
+#include "diffeq/algorithms/exponential.h"
+#include "diffeq/dde.h"
+#include "diffeq/algorithms/delay.h"
+#include "diffeq/sde.h"
+#include "diffeq/algorithms/stochastic.h"
 
 
 #endif
\ No newline at end of file
@@ -0,0 +1,330 @@
+#ifndef DIFFEQ_ALGORITHMS_ADJOINT_H
+#define DIFFEQ_ALGORITHMS_ADJOINT_H
+
+#include <cmath>
+#include <functional>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+
+#include "../parametric.h"
+#include "control.h"
+#include "dense.h"
+#include "jacobian.h"
+#include "rk.h"
+
+
+namespace DES
+{
+
+/**
+ * @brief Result of an adjoint solve for an objective G(y(t_f)): the final state,
+ * the gradient with respect to the initial values and the gradient with respect
+ * to the parameters.
+ *
+ * @tparam T
+ */
+template <typename T>
+struct adjoint_t
+{
+    std::vector<T> y;           // (t_f, y_1, ..., y_m)
+    std::vector<T> dInitial;    // dG/dy(t0), m entries
+    std::vector<T> dParams;     // dG/dp, P entries
+};
+
+
+/**
+ * @brief State shared by the steps of one adjoint solve.
+ *
+ * @tparam T
+ */
+template <typename T>
+struct _adjointContext_t
+{
+    ParametricODESystem<T>* sys;
+    ODESystem<T> ode;           // forward system, stepped with RK4
+    std::vector<T> params;
+    T h;
+
+    std::vector<T> lambda, mu;
+    std::vector<T> vy, vp;      // vector-Jacobian product buffers
+};
+
+
+/**
+ * @brief Number of steps that can be reversed with s checkpoints when every step
+ * is recomputed at most t times, beta(s, t) = (s + t)! / (s! t!) (Griewank,
+ * 1992), saturated instead of overflowing.
+ *
+ * @param s
+ * @param t
+ * @return size_t
+ */
+inline size_t _binomialSteps(size_t s, size_t t)
+{
+    size_t res = 1;
+    for (size_t k = 1; k <= s; k++)
+    {
+        // res * (t + k) / k stays integral at every k
+        if (res > std::numeric_limits<size_t>::max() / (t + k))
+            return std::numeric_limits<size_t>::max();
+        res = res * (t + k) / k;
+    }
+
+    return res;
+}
+
+
+/**
+ * @brief w^T df/dy and w^T df/dp at (y, p). Uses the system's vector-Jacobian
+ * product if there is one, else its directional derivative along each unit
+ * vector, else forward differences, in which case the cost grows with m + P.
+ *
+ * @tparam T
+ * @param ctx
+ * @param y
+ * @param w
+ */
+template <typename T>
+void _adjointVJP(_adjointContext_t<T>& ctx, std::vector<T>& y, std::vector<T>& w)
+{
+    ParametricODESystem<T>& sys = *ctx.sys;
+    size_t m = sys.getNumEquations();
+    size_t P = sys.getNumParameters();
+
+    if (sys.hasVectorJacobianProduct())
+    {
+        sys._evalVJP(y, ctx.params, w, ctx.vy, ctx.vp);
+        return;
+    }
+
+    std::vector<T> f0(m), col(m), e(m, 0), ep(P, 0);
+    if (!sys.hasDirectionalDerivative())
+        sys._eval(y, ctx.params, f0);
+
+    // column j of [df/dy df/dp], then its dot product with w
+    auto dot = [&](size_t j) {
+        if (sys.hasDirectionalDerivative())
+        {
+            if (j < m) e[j] = 1; else ep[j - m] = 1;
+            sys._evalDirectional(y, ctx.params, e, ep, col);
+            if (j < m) e[j] = 0; else ep[j - m] = 0;
+        }
+        else
+        {
+            std::vector<T> yp(y), pp(ctx.params);
+            T step = j < m ? _differenceStep(y[j + 1]) : _differenceStep(pp[j - m]);
+            if (j < m) yp[j + 1] += step; else pp[j - m] += step;
+
+            sys._eval(yp, pp, col);
+            for (size_t i = 0; i < m; i++)
+                col[i] = (col[i] - f0[i]) / step;
+        }
+
+        T sum = 0;
+        for (size_t i = 0; i < m; i++)
+            sum += w[i] * col[i];
+        return sum;
+    };
+
+    for (size_t j = 0; j < m; j++)
+        ctx.vy[j] = dot(j);
+    for (size_t j = 0; j < P; j++)
+        ctx.vp[j] = dot(m + j);
+}
+
+
+/**
+ * @brief Advance the forward solution by n RK4 steps.
+ *
+ * @tparam T
+ * @param ctx
+ * @param y
+ * @param n
+ */
+template <typename T>
+void _adjointAdvance(_adjointContext_t<T>& ctx, std::vector<T>& y, size_t n)
+{
+    ctx.ode.lastValues = y;
+    ctx.ode.lastCompensation.clear();
+    for (size_t k = 0; k < n; k++)
+        _RK4_i(ctx.ode);
+
+    y = ctx.ode.lastValues;
+}
+
+
+/**
+ * @brief Integrate the adjoint equations dlambda/dt = -(df/dy)^T lambda and
+ * dmu/dt = -(df/dp)^T lambda backwards over the forward step that starts at y0,
+ * with RK4. The step is recomputed, and the state inside it is taken from its
+ * Hermite interpolant.
+ *
+ * @tparam T
+ * @param ctx
+ * @param y0
+ */
+template <typename T>
+void _adjointStep(_adjointContext_t<T>& ctx, std::vector<T>& y0)
+{
+    size_t m = ctx.lambda.size();
+    size_t P = ctx.mu.size();
+    T h = ctx.h;
+
+    std::vector<T> y1(y0);
+    _adjointAdvance(ctx, y1, 1);
+
+    std::vector<T> f0(m), f1(m);
+    ctx.sys->_eval(y0, ctx.params, f0);
+    ctx.sys->_eval(y1, ctx.params, f1);
+    denseStep_t<T> dense(y0, y1, f0, f1);
+
+    std::vector<T> yMid = dense(y0[0] + h / 2);
+    std::vector<T> ky[4], kp[4];
+    std::vector<T> w(ctx.lambda);
+
+    // stages at the end, twice at the middle and at the start of the step
+    for (int s = 0; s < 4; s++)
+    {
+        std::vector<T>& y = s == 0 ? y1 : (s == 3 ? y0 : yMid);
+        _adjointVJP(ctx, y, w);
+        ky[s] = ctx.vy;
+        kp[s] = ctx.vp;
+
+        T c = s == 2 ? h : h / 2;
+        for (size_t i = 0; i < m && s < 3; i++)
+            w[i] = ctx.lambda[i] + c * ky[s][i];
+    }
+
+    for (size_t i = 0; i < m; i++)
+        ctx.lambda[i] += h / 6 * (ky[0][i] + 2 * ky[1][i] + 2 * ky[2][i] + ky[3][i]);
+    for (size_t j = 0; j < P; j++)
+        ctx.mu[j] += h / 6 * (kp[0][j] + 2 * kp[1][j] + 2 * kp[2][j] + kp[3][j]);
+}
+
+
+/**
+ * @brief Reverse the n forward steps that start at y0, with s free checkpoints.
+ * The binomial schedule of revolve (Griewank and Walther, 2000) stores a
+ * checkpoint where the remaining steps can still be reversed with s - 1
+ * checkpoints and the smallest number of recomputations, reverses the part after
+ * it, and then the part before it with the checkpoint freed again. Without free
+ * checkpoints, every step is recomputed from y0.
+ *
+ * @tparam T
+ * @param ctx
+ * @param y0
+ * @param n
+ * @param s
+ */
+template <typename T>
+void _adjointReverse(_adjointContext_t<T>& ctx, std::vector<T>& y0, size_t n, size_t s)
+{
+    if (n == 0)
+        return;
+
+    if (n == 1)
+    {
+        _adjointStep(ctx, y0);
+        return;
+    }
+
+    if (s == 0)
+    {
+        for (size_t k = n; k-- > 0;)
+        {
+            std::vector<T> y(y0);
+            _adjointAdvance(ctx, y, k);
+            _adjointStep(ctx, y);
+        }
+        return;
+    }
+
+    // smallest number of repetitions t with beta(s, t) >= n
+    size_t t = 0;
+    while (_binomialSteps(s, t) < n)
+        t++;
+
+    size_t right = _binomialSteps(s - 1, t);
+    size_t split = n > right ? n - right : 1;
+    if (split >= n)
+        split = n - 1;
+
+    std::vector<T> checkpoint(y0);
+    _adjointAdvance(ctx, checkpoint, split);
+
+    _adjointReverse(ctx, checkpoint, n - split, s - 1);
+    checkpoint.clear();
+    checkpoint.shrink_to_fit();
+
+    _adjointReverse(ctx, y0, split, s);
+}
+
+
+/**
+ * @brief Gradient of an objective G(y(t_f)) with respect to the parameters and
+ * initial values of a parametric system, by the continuous adjoint method. The
+ * forward solution is computed with RK4 at the system's timestep (shortened so
+ * the last step ends on t_f), and only the given number of checkpoints are kept
+ * in memory; the steps in between are recomputed during the backward sweep with
+ * the binomial revolve schedule. With c checkpoints and N steps, each step is
+ * recomputed about t times, where t is the smallest value with
+ * (c + t)! / (c! t!) >= N.
+ *
+ * With a vector-Jacobian product on the system, the cost does not depend on
+ * the number of parameters.
+ *
+ * @tparam T
+ * @param sys
+ * @param dGdy Gradient of the objective with respect to the final state, given
+ * the final values (t_f, y_1, ..., y_m).
+ * @param checkpoints Number of forward states kept in addition to the initial one.
+ * @return adjoint_t<T>
+ */
+template <typename T>
+adjoint_t<T> solveAdjoint(ParametricODESystem<T>& sys, std::function<std::vector<T>(const std::vector<T>&)> dGdy, size_t checkpoints)
+{
+    timeBound_t<T> tBound = sys.getTimeBound();
+    size_t m = sys.getNumEquations();
+    size_t P = sys.getNumParameters();
+
+    if (sys.getTimeStep() <= 0)
+        throw std::invalid_argument("The adjoint method needs a timestep");
+
+    using std::ceil;
+    size_t n = (size_t)ceil((tBound.second - tBound.first) / sys.getTimeStep());
+    if (n == 0)
+        n = 1;
+
+    _adjointContext_t<T> ctx;
+    ctx.sys = &sys;
+    ctx.params = sys.getParameters();
+    ctx.h = (tBound.second - tBound.first) / n;
+    ctx.ode = sys._getODESystem();
+    ctx.ode.setTimeStep(ctx.h);
+    ctx.vy.resize(m);
+    ctx.vp.resize(P);
+
+    adjoint_t<T> res;
+    std::vector<T> y0(sys.getInitialConditions().vec);
+
+    res.y = y0;
+    _adjointAdvance(ctx, res.y, n);
+
+    ctx.lambda = dGdy(res.y);
+    ctx.mu.assign(P, 0);
+    if (ctx.lambda.size() != m)
+        throw std::invalid_argument("Gradient of the objective must have one entry per equation");
+
+    _adjointReverse(ctx, y0, n, checkpoints);
+
+    res.dInitial = ctx.lambda;
+    res.dParams = ctx.mu;
+    return res;
+}
+
+
+} // namespace DES
+
+
+#endif
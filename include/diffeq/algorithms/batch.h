@@ -0,0 +1,151 @@
+#ifndef DIFFEQ_ALGORITHMS_BATCH_H
+#define DIFFEQ_ALGORITHMS_BATCH_H
+
+#include <vector>
+
+#include "../ensemble.h"
+#include "../restrict.h"
+#include "summation.h"
+
+
+// Methods for EnsembleSystem. The members are advanced in batches of
+// _ENSEMBLE_BATCH, stored by component (entry i of member l at i * n + l), so
+// the right hand side is called once per stage for the whole batch and every
+// update below is a loop over contiguous lanes that the compiler vectorizes. A
+// batch of a few hundred keeps the stages of most systems in cache.
+
+
+#define  _ENSEMBLE_BATCH        256
+
+
+namespace DES
+{
+
+/**
+ * @brief Classical RK4 on the members [first, first + n) of the ensemble, with
+ * the fixed timestep of the ensemble, from the beginning to the end of its time
+ * bound. All members share the time, so they take the same steps.
+ *
+ * @tparam T
+ * @param ode
+ * @param first
+ * @param n
+ * @param y Final states, (m + 1) n entries stored by component.
+ */
+template <typename T>
+void _RK4_batch(EnsembleSystem<T>& ode, size_t first, size_t n, std::vector<T>& y)
+{
+    timeBound_t<T> tBound = ode.getTimeBound();
+
+    size_t m = ode.getNumEquations();
+    size_t N = (m + 1) * n;
+
+    T h = ode.getTimeStep();
+    T t = tBound.first;
+    T tComp = 0;
+
+    y.assign(N, 0);
+    std::vector<T> comp(N, 0), stage(N), k_1(m * n), k_2(m * n), k_3(m * n), k_4(m * n);
+
+    for (size_t l = 0; l < n; l++)
+    {
+        iv_t<T> iv = ode.getInitialConditions(first + l);
+        for (size_t i = 1; i <= m; i++)
+            y[i * n + l] = iv.vec[i];
+    }
+
+    T* _DIFFEQ_RESTRICT Y = y.data();
+    T* _DIFFEQ_RESTRICT S = stage.data();
+    T* _DIFFEQ_RESTRICT K1 = k_1.data();
+    T* _DIFFEQ_RESTRICT K2 = k_2.data();
+    T* _DIFFEQ_RESTRICT K3 = k_3.data();
+    T* _DIFFEQ_RESTRICT K4 = k_4.data();
+
+    do
+    {
+        for (size_t l = 0; l < n; l++)
+            Y[l] = t;
+
+        ode._evalBatch(Y, K1, n);
+
+        for (size_t l = 0; l < n; l++)
+            S[l] = t + h / 2;
+        for (size_t j = n; j < N; j++)
+            S[j] = Y[j] + h / 2 * K1[j - n];
+
+        ode._evalBatch(S, K2, n);
+
+        for (size_t j = n; j < N; j++)
+            S[j] = Y[j] + h / 2 * K2[j - n];
+
+        ode._evalBatch(S, K3, n);
+
+        for (size_t l = 0; l < n; l++)
+            S[l] = t + h;
+        for (size_t j = n; j < N; j++)
+            S[j] = Y[j] + h * K3[j - n];
+
+        ode._evalBatch(S, K4, n);
+
+        for (size_t j = n; j < N; j++)
+            _accumulate(Y[j], comp[j], h * (K1[j - n] + 2 * K2[j - n] + 2 * K3[j - n] + K4[j - n]) / 6);
+
+        _accumulate(t, tComp, h);
+
+    } while (t < tBound.second);
+
+    for (size_t l = 0; l < n; l++)
+        Y[l] = t;
+}
+
+
+/**
+ * @brief Classical RK4 on every member of the ensemble, one batch at a time, or
+ * with the batches spread over pool if it is not null.
+ *
+ * @tparam T
+ * @param ode
+ * @param pool
+ * @return DataFrame<T> One row (t, y_1, ..., y_m) per member at the final time.
+ */
+template <typename T>
+DataFrame<T> _RK4_ensemble(EnsembleSystem<T>& ode, ThreadPool* pool)
+{
+    size_t m = ode.getNumEquations();
+    size_t members = ode.getNumMembers();
+    size_t batches = (members + _ENSEMBLE_BATCH - 1) / _ENSEMBLE_BATCH;
+
+    std::vector<std::vector<T>> states(batches);
+    auto run = [&](size_t b) {
+        size_t first = b * _ENSEMBLE_BATCH;
+        size_t n = members - first < _ENSEMBLE_BATCH ? members - first : _ENSEMBLE_BATCH;
+        _RK4_batch(ode, first, n, states[b]);
+    };
+
+    if (pool)
+        pool->parallelFor(0, batches, run);
+    else
+        for (size_t b = 0; b < batches; b++)
+            run(b);
+
+    DataFrame<T> res(0, m + 1);
+    for (size_t b = 0; b < batches; b++)
+    {
+        size_t n = states[b].size() / (m + 1);
+        for (size_t l = 0; l < n; l++)
+        {
+            std::vector<T> row(m + 1);
+            for (size_t i = 0; i <= m; i++)
+                row[i] = states[b][i * n + l];
+            res.addRow(row);
+        }
+    }
+
+    return res;
+}
+
+
+} // namespace DES
+
+
+#endif
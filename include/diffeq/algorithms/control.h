@@ -0,0 +1,162 @@
+#ifndef DIFFEQ_ALGORITHMS_CONTROL_H
+#define DIFFEQ_ALGORITHMS_CONTROL_H
+
+#include <cmath>
+#include <vector>
+
+#include "../ode.h"
+
+
+// Step size control shared by the adaptive methods, following Hairer, Norsett
+// and Wanner, "Solving Ordinary Differential Equations I", section II.4.
+
+
+#define  _CONTROL_SAFETY            0.9
+#define  _CONTROL_MIN_FACTOR        0.2
+#define  _CONTROL_MAX_FACTOR        5.0
+
+
+#if defined(DIFFEQ_FLOAT_PRECISION)
+    #define  _CONTROL_SQRT(a)           sqrtf(a)
+    #define  _CONTROL_POW(a, b)         powf(a, b)
+    #define  _CONTROL_ABS(a)            fabsf(a)
+#elif defined(DIFFEQ_DOUBLE_PRECISION)
+    #define  _CONTROL_SQRT(a)           sqrt(a)
+    #define  _CONTROL_POW(a, b)         pow(a, b)
+    #define  _CONTROL_ABS(a)            fabs(a)
+#elif defined(DIFFEQ_LONG_DOUBLE_PRECISION)
+    #define  _CONTROL_SQRT(a)           sqrtl(a)
+    #define  _CONTROL_POW(a, b)         powl(a, b)
+    #define  _CONTROL_ABS(a)            fabsl(a)
+#elif defined(DIFFEQ_DOUBLE_DOUBLE_PRECISION)
+    #define  _CONTROL_SQRT(a)           sqrt(a)
+    #define  _CONTROL_POW(a, b)         pow(a, b)
+    #define  _CONTROL_ABS(a)            fabs(a)
+#else
+    #define  _CONTROL_SQRT(a)           (T)sqrt(a)
+    #define  _CONTROL_POW(a, b)         (T)pow(a, b)
+    #define  _CONTROL_ABS(a)            (T)fabs(a)
+#endif
+
+
+namespace DES
+{
+
+/**
+ * @brief Weighted RMS norm of a local error estimate (Hairer's norm). All
+ * vectors are in the (t, y_1, ..., y_m) layout used by the steppers, so index 0
+ * is skipped. Component i is scaled by atol_i + rtol_i * max(|y0_i|, |y1_i|).
+ *
+ * @tparam T
+ * @param err Local error estimate.
+ * @param y0 Values at the start of the step.
+ * @param y1 Values at the end of the step.
+ * @param tol
+ * @return T Error norm, where values <= 1 mean the step is accepted.
+ */
+template <typename T>
+T _errorNorm(std::vector<T>& err, std::vector<T>& y0, std::vector<T>& y1, tolerance_t<T>& tol)
+{
+    size_t m = err.size() - 1;
+    T sum = 0;
+
+    for (size_t i = 1; i <= m; i++)
+    {
+        T y = _CONTROL_ABS(y0[i]) > _CONTROL_ABS(y1[i]) ? _CONTROL_ABS(y0[i]) : _CONTROL_ABS(y1[i]);
+        T sc = tol.absolute(i - 1) + tol.relative(i - 1) * y;
+        T e = err[i] / sc;
+        sum += e * e;
+    }
+
+    return _CONTROL_SQRT(sum / m);
+}
+
+
+/**
+ * @brief Factor to multiply the step size by after a step with error norm err,
+ * for a method whose error estimate is of the given order. The factor is bounded
+ * so the step never shrinks or grows too abruptly.
+ *
+ * @tparam T
+ * @param err
+ * @param order Order of the lower order solution in the embedded pair.
+ * @return T
+ */
+template <typename T>
+T _stepFactor(T err, T order)
+{
+    if (err == 0)
+        return (T)_CONTROL_MAX_FACTOR;
+
+    T fac = (T)_CONTROL_SAFETY * _CONTROL_POW(1 / err, 1 / (order + 1));
+
+    if (fac < (T)_CONTROL_MIN_FACTOR) return (T)_CONTROL_MIN_FACTOR;
+    if (fac > (T)_CONTROL_MAX_FACTOR) return (T)_CONTROL_MAX_FACTOR;
+    return fac;
+}
+
+
+/**
+ * @brief Choose the starting step size of an adaptive method when the user does
+ * not give one (Hairer's algorithm, HNW I, II.4). The slope at the initial
+ * point comes from the caller, which needs it for its first step anyway, so it
+ * costs one right hand side evaluation, after a small explicit Euler step; the
+ * two slopes estimate the scale of the solution and of its second derivative.
+ *
+ * @tparam T
+ * @param ode
+ * @param y0 Initial values, of the form (t, y_1, ..., y_m).
+ * @param f0 f(t, y) at y0.
+ * @param order Order of the method.
+ * @param tol
+ * @param tEnd Upper time bound, which the step never exceeds.
+ * @return T
+ */
+template <typename T>
+T _initialStep(ODESystem<T>& ode, std::vector<T>& y0, std::vector<T>& f0, T order, tolerance_t<T>& tol, T tEnd)
+{
+    size_t m = ode.getNumEquations();
+
+    T d0 = 0, d1 = 0;
+    for (size_t i = 1; i <= m; i++)
+    {
+        T sc = tol.absolute(i - 1) + tol.relative(i - 1) * _CONTROL_ABS(y0[i]);
+        d0 += (y0[i] / sc) * (y0[i] / sc);
+        d1 += (f0[i-1] / sc) * (f0[i-1] / sc);
+    }
+    d0 = _CONTROL_SQRT(d0 / m);
+    d1 = _CONTROL_SQRT(d1 / m);
+
+    T h0 = (d0 < (T)1e-5 || d1 < (T)1e-5) ? (T)1e-6 : (T)0.01 * d0 / d1;
+    if (h0 > tEnd - y0[0]) h0 = tEnd - y0[0];
+
+    // explicit Euler step to estimate the second derivative
+    std::vector<T> y1(y0);
+    y1[0] += h0;
+    for (size_t i = 1; i <= m; i++)
+        y1[i] += h0 * f0[i-1];
+
+    std::vector<T> f1 = ode._eval(y1);
+
+    T d2 = 0;
+    for (size_t i = 1; i <= m; i++)
+    {
+        T sc = tol.absolute(i - 1) + tol.relative(i - 1) * _CONTROL_ABS(y0[i]);
+        d2 += ((f1[i-1] - f0[i-1]) / sc) * ((f1[i-1] - f0[i-1]) / sc);
+    }
+    d2 = _CONTROL_SQRT(d2 / m) / h0;
+
+    T dmax = d1 > d2 ? d1 : d2;
+    T h1 = dmax <= (T)1e-15 
+        ? (h0 * (T)1e-3 > (T)1e-6 ? h0 * (T)1e-3 : (T)1e-6)
+        : _CONTROL_POW((T)0.01 / dmax, 1 / (order + 1));
+
+    T h = 100 * h0 < h1 ? 100 * h0 : h1;
+    return h < tEnd - y0[0] ? h : tEnd - y0[0];
+}
+
+
+} // namespace DES
+
+
+#endif
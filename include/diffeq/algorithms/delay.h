@@ -0,0 +1,156 @@
+#ifndef DIFFEQ_ALGORITHMS_DELAY_H
+#define DIFFEQ_ALGORITHMS_DELAY_H
+
+#include "../dde.h"
+#include "control.h"
+#include "dense.h"
+#include "rk.h"
+
+
+namespace DES 
+{
+
+/**
+ * @brief Solve a system of delay differential equations with RKF45. Every 
+ * accepted step is added to the history as its Hermite interpolant, which the 
+ * right hand side then reads delayed values from. Events are not supported.
+ *
+ * Besides the local error of the step, the error of the interpolant is kept
+ * within the tolerance (from its defect a quarter into the step, which costs one
+ * more evaluation per step), since the delayed values are read from it.
+ *
+ * The solution is only piecewise smooth: its derivatives jump at the initial
+ * time plus multiples of the delays. With a single constant delay (minDelay ==
+ * maxDelay) steps end on those times. With several or state dependent delays
+ * the jumps are not tracked, and only the error estimates shorten the steps
+ * across them. That costs more steps, and a jump in a high derivative that
+ * neither estimate sees limits the accuracy however tight the tolerance.
+ * 
+ * @tparam T 
+ * @param dde 
+ * @param options 
+ * @return DataFrame<T> 
+ */
+template <typename T>
+DataFrame<T> _RKF45(DDESystem<T>& dde, options_t<T> options) 
+{
+    timeBound_t<T> tBound = dde.getTimeBound();
+    tolerance_t<T>& tol = options.tolerance;
+    ODESystem<T> ode = dde._getODESystem();
+
+    size_t m = dde.getNumEquations();
+    size_t save = 0;
+
+    T h = dde.getTimeStep();
+    T t = tBound.first;
+
+    dde.history.clear();
+
+    std::vector<T> y(dde.getInitialConditions().vec);
+    std::vector<T> k_1j = ode._eval(y);
+
+    DataFrame<T> res(0, m + 1);
+    if (options.saveat.empty())
+        res.addRow(y);
+
+    for (; save < options.saveat.size() && options.saveat[save] <= t; save++)
+        if (options.saveat[save] == t)
+            res.addRow(y);
+
+    if (h <= 0)
+        h = _initialStep(ode, y, k_1j, (T)4, tol, tBound.second);
+
+    // with a single constant delay, the jump in y' at the initial time comes
+    // back in ever higher derivatives at t0 + k tau, so steps end there
+    T tau = dde.getMinDelay() == dde.getMaxDelay() ? dde.getMinDelay() : 0;
+    size_t breaks = 1;
+
+    while (t < tBound.second)
+    {
+        if (options.maxStep > 0)
+            h = _MIN(h, options.maxStep);
+        if (dde.getMinDelay() > 0)
+            h = _MIN(h, dde.getMinDelay());
+        h = _MIN(h, tBound.second - t);
+
+        T wanted = h;
+        T breakpoint = tBound.first + (T)breaks * tau;
+        bool landing = tau > 0 && t + h >= breakpoint;
+        if (landing)
+            h = breakpoint - t;
+
+        std::vector<T> w1(m + 1), err(m + 1);
+
+        _RKF45_step(ode, y, k_1j, h, w1, err);
+
+        T R = _errorNorm(err, y, w1, tol);
+        T delta = _stepFactor(R, (T)4);
+
+        if (R <= 1) 
+        {
+            if (landing)
+                w1[0] = breakpoint;
+
+            std::vector<T> f1 = ode._eval(w1);
+            denseStep_t<T> dense(y, w1, k_1j, f1);
+
+            // later steps read delayed values from the interpolant, so its error
+            // is controlled too: a quarter into the step, the defect of a cubic
+            // Hermite interpolant is h^3 y^(4) / 128, and its largest error is
+            // h/3 times that
+            std::vector<T> yq = dense(y[0] + h / 4);
+            std::vector<T> fq = ode._eval(yq);
+            std::vector<T> defect(m + 1, 0);
+            for (size_t i = 1; i <= m; i++)
+                defect[i] = h / 3 * (fq[i-1] - dense.derivative(yq[0], i));
+
+            T Rq = _errorNorm(defect, y, w1, tol);
+            delta = _MIN(delta, _stepFactor(Rq, (T)3));
+
+            if (Rq > 1)
+            {
+                h *= delta;
+                continue;
+            }
+
+            if (landing)
+                breaks++;
+
+            dde.history.push(dense);
+
+            if (options.saveat.empty())
+                res.addRow(w1);
+            else 
+                _saveDense(res, options.saveat, save, dense, w1[0]);
+
+            t = w1[0];
+            y = w1;
+            k_1j = f1;
+
+            // a step cut short by a breakpoint says little about the next one
+            if (landing)
+            {
+                h = wanted;
+                continue;
+            }
+        }
+
+        h *= delta;
+    }
+
+    return res;
+}
+
+
+
+template <typename T>
+DataFrame<T> _RKF45(DDESystem<T>& dde) 
+{
+    return _RKF45(dde, options_t<T>());
+}
+
+
+} // namespace DES
+
+
+#endif
@@ -0,0 +1,116 @@
+#ifndef DIFFEQ_ALGORITHMS_DENSE_H
+#define DIFFEQ_ALGORITHMS_DENSE_H
+
+#include <vector>
+
+#include "../dataframe.h"
+
+
+namespace DES
+{
+
+/**
+ * @brief Continuous extension of one accepted step, used to produce output at
+ * arbitrary times inside the step without stepping to them. This is the cubic
+ * Hermite interpolant through the values and derivatives at both ends of the
+ * step, so it needs no right hand side evaluations beyond the ones the stepper
+ * already makes (the derivative at the end of a step is the first stage of the
+ * next one).
+ *
+ * @tparam T
+ */
+template <typename T>
+struct denseStep_t
+{
+    std::vector<T> y0, y1;      // values of the form (t, y_1, ..., y_m)
+    std::vector<T> f0, f1;      // derivatives, one entry per equation
+
+    denseStep_t() = default;
+    denseStep_t(std::vector<T>& start, std::vector<T>& end, std::vector<T>& dStart, std::vector<T>& dEnd)
+        : y0(start)
+        , y1(end)
+        , f0(dStart)
+        , f1(dEnd)
+    { }
+
+    T begin() const { return y0[0]; }
+    T end() const   { return y1[0]; }
+
+
+    /**
+     * @brief Evaluate component i (1 <= i <= m) at time t.
+     *
+     * @param t
+     * @param i
+     * @return T
+     */
+    T eval(T t, size_t i) const
+    {
+        T h = y1[0] - y0[0];
+        T theta = (t - y0[0]) / h;
+        T dy = y1[i] - y0[i];
+
+        return (1 - theta) * y0[i] + theta * y1[i] 
+            + theta * (theta - 1) * ((1 - 2 * theta) * dy + (theta - 1) * h * f0[i-1] + theta * h * f1[i-1]);
+    }
+
+
+    /**
+     * @brief Derivative of component i (1 <= i <= m) of the interpolant at time t.
+     *
+     * @param t
+     * @param i
+     * @return T
+     */
+    T derivative(T t, size_t i) const
+    {
+        T h = y1[0] - y0[0];
+        T theta = (t - y0[0]) / h;
+        T dy = y1[i] - y0[i];
+
+        return 6 * theta * (1 - theta) * dy / h
+            + (1 - theta) * (1 - 3 * theta) * f0[i-1] + theta * (3 * theta - 2) * f1[i-1];
+    }
+
+
+    /**
+     * @brief Evaluate every component at time t.
+     *
+     * @param t
+     * @return std::vector<T> Values of the form (t, y_1, ..., y_m).
+     */
+    std::vector<T> operator()(T t) const
+    {
+        std::vector<T> res(y0.size());
+        res[0] = t;
+        for (size_t i = 1; i < y0.size(); i++)
+            res[i] = eval(t, i);
+
+        return res;
+    }
+};
+
+
+/**
+ * @brief Store the requested output times that fall inside one step, up to and
+ * including tEnd, and advance the index of the next output time.
+ *
+ * @tparam T
+ * @param res
+ * @param saveat
+ * @param save Index of the next output time.
+ * @param dense
+ * @param tEnd
+ */
+template <typename T>
+void _saveDense(DataFrame<T>& res, std::vector<T>& saveat, size_t& save, denseStep_t<T>& dense, T tEnd)
+{
+    for (; save < saveat.size() && saveat[save] <= tEnd; save++)
+        res.addRow(dense(saveat[save]));
+}
+
+
+} // namespace DES
+
+
+#endif
@@ -0,0 +1,148 @@
+#ifndef DIFFEQ_ALGORITHMS_EVENTS_H
+#define DIFFEQ_ALGORITHMS_EVENTS_H
+
+#include <algorithm>
+#include <limits>
+#include <utility>
+#include <vector>
+
+#include "../solver.h"
+#include "dense.h"
+
+
+#define  _EVENT_MAX_ITERATIONS      100
+
+
+namespace DES
+{
+
+/**
+ * @brief Evaluate every event condition at one state.
+ *
+ * @tparam T
+ * @param events
+ * @param y Values of the form (t, y_1, ..., y_m).
+ * @return std::vector<T>
+ */
+template <typename T>
+std::vector<T> _evalEvents(std::vector<event_t<T>>& events, std::vector<T>& y)
+{
+    std::vector<T> g;
+    for (event_t<T>& ev : events)
+        g.push_back(ev.condition(y));
+
+    return g;
+}
+
+
+/**
+ * @brief Whether the change of an event function from g0 to g1 over a step is a
+ * crossing in the direction the event listens for. Steps that start exactly on
+ * the surface (e.g. right after the event was handled) do not count.
+ *
+ * @tparam T
+ * @param direction
+ * @param g0
+ * @param g1
+ * @return bool
+ */
+template <typename T>
+bool _isCrossing(int direction, T g0, T g1)
+{
+    bool rising  = g0 < 0 && g1 >= 0;
+    bool falling = g0 > 0 && g1 <= 0;
+
+    switch (direction)
+    {
+        case DIRECTION_RISING:      return rising;
+        case DIRECTION_FALLING:     return falling;
+        default:                    return rising || falling;
+    }
+}
+
+
+/**
+ * @brief Locate the zero of an event function inside a step with the Illinois
+ * variant of regula falsi, using the interpolant of the step for the state, so
+ * no right hand side evaluations are needed. The returned time is the end of the
+ * final bracket that lies on the far side of the crossing, or the end of the
+ * step if the event function is zero there.
+ *
+ * @tparam T
+ * @param ev
+ * @param dense
+ * @param g0 Event function at the start of the step.
+ * @param g1 Event function at the end of the step.
+ * @return T
+ */
+template <typename T>
+T _locateEvent(event_t<T>& ev, denseStep_t<T>& dense, T g0, T g1)
+{
+    T a = dense.begin(), b = dense.end();
+    T fa = g0, fb = g1;
+    T tol = 4 * std::numeric_limits<T>::epsilon() * ((b > 0 ? b : -b) + (b - a));
+    int side = 0;
+
+    if (fb == 0)
+        return b;
+    if (fa == 0)
+        return a;
+
+    for (int iter = 0; iter < _EVENT_MAX_ITERATIONS && b - a > tol; iter++)
+    {
+        T c = (fa * b - fb * a) / (fa - fb);
+        if (!(c > a && c < b)) c = (a + b) / 2;    // guard against round-off
+
+        std::vector<T> yc = dense(c);
+        T fc = ev.condition(yc);
+
+        if (fc == 0)
+            return c;
+
+        // fa keeps its sign (it is never zero here), so it tells the sides apart
+        if ((fc < 0) == (fa < 0))
+        {
+            a = c; fa = fc;
+            if (side == 1) fb /= 2;     // the same end was kept twice, so halve it
+            side = 1;
+        }
+        else
+        {
+            b = c; fb = fc;
+            if (side == -1) fa /= 2;
+            side = -1;
+        }
+    }
+
+    return b;
+}
+
+
+/**
+ * @brief Find every event that is triggered within one step, ordered by time.
+ *
+ * @tparam T
+ * @param events
+ * @param dense Interpolant of the step.
+ * @param g0 Event functions at the start of the step.
+ * @param g1 Event functions at the end of the step.
+ * @return std::vector<std::pair<T, size_t>> Pairs of (event time, event index).
+ */
+template <typename T>
+std::vector<std::pair<T, size_t>> _findEvents(std::vector<event_t<T>>& events, denseStep_t<T>& dense, std::vector<T>& g0, std::vector<T>& g1)
+{
+    std::vector<std::pair<T, size_t>> hits;
+
+    for (size_t k = 0; k < events.size(); k++)
+        if (_isCrossing(events[k].direction, g0[k], g1[k]))
+            hits.push_back({ _locateEvent(events[k], dense, g0[k], g1[k]), k });
+
+    std::sort(hits.begin(), hits.end());
+    return hits;
+}
+
+
+} // namespace DES
+
+
+#endif
@@ -0,0 +1,98 @@
+#ifndef DIFFEQ_ALGORITHMS_EXPONENTIAL_H
+#define DIFFEQ_ALGORITHMS_EXPONENTIAL_H
+
+#include <vector>
+
+#include "../linear.h"
+#include "../restrict.h"
+
+
+namespace DES
+{
+
+/**
+ * @brief Exact step of size h of a LinearODESystem, in place: y = P (y, 1) with
+ * the cached propagator P of h, so a step costs one matrix-vector product.
+ *
+ * @tparam T
+ * @param ode
+ * @param inputs Values of the form (t, y_1, ..., y_m).
+ * @param h
+ */
+template <typename T>
+void _EXPM_step(LinearODESystem<T>& ode, std::vector<T>& inputs, T h)
+{
+    size_t m = ode.getNumEquations();
+    size_t n = m + 1;
+
+    const std::vector<T>& P = ode.getPropagator(h);
+    std::vector<T> y(inputs.begin() + 1, inputs.end());
+
+    for (size_t i = 0; i < m; i++)
+    {
+        const T* _DIFFEQ_RESTRICT p = P.data() + i * n;
+        T sum = p[m];
+        for (size_t j = 0; j < m; j++)
+            sum += p[j] * y[j];
+        inputs[i + 1] = sum;
+    }
+
+    inputs[0] += h;
+}
+
+
+/**
+ * @brief Solve a LinearODESystem with its fixed timestep. The states are exact
+ * up to rounding in the propagator and the products, whatever the step; the
+ * former grows with the norm of hA (see LinearODESystem).
+ *
+ * @tparam T
+ * @param ode
+ * @return DataFrame<T>
+ */
+template <typename T>
+DataFrame<T> _EXPM(LinearODESystem<T>& ode)
+{
+    timeBound_t<T> tBound = ode.getTimeBound();
+
+    size_t m = ode.getNumEquations();
+    size_t row = 0;
+
+    T h = ode.getTimeStep();
+    T t = tBound.first;
+
+    DataFrame<T> res(0, m + 1);
+    res.addRow(ode.getInitialConditions().vec);
+
+    do
+    {
+        std::vector<T> result(res.getRow(row));
+
+        _EXPM_step(ode, result, h);
+        result[0] = t + h;
+
+        res.addRow(result);
+
+        row++;
+        t += h;
+
+    } while (t < tBound.second);
+
+    return res;
+}
+
+
+
+template <typename T>
+std::vector<T> _EXPM_i(LinearODESystem<T>& ode)
+{
+    _EXPM_step(ode, ode.lastValues, ode.getTimeStep());
+
+    return std::vector<T>(ode.lastValues);
+}
+
+
+} // namespace DES
+
+
+#endif
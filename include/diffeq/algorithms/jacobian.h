@@ -0,0 +1,321 @@
+#ifndef DIFFEQ_ALGORITHMS_JACOBIAN_H
+#define DIFFEQ_ALGORITHMS_JACOBIAN_H
+
+#include <limits>
+#include <vector>
+
+#include "../ode.h"
+#include "../linalg/banded.h"
+#include "../threadpool.h"
+#include "control.h"
+
+
+namespace DES
+{
+
+/**
+ * @brief Forward difference step for a value x, sqrt(eps) relative to its
+ * magnitude (at least 1). The step is rounded so that x + step is exactly
+ * representable, which removes most of the cancellation error.
+ *
+ * @tparam T
+ * @param x
+ * @return T
+ */
+template <typename T>
+T _differenceStep(T x)
+{
+    T scale = _CONTROL_ABS(x) > 1 ? _CONTROL_ABS(x) : 1;
+    T step = _CONTROL_SQRT(std::numeric_limits<T>::epsilon()) * scale;
+#if defined(DIFFEQ_DOUBLE_DOUBLE_PRECISION)
+    T shifted = x + step;       // ddouble has no extended precision registers to spill
+#else
+    volatile T shifted = x + step;
+#endif
+
+    return shifted - x;
+}
+
+
+/**
+ * @brief Column j (1 <= j <= m) of the Jacobian df/dy by a forward difference,
+ * given f0 = f(y). Costs one right hand side evaluation.
+ *
+ * @tparam T
+ * @param ode
+ * @param y Values of the form (t, y_1, ..., y_m).
+ * @param f0
+ * @param j
+ * @param col Result, one entry per equation.
+ */
+template <typename T>
+void _jacobianColumn(ODESystem<T>& ode, std::vector<T>& y, std::vector<T>& f0, size_t j, std::vector<T>& col)
+{
+    std::vector<T> inputs(y);
+    T step = _differenceStep(y[j]);
+    inputs[j] += step;
+
+    std::vector<T> f1 = ode._eval(inputs);
+
+    col.resize(f0.size());
+    for (size_t i = 0; i < f0.size(); i++)
+        col[i] = (f1[i] - f0[i]) / step;
+}
+
+
+/**
+ * @brief Columns of a group of the Jacobian df/dy by one forward difference
+ * along the sum of their steps, given f0 = f(y). The columns must not share a
+ * nonzero row, and only the rows of the system's sparsity pattern are written
+ * if it has one (all rows otherwise).
+ *
+ * @tparam T
+ * @param ode
+ * @param y Values of the form (t, y_1, ..., y_m).
+ * @param f0
+ * @param group Columns, 0 based.
+ * @param inputs Scratch copy of y, restored on return.
+ * @param J Result, entry (i, j) at J[i * stride + j + shift]: stride m and
+ * shift 0 for a row major m x m matrix, the band storage of linalg/banded.h
+ * for stride 2 kl + ku and shift kl.
+ * @param stride
+ * @param shift
+ */
+template <typename T>
+void _jacobianGroup(ODESystem<T>& ode, std::vector<T>& y, std::vector<T>& f0, const std::vector<size_t>& group,
+    std::vector<T>& inputs, std::vector<T>& J, size_t stride, size_t shift)
+{
+    size_t m = ode.getNumEquations();
+    std::vector<T> steps(group.size());
+
+    for (size_t k = 0; k < group.size(); k++)
+    {
+        steps[k] = _differenceStep(y[group[k] + 1]);
+        inputs[group[k] + 1] += steps[k];
+    }
+
+    std::vector<T> f1 = ode._eval(inputs);
+
+    for (size_t k = 0; k < group.size(); k++)
+    {
+        size_t j = group[k];
+
+        if (ode.hasSparsity())
+            for (size_t i : ode.getSparsity().columns[j])
+                J[i * stride + j + shift] = (f1[i] - f0[i]) / steps[k];
+        else
+            for (size_t i = 0; i < m; i++)
+                J[i * stride + j + shift] = (f1[i] - f0[i]) / steps[k];
+
+        inputs[j + 1] = y[j + 1];
+    }
+}
+
+
+/**
+ * @brief Column groups of a finite difference Jacobian: the colors of the
+ * system's sparsity pattern, or every column on its own.
+ *
+ * @tparam T
+ * @param ode
+ * @return std::vector<std::vector<size_t>>
+ */
+template <typename T>
+std::vector<std::vector<size_t>> _jacobianGroups(ODESystem<T>& ode)
+{
+    if (ode.hasSparsity())
+        return ode.getSparsity().groups;
+
+    std::vector<std::vector<size_t>> groups(ode.getNumEquations());
+    for (size_t j = 0; j < groups.size(); j++)
+        groups[j].push_back(j);
+
+    return groups;
+}
+
+
+/**
+ * @brief Jacobian df/dy of the whole system, stored row major, 
+ * J[i * m + j] = df_(i+1)/dy_(j+1). Uses the system's Jacobian if it has one,
+ * and otherwise forward differences, which cost m right hand side evaluations,
+ * or one per color if the system has a sparsity pattern.
+ *
+ * @tparam T
+ * @param ode
+ * @param y
+ * @param f0 f(y), which is reused.
+ * @param J
+ */
+template <typename T>
+void _jacobian(ODESystem<T>& ode, std::vector<T>& y, std::vector<T>& f0, std::vector<T>& J)
+{
+    size_t m = ode.getNumEquations();
+
+    if (ode.hasJacobian())
+    {
+        ode._evalJacobian(y, J);
+        return;
+    }
+
+    J.assign(m * m, 0);
+
+    std::vector<T> inputs(y);
+    for (const std::vector<size_t>& group : _jacobianGroups(ode))
+        _jacobianGroup(ode, y, f0, group, inputs, J, m, 0);
+}
+
+
+/**
+ * @brief Jacobian df/dy in the band storage of linalg/banded.h, for kl
+ * subdiagonals and ku superdiagonals, with the fill-in columns zero. A Jacobian
+ * set on the system is evaluated as a full matrix first; otherwise the system
+ * needs a sparsity pattern within the band, whose colors are differenced.
+ *
+ * @tparam T
+ * @param ode
+ * @param y
+ * @param f0 f(y), which is reused.
+ * @param kl
+ * @param ku
+ * @param J
+ */
+template <typename T>
+void _jacobianBand(ODESystem<T>& ode, std::vector<T>& y, std::vector<T>& f0, size_t kl, size_t ku, std::vector<T>& J)
+{
+    size_t m = ode.getNumEquations();
+    size_t w = _bandWidth(kl, ku);
+
+    J.assign(m * w, 0);
+
+    if (ode.hasJacobian())
+    {
+        std::vector<T> full;
+        ode._evalJacobian(y, full);
+
+        for (size_t i = 0; i < m; i++)
+            for (size_t j = i > kl ? i - kl : 0; j <= i + ku && j < m; j++)
+                J[i * w + j + kl - i] = full[i * m + j];
+        return;
+    }
+
+    std::vector<T> inputs(y);
+    for (const std::vector<size_t>& group : _jacobianGroups(ode))
+        _jacobianGroup(ode, y, f0, group, inputs, J, w - 1, kl);
+}
+
+
+/**
+ * @brief Finite difference Jacobian of a system whose column perturbations are
+ * spread over a thread pool, to be set with setJacobian when the right hand
+ * side can only be evaluated (no autodiffJacobian). Every column gets a step
+ * scaled to its own component, and if the system has a sparsity pattern the
+ * colors are evaluated instead of the columns. The groups are split in one
+ * contiguous block per thread, each with its own copy of the state.
+ *
+ * The right hand side is called from several threads at once and must be
+ * thread safe. The system is copied as it is, so its sparsity pattern should
+ * be set before, and the pool must outlive the returned function and not be
+ * the one running the solve.
+ *
+ * @tparam T
+ * @param ode
+ * @param pool
+ * @return jacobianFunction_t<T>
+ */
+template <typename T>
+jacobianFunction_t<T> parallelJacobian(ODESystem<T>& ode, ThreadPool& pool)
+{
+    ODESystem<T> system(ode);
+    std::vector<std::vector<size_t>> groups = _jacobianGroups(system);
+
+    return jacobianFunction_t<T>([system, groups, &pool](const std::vector<T>& args, std::vector<T>& J) mutable {
+        size_t m = system.getNumEquations();
+        std::vector<T> y(args);
+        std::vector<T> f0 = system._eval(y);
+
+        J.assign(m * m, 0);
+
+        size_t blocks = pool.size() < groups.size() ? pool.size() : groups.size();
+        pool.parallelFor(0, blocks, [&](size_t b) {
+            std::vector<T> inputs(y);
+            for (size_t g = b * groups.size() / blocks; g < (b + 1) * groups.size() / blocks; g++)
+                _jacobianGroup(system, y, f0, groups[g], inputs, J, m, 0);
+        });
+    });
+}
+
+
+/**
+ * @brief Jacobian-vector product (df/dy) v, from the system's product if it has
+ * one, else from a forward difference along v (one right hand side evaluation).
+ * A Jacobian set on the system is not used, since evaluating it would cost far
+ * more than the product in the matrix free solves that call this.
+ *
+ * @tparam T
+ * @param ode
+ * @param y Values of the form (t, y_1, ..., y_m).
+ * @param f0 f(y), which is reused.
+ * @param v Direction, one entry per equation.
+ * @param out
+ */
+template <typename T>
+void _jacobianVectorProduct(ODESystem<T>& ode, std::vector<T>& y, std::vector<T>& f0, const std::vector<T>& v, std::vector<T>& out)
+{
+    size_t m = ode.getNumEquations();
+    out.resize(m);
+
+    if (ode.hasJacobianVectorProduct())
+    {
+        ode._evalJVP(y, v, out);
+        return;
+    }
+
+    // step relative to the size of the point and of the direction
+    T yNorm = 0, vNorm = 0;
+    for (size_t i = 0; i < m; i++)
+    {
+        yNorm = _CONTROL_ABS(y[i + 1]) > yNorm ? _CONTROL_ABS(y[i + 1]) : yNorm;
+        vNorm = _CONTROL_ABS(v[i]) > vNorm ? _CONTROL_ABS(v[i]) : vNorm;
+    }
+
+    if (vNorm == 0)
+    {
+        out.assign(m, 0);
+        return;
+    }
+
+    T eps = _CONTROL_SQRT(std::numeric_limits<T>::epsilon()) * (yNorm > 1 ? yNorm : 1) / vNorm;
+    std::vector<T> inputs(y);
+    for (size_t i = 0; i < m; i++)
+        inputs[i + 1] += eps * v[i];
+
+    std::vector<T> f1 = ode._eval(inputs);
+    for (size_t i = 0; i < m; i++)
+        out[i] = (f1[i] - f0[i]) / eps;
+}
+
+
+/**
+ * @brief Partial derivative df/dt by a forward difference, for non-autonomous
+ * systems. Costs one right hand side evaluation.
+ *
+ * @tparam T
+ * @param ode
+ * @param y
+ * @param f0
+ * @return std::vector<T>
+ */
+template <typename T>
+std::vector<T> _timeDerivative(ODESystem<T>& ode, std::vector<T>& y, std::vector<T>& f0)
+{
+    std::vector<T> col;
+    _jacobianColumn(ode, y, f0, 0, col);
+
+    return col;
+}
+
+
+} // namespace DES
+
+
+#endif
@@ -0,0 +1,187 @@
+#ifndef DIFFEQ_ALGORITHMS_MRI_H
+#define DIFFEQ_ALGORITHMS_MRI_H
+
+#include <cmath>
+
+#include "../multirate.h"
+#include "rk.h"
+#include "tableau.h"
+
+
+// Multirate infinitesimal GARK methods, see Sandu, "A class of multirate
+// infinitesimal GARK methods" (SIAM J. Numer. Anal., 2019).
+
+
+namespace DES
+{
+
+#if defined(DIFFEQ_FLOAT_PRECISION)
+    #define  _MRI_ENTRY(a, b)           MRI_GARK22_TABF[a][b]
+    #define  _MRI_CEIL(a)               ceilf(a)
+#elif defined(DIFFEQ_DOUBLE_PRECISION)
+    #define  _MRI_ENTRY(a, b)           MRI_GARK22_TAB[a][b]
+    #define  _MRI_CEIL(a)               ceil(a)
+#elif defined(DIFFEQ_LONG_DOUBLE_PRECISION)
+    #define  _MRI_ENTRY(a, b)           MRI_GARK22_TABL[a][b]
+    #define  _MRI_CEIL(a)               ceill(a)
+#elif defined(DIFFEQ_DOUBLE_DOUBLE_PRECISION)
+    #define  _MRI_ENTRY(a, b)           MRI_GARK22_TABDD[a][b]
+    #define  _MRI_CEIL(a)               ceil(a)
+#else
+    #define  _MRI_ENTRY(a, b)           (T)(MRI_GARK22_TAB[a][b])
+    #define  _MRI_CEIL(a)               (T)ceil(a)
+#endif
+
+
+/**
+ * @brief Integrate the fast group over [t, t + H] with RK4, starting at inputs
+ * (of the form (t, y_1, ..., y_m)), while the slow group only contributes the
+ * constant forcing term. The number of substeps is chosen so that the fast
+ * timestep is never exceeded. The result is written back to inputs.
+ *
+ * @tparam T
+ * @param ode
+ * @param inputs
+ * @param forcing Slow contribution, one entry per equation.
+ * @param H Length of the stage interval.
+ */
+template <typename T>
+void _MRI_fastSolve(MultirateODESystem<T>& ode, std::vector<T>& inputs, std::vector<T>& forcing, T H)
+{
+    size_t m = ode.getNumEquations();
+    size_t n = (size_t)_MRI_CEIL(H / ode.getFastTimeStep());
+    if (n == 0) n = 1;
+
+    T h = H / n;
+    std::vector<T> stage(m + 1);
+
+    for (size_t step = 0; step < n; step++)
+    {
+        std::vector<T> k_1j, k_2j, k_3j, k_4j;
+
+        k_1j = ode._evalFast(inputs);
+
+        stage[0] = inputs[0] + h / 2;
+        _LOOP_TO_M(i, 1)
+            stage[i] = inputs[i] + h / 2 * (k_1j[i-1] + forcing[i-1]);
+
+        k_2j = ode._evalFast(stage);
+
+        _LOOP_TO_M(i, 1)
+            stage[i] = inputs[i] + h / 2 * (k_2j[i-1] + forcing[i-1]);
+
+        k_3j = ode._evalFast(stage);
+
+        stage[0] = inputs[0] + h;
+        _LOOP_TO_M(i, 1)
+            stage[i] = inputs[i] + h * (k_3j[i-1] + forcing[i-1]);
+
+        k_4j = ode._evalFast(stage);
+
+        inputs[0] += h;
+        _LOOP_TO_M(i, 1)
+            inputs[i] += h * ((k_1j[i-1] + 2 * k_2j[i-1] + 2 * k_3j[i-1] + k_4j[i-1]) / 6 + forcing[i-1]);
+    }
+}
+
+
+/**
+ * @brief Take one slow step of length H with MRI-GARK-ERK22a, in place. Each
+ * stage solves the modified fast problem v' = f_fast(t, v) + (1/dc) * sum_j
+ * gamma_ij * f_slow(Y_j) over [c_(i-1) H, c_i H], so the slow group is only
+ * evaluated once per stage (twice per slow step).
+ *
+ * @tparam T
+ * @param ode
+ * @param inputs
+ * @param H
+ */
+template <typename T>
+void _MRIGARK22_step(MultirateODESystem<T>& ode, std::vector<T>& inputs, T H)
+{
+    using namespace ButcherTableau;
+
+    const size_t stages = 2;
+    size_t m = ode.getNumEquations();
+    T t = inputs[0];
+
+    std::vector<std::vector<T>> slow;
+    std::vector<T> forcing(m);
+
+    for (size_t s = 1; s <= stages; s++)
+    {
+        slow.push_back(ode._evalSlow(inputs));
+
+        T dc = _MRI_ENTRY(s, 0) - _MRI_ENTRY(s - 1, 0);
+        for (size_t i = 0; i < m; i++)
+        {
+            forcing[i] = 0;
+            for (size_t j = 1; j <= s; j++)
+                forcing[i] += _MRI_ENTRY(s, j) * slow[j-1][i];
+        }
+
+        if (dc == 0)
+        {
+            // degenerate stage, the fast group does not move
+            _LOOP_TO_M(i, 1)
+                inputs[i] += H * forcing[i-1];
+            continue;
+        }
+
+        for (size_t i = 0; i < m; i++)
+            forcing[i] /= dc;
+
+        _MRI_fastSolve(ode, inputs, forcing, dc * H);
+    }
+
+    inputs[0] = t + H;
+}
+
+
+
+template <typename T>
+DataFrame<T> _MRIGARK22(MultirateODESystem<T>& ode)
+{
+    timeBound_t<T> tBound = ode.getTimeBound();
+
+    size_t m = ode.getNumEquations();
+    size_t row = 0;
+
+    T H = ode.getSlowTimeStep();
+    T t = tBound.first;
+
+    DataFrame<T> res(0, m + 1);
+    res.addRow(ode.getInitialConditions().vec);
+
+    do
+    {
+        std::vector<T> result(res.getRow(row));
+
+        _MRIGARK22_step(ode, result, H);
+        result[0] = t + H;
+
+        res.addRow(result);
+
+        row++;
+        t += H;
+
+    } while (t < tBound.second);
+
+    return res;
+}
+
+
+
+template <typename T>
+std::vector<T> _MRIGARK22_i(MultirateODESystem<T>& ode)
+{
+    _MRIGARK22_step(ode, ode.lastValues, ode.getSlowTimeStep());
+
+    return std::vector<T>(ode.lastValues);
+}
+
+
+} // namespace DES
+
+
+#endif
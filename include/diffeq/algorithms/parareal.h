@@ -0,0 +1,252 @@
+#ifndef DIFFEQ_ALGORITHMS_PARAREAL_H
+#define DIFFEQ_ALGORITHMS_PARAREAL_H
+
+#include <cmath>
+#include <functional>
+#include <vector>
+
+#include "../ode.h"
+#include "../threadpool.h"
+#include "control.h"
+#include "rk.h"
+#include "rosenbrock.h"
+
+
+namespace DES
+{
+
+/**
+ * @brief Integrator for one time slice of a Parareal solve. It receives a copy of
+ * the system whose initial conditions and time bounds are set to the slice, and
+ * returns the solution on the slice, the last row of which must be the state at
+ * the end of the slice. It is called from several threads at once, so the right
+ * hand side must be safe to evaluate concurrently.
+ *
+ * @tparam T
+ */
+template <typename T>
+struct propagator_t
+{
+    std::function<DataFrame<T>(ODESystem<T>&)> _func;
+
+    propagator_t(std::function<DataFrame<T>(ODESystem<T>&)> func) {
+        _func = func;
+    }
+
+
+    /**
+     * @brief Fixed step method with (at most) the given step. The step is
+     * shortened so that a whole number of steps covers the slice, and the
+     * method is stopped half a step before the slice end, so that it takes
+     * exactly that many steps whatever the rounding of the time. The last row is
+     * then at the slice end.
+     *
+     * @param alg
+     * @param timeStep
+     */
+    propagator_t(algorithm_t alg, T timeStep)
+    {
+        _func = [alg, timeStep](ODESystem<T>& ode) {
+            using std::ceil;
+
+            timeBound_t<T> b = ode.getTimeBound();
+            size_t steps = (size_t)ceil((b.second - b.first) / timeStep);
+            steps = steps > 0 ? steps : 1;
+
+            T h = (b.second - b.first) / (T)steps;
+            ode.setTimeStep(h);
+            ode.setTimeBound(timeBound_t<T>(b.first, b.second - h / 2));
+
+            DataFrame<T> res = solve(ode, alg);
+            std::vector<T> end = res.getRow(res.getNumRows() - 1);
+            end[0] = b.second;
+
+            DataFrame<T> slice(0, end.size());
+            for (size_t r = 0; r + 1 < res.getNumRows(); r++)
+                slice.addRow(res.getRow(r));
+            slice.addRow(end);
+
+            return slice;
+        };
+    }
+
+
+    /**
+     * @brief Adaptive method with the given options. Output times that fall in
+     * the slice are kept, and the end of the slice is always stored.
+     *
+     * @param alg
+     * @param options
+     */
+    propagator_t(algorithm_t alg, options_t<T> options)
+    {
+        _func = [alg, options](ODESystem<T>& ode) {
+            timeBound_t<T> b = ode.getTimeBound();
+            options_t<T> slice(options);
+
+            if (!options.saveat.empty())
+            {
+                slice.saveat.clear();
+                for (T s : options.saveat)
+                    if (s >= b.first && s < b.second)
+                        slice.saveat.push_back(s);
+                slice.saveat.push_back(b.second);
+            }
+
+            return solve(ode, alg, slice);
+        };
+    }
+
+    DataFrame<T> operator()(ODESystem<T>& ode)
+    {
+        return _func(ode);
+    }
+};
+
+
+/**
+ * @brief Options for parareal. The time interval is split into equal slices, and
+ * iteration stops when no slice boundary moves by more than the tolerance
+ * (in the weighted RMS norm of the adaptive methods), or after maxIterations
+ * (at most slices, after which the result equals the serial fine solve).
+ *
+ * @tparam T
+ */
+template <typename T>
+struct pararealOptions_t
+{
+    size_t slices;
+    tolerance_t<T> tolerance;
+    size_t maxIterations = 0;       // 0 means slices
+
+    pararealOptions_t(size_t n)                         : slices(n) { }
+    pararealOptions_t(size_t n, tolerance_t<T> tol)     : slices(n), tolerance(tol) { }
+};
+
+
+/**
+ * @brief Parallel-in-time integration with Parareal (Lions, Maday and Turinici,
+ * 2001). The coarse propagator G sweeps serially over the slices, and the fine
+ * propagator F runs on all slices at once. Iteration k updates the slice
+ * boundaries with U_(n+1) = G(U_n^k) + F(U_n^(k-1)) - G(U_n^(k-1)). After k
+ * iterations the first k slices are exact, so only the slices that have not
+ * converged are refined again.
+ *
+ * @tparam T
+ * @param ode
+ * @param coarse Cheap propagator, e.g. RK4 with a large step.
+ * @param fine Accurate propagator.
+ * @param options
+ * @param pool Threads to run the fine propagator on.
+ * @return DataFrame<T> Fine solution of the last iteration, concatenated over the
+ * slices.
+ */
+template <typename T>
+DataFrame<T> parareal(ODESystem<T>& ode, propagator_t<T> coarse, propagator_t<T> fine, pararealOptions_t<T> options, ThreadPool& pool)
+{
+    timeBound_t<T> tBound = ode.getTimeBound();
+    tolerance_t<T>& tol = options.tolerance;
+
+    size_t m = ode.getNumEquations();
+    size_t N = options.slices;
+    size_t maxIterations = options.maxIterations == 0 || options.maxIterations > N ? N : options.maxIterations;
+
+    if (N == 0)
+        throw std::invalid_argument("Parareal needs at least one slice");
+
+    std::vector<T> times(N + 1);
+    for (size_t n = 0; n <= N; n++)
+        times[n] = tBound.first + (tBound.second - tBound.first) * n / N;
+    times[N] = tBound.second;
+
+    // each slice integrates its own copy, so threads share nothing but the functions
+    auto propagate = [&](propagator_t<T>& prop, std::vector<T>& y0, size_t n) {
+        ODESystem<T> slice(ode);
+        std::vector<T> y(y0);
+        y[0] = times[n];
+
+        slice.setInitialConditions(iv_t<T>(y));
+        slice.setTimeBound(timeBound_t<T>(times[n], times[n + 1]));
+
+        return prop(slice);
+    };
+
+    auto last = [](DataFrame<T> frame) {
+        return frame.getRow(frame.getNumRows() - 1);
+    };
+
+    std::vector<std::vector<T>> U(N + 1), G(N + 1);
+    std::vector<DataFrame<T>> F(N, DataFrame<T>(0, m + 1));
+
+    U[0] = ode.getInitialConditions().vec;
+    for (size_t n = 0; n < N; n++)
+    {
+        G[n + 1] = last(propagate(coarse, U[n], n));
+        U[n + 1] = G[n + 1];
+    }
+
+    size_t converged = 0;      // slices before this one are exact
+    for (size_t k = 0; k < maxIterations && converged < N; k++)
+    {
+        pool.parallelFor(converged, N, [&](size_t n) {
+            F[n] = propagate(fine, U[n], n);
+        });
+
+        // the first slice that was refined started from an exact value, so it
+        // is exact now, and the others are corrected with the coarse sweep
+        T change = 0;
+        for (size_t n = converged; n < N; n++)
+        {
+            std::vector<T> next = last(F[n]);
+
+            if (n > converged)
+            {
+                std::vector<T> g = last(propagate(coarse, U[n], n));
+                for (size_t i = 1; i <= m; i++)
+                    next[i] += g[i] - G[n + 1][i];
+
+                G[n + 1] = g;
+            }
+
+            std::vector<T> diff(m + 1);
+            for (size_t i = 1; i <= m; i++)
+                diff[i] = next[i] - U[n + 1][i];
+
+            T R = _errorNorm(diff, U[n + 1], next, tol);
+            change = R > change ? R : change;
+
+            U[n + 1] = next;
+        }
+
+        converged++;
+
+        if (change <= 1)
+            break;
+    }
+
+    // slices that were never refined again still hold their last fine solve
+    DataFrame<T> res(0, m + 1);
+    for (size_t n = 0; n < N; n++)
+        for (size_t r = 0; r < F[n].getNumRows(); r++)
+        {
+            std::vector<T> row = F[n].getRow(r);
+            if (res.getNumRows() == 0 || row[0] > res.getRow(res.getNumRows() - 1)[0])
+                res.addRow(row);
+        }
+
+    return res;
+}
+
+
+template <typename T>
+DataFrame<T> parareal(ODESystem<T>& ode, propagator_t<T> coarse, propagator_t<T> fine, pararealOptions_t<T> options)
+{
+    ThreadPool pool(options.slices < std::thread::hardware_concurrency() ? options.slices : 0);
+    return parareal(ode, coarse, fine, options, pool);
+}
+
+
+} // namespace DES
+
+
+#endif
@@ -4,6 +4,10 @@
 #include <cmath>
 
 #include "../ode.h"
+#include "control.h"
+#include "dense.h"
+#include "events.h"
+#include "summation.h"
 #include "tableau.h"
 
 
@@ -30,6 +34,10 @@ DataFrame<T> _EULER(ODESystem<T> & ode)
     DataFrame<T> res(0, m + 1);
     res.addRow(ode.getInitialConditions().vec);
 
+    // compensations of t and y, see summation.h
+    T tComp = 0;
+    std::vector<T> comp(m + 1, 0);
+
 
 #if defined(DIFFEQ_FLOAT_PRECISION)
     #define  _EULER_TIME(a, b)        EULER_TABF[b][0] - EULER_TABF[a][0]
@@ -40,6 +48,9 @@ DataFrame<T> _EULER(ODESystem<T> & ode)
 #elif defined(DIFFEQ_LONG_DOUBLE_PRECISION)
     #define  _EULER_TIME(a, b)        EULER_TABL[b][0] - EULER_TABL[a][0]
     #define  _EULER_UNIT(a, b)        EULER_TABL[a][b] * k_##b##j[i-1]
+#elif defined(DIFFEQ_DOUBLE_DOUBLE_PRECISION)
+    #define  _EULER_TIME(a, b)        EULER_TABDD[b][0] - EULER_TABDD[a][0]
+    #define  _EULER_UNIT(a, b)        EULER_TABDD[a][b] * k_##b##j[i-1]
 #else 
     #define  _EULER_TIME(a, b)        (T)(EULER_TAB[b][0]) - (T)(EULER_TAB[b][0])
     #define  _EULER_UNIT(a, b)        (T)(EULER_TAB[a][b] * k_##b##j[i-1])
@@ -54,15 +65,15 @@ DataFrame<T> _EULER(ODESystem<T> & ode)
         k_1j = ode._eval(inputs);
         
         std::vector<T> result(res.getRow(row));
-        result[0] = t + h;
+        _accumulate(t, tComp, h);
+        result[0] = t;
 
         _LOOP_TO_M(i, 1)
-            result[i] += h * (_EULER_UNIT(1, 1));
+            _accumulate(result[i], comp[i], h * (_EULER_UNIT(1, 1)));
 
         res.addRow(result);
         
         row++;
-        t += h;
         
     } while (t < tBound.second);
 
@@ -82,6 +93,7 @@ DataFrame<T> _RK4(ODE<T>& ode)
     res.addRow(ode.getInitialCondition().vec);
 
     size_t row = 0;
+    T tComp = 0, comp = 0;
     
     do
     {
@@ -105,13 +117,13 @@ DataFrame<T> _RK4(ODE<T>& ode)
         k_4 = ode._eval(inputs);
         
         std::vector<T> result(res.getRow(row));
-        result[0] += h;
-        result[1] += h * (k_1 + 2 * k_2 + 2 * k_3 + k_4) / 6;
+        _accumulate(t, tComp, h);
+        result[0] = t;
+        _accumulate(result[1], comp, h * (k_1 + 2 * k_2 + 2 * k_3 + k_4) / 6);
 
         res.addRow(result);
         
         row++;
-        t += h;
         
     } while (t < tBound.second);
 
@@ -134,6 +146,9 @@ DataFrame<T> _RK4(ODESystem<T>& ode)
     DataFrame<T> res(0, m + 1);
     res.addRow(ode.getInitialConditions().vec);
 
+    T tComp = 0;
+    std::vector<T> comp(m + 1, 0);
+
 
 #if defined(DIFFEQ_FLOAT_PRECISION)
     #define  _RK4_TIME(a, b)        RK4_TABF[b][0] - RK4_TABF[a][0]
@@ -144,6 +159,9 @@ DataFrame<T> _RK4(ODESystem<T>& ode)
 #elif defined(DIFFEQ_LONG_DOUBLE_PRECISION)
     #define  _RK4_TIME(a, b)        RK4_TABL[b][0] - RK4_TABL[a][0]
     #define  _RK4_UNIT(a, b)        RK4_TABL[a][b] * k_##b##j[i-1]
+#elif defined(DIFFEQ_DOUBLE_DOUBLE_PRECISION)
+    #define  _RK4_TIME(a, b)        RK4_TABDD[b][0] - RK4_TABDD[a][0]
+    #define  _RK4_UNIT(a, b)        RK4_TABDD[a][b] * k_##b##j[i-1]
 #else 
     #define  _RK4_TIME(a, b)        (T)(RK4_TAB[b][0]) - (T)(RK4_TAB[b][0])
     #define  _RK4_UNIT(a, b)        (T)(RK4_TAB[a][b] * k_##b##j[i-1])
@@ -177,20 +195,20 @@ DataFrame<T> _RK4(ODESystem<T>& ode)
         k_4j = ode._eval(inputs);
         
         std::vector<T> result(res.getRow(row));
-        result[0] = t + h;
+        _accumulate(t, tComp, h);
+        result[0] = t;
 
         _LOOP_TO_M(i, 1)
-            result[i] += h * (
+            _accumulate(result[i], comp[i], h * (
                   _RK4_UNIT(4, 1)
                 + _RK4_UNIT(4, 2)
                 + _RK4_UNIT(4, 3)
                 + _RK4_UNIT(4, 4)
-            );
+            ));
 
         res.addRow(result);
         
         row++;
-        t += h;
         
     } while (t < tBound.second);
 
@@ -222,9 +240,10 @@ std::vector<T> _RK4_i(ODE<T>& ode)
     inputs[1] += h * (k_3 - k_2 / 2);
 
     k_4 = ode._eval(inputs);
-        
-    ode.lastValues[0] += h;
-    ode.lastValues[1] += h * (k_1 + 2 * k_2 + 2 * k_3 + k_4) / 6;
+
+    ode.lastCompensation.resize(2, 0);
+    _accumulate(ode.lastValues[0], ode.lastCompensation[0], h);
+    _accumulate(ode.lastValues[1], ode.lastCompensation[1], h * (k_1 + 2 * k_2 + 2 * k_3 + k_4) / 6);
 
     return std::vector<T>(ode.lastValues);
 }
@@ -235,7 +254,7 @@ template <typename T>
 std::vector<T> _RK4_i(ODESystem<T>& ode) 
 {
     T h = ode.getTimeStep();
-    T m = ode.getNumEquations();
+    size_t m = ode.getNumEquations();
 
 #if defined(DIFFEQ_FLOAT_PRECISION)
     #define  _RK4_TIME(a, b)        RK4_TABF[b][0] - RK4_TABF[a][0]
@@ -246,6 +265,9 @@ std::vector<T> _RK4_i(ODESystem<T>& ode)
 #elif defined(DIFFEQ_LONG_DOUBLE_PRECISION)
     #define  _RK4_TIME(a, b)        RK4_TABL[b][0] - RK4_TABL[a][0]
     #define  _RK4_UNIT(a, b)        RK4_TABL[a][b] * k_##b##j[i-1]
+#elif defined(DIFFEQ_DOUBLE_DOUBLE_PRECISION)
+    #define  _RK4_TIME(a, b)        RK4_TABDD[b][0] - RK4_TABDD[a][0]
+    #define  _RK4_UNIT(a, b)        RK4_TABDD[a][b] * k_##b##j[i-1]
 #else 
     #define  _RK4_TIME(a, b)        (T)(RK4_TAB[b][0]) - (T)(RK4_TAB[b][0])
     #define  _RK4_UNIT(a, b)        (T)(RK4_TAB[a][b] * k_##b##j[i-1])
@@ -275,112 +297,62 @@ std::vector<T> _RK4_i(ODESystem<T>& ode)
             - _RK4_UNIT(2, 1) - _RK4_UNIT(2, 2)));
 
     k_4j = ode._eval(inputs);
-    
-    ode.lastValues[0] += h;
+
+    std::vector<T>& comp = ode.lastCompensation;
+    comp.resize(m + 1, 0);
+
+    _accumulate(ode.lastValues[0], comp[0], h);
 
     _LOOP_TO_M(i, 1)
-        ode.lastValues[i] += h * (
+        _accumulate(ode.lastValues[i], comp[i], h * (
               _RK4_UNIT(4, 1)
             + _RK4_UNIT(4, 2)
             + _RK4_UNIT(4, 3)
             + _RK4_UNIT(4, 4)
-        );
+        ));
 
     return std::vector<T>(ode.lastValues);
 }
 
 
 
+/**
+ * @brief Solve a single ODE with RKF45. The equation is wrapped in a one 
+ * equation ODESystem so that both share the same error control.
+ * 
+ * @tparam T 
+ * @param ode 
+ * @param options 
+ * @return DataFrame<T> 
+ */
 template <typename T>
-DataFrame<T> _RKF45(ODE<T>& ode, T maxError) 
+DataFrame<T> _RKF45(ODE<T>& ode, options_t<T> options) 
 {
-    timeBound_t<T> tBound = ode.getTimeBound();
-    T h = ode.getTimeStep();
-    T t = tBound.first;
-
-    DataFrame<T> res(0, 2);
-    res.addRow(ode.getInitialCondition().vec);
-
-    size_t row = 0;
-
-#if defined(DIFFEQ_FLOAT_PRECISION)
-    #define  _RKF45_ENTRY(a, b)         RKF45_TABF[a][b]
-    #define  _RKF45_POW(a, b)           powf(a, b)
-#elif defined(DIFFEQ_DOUBLE_PRECISION)
-    #define  _RKF45_ENTRY(a, b)         RKF45_TAB[a][b]  
-    #define  _RKF45_POW(a, b)           pow(a, b)
-#elif defined(DIFFEQ_LONG_DOUBLE_PRECISION)
-    #define  _RKF45_ENTRY(a, b)         RKF45_TABL[a][b]
-    #define  _RKF45_POW(a, b)           powl(a, b)
-#else 
-    #define  _RKF45_ENTRY(a, b)         (T)(RKF45_TAB[a][b])
-    #define  _RKF45_POW(a, b)           (T)pow(a, b)
-#endif
-
-
-    using namespace ButcherTableau;
-    while (t < tBound.second)
-    {
-        // h = _MIN(h, tBound.second - t); // ensure that the last entry stops when h exceeds the upper bound
-        T k_1, k_2, k_3, k_4, k_5, k_6;
-        std::vector<T> inputs(res.getRow(row));
-
-        k_1 = ode._eval(inputs);
-
-        inputs[0] += h * _RKF45_ENTRY(1, 0);
-        inputs[1] += h * _RKF45_ENTRY(1, 1) * k_1;
-
-        k_2 = ode._eval(inputs);
+    function_t<T> func([&ode](std::vector<T> args) {
+        return ode._eval(args);
+    });
 
-        inputs[0] += h * (_RKF45_ENTRY(2, 0) - _RKF45_ENTRY(1, 0));
-        inputs[1] += h * (_RKF45_ENTRY(2, 1) * k_1 + _RKF45_ENTRY(2, 2) * k_2 
-            - _RKF45_ENTRY(1, 1) * k_1);
-
-        k_3 = ode._eval(inputs);
-
-        inputs[0] += h * (_RKF45_ENTRY(3, 0) - _RKF45_ENTRY(2, 0));
-        inputs[1] += h * (_RKF45_ENTRY(3, 1) * k_1 + _RKF45_ENTRY(3, 2) * k_2 + _RKF45_ENTRY(3, 3) * k_3
-            - _RKF45_ENTRY(2, 1) * k_1 - _RKF45_ENTRY(2, 2) * k_2);
-
-        k_4 = ode._eval(inputs);
-
-        inputs[0] += h * (_RKF45_ENTRY(4, 0) - _RKF45_ENTRY(3, 0));
-        inputs[1] += h * (_RKF45_ENTRY(4, 1) * k_1 + _RKF45_ENTRY(4, 2) * k_2 + _RKF45_ENTRY(4, 3) * k_3 + _RKF45_ENTRY(4, 4) * k_4 
-            - _RKF45_ENTRY(3, 1) * k_1 - _RKF45_ENTRY(3, 2) * k_2 - _RKF45_ENTRY(3, 3) * k_3);
-
-        k_5 = ode._eval(inputs);
-
-        inputs[0] += h * (_RKF45_ENTRY(5, 0) - _RKF45_ENTRY(4, 0));
-        inputs[1] += h * (_RKF45_ENTRY(5, 1) * k_1 + _RKF45_ENTRY(5, 2) * k_2 + _RKF45_ENTRY(5, 3) * k_3 + _RKF45_ENTRY(5, 4) * k_4 + _RKF45_ENTRY(5, 5) * k_5
-            - _RKF45_ENTRY(4, 1) * k_1 - _RKF45_ENTRY(4, 2) * k_2 - _RKF45_ENTRY(4, 3) * k_3 - _RKF45_ENTRY(4, 4) * k_4);
+    iv_t<T> iValues = ode.getInitialCondition();
+    timeBound_t<T> tBound = ode.getTimeBound();
+    ODESystem<T> system(iValues, { func }, tBound, ode.getTimeStep());
 
-        k_6 = ode._eval(inputs);
+    return _RKF45(system, options);
+}
 
-        std::vector<T> result(res.getRow(row));
-        
-        T w1 = result[1] + h * (_RKF45_ENTRY(6, 1) * k_1 + _RKF45_ENTRY(6, 2) * k_2 + _RKF45_ENTRY(6, 3) * k_3 + _RKF45_ENTRY(6, 4) * k_4 + _RKF45_ENTRY(6, 5) * k_5 + _RKF45_ENTRY(6, 6) * k_6);
-        T w2 = result[1] + h * (_RKF45_ENTRY(7, 1) * k_1 + _RKF45_ENTRY(7, 2) * k_2 + _RKF45_ENTRY(7, 3) * k_3 + _RKF45_ENTRY(7, 4) * k_4 + _RKF45_ENTRY(7, 5) * k_5 + _RKF45_ENTRY(7, 6) * k_6);
-        
-        T R = _ABS(w2 - w1) / h;
-        T delta = 0.84 * _RKF45_POW(maxError / R, 0.25);
 
-        if (R <= maxError) {
-            result[0] += h;
-            result[1] = w1;
-            res.addRow(result);
 
-            h *= delta;
-            t += h;
-            row++;
-        
-        } else {
-            h *= delta;
-        }
+template <typename T>
+DataFrame<T> _RKF45(ODE<T>& ode, tolerance_t<T> tol) 
+{
+    return _RKF45(ode, options_t<T>(tol));
+}
 
-    }
 
-    return res;
 
+template <typename T>
+DataFrame<T> _RKF45(ODE<T>& ode, T maxError) 
+{
+    return _RKF45(ode, tolerance_t<T>(maxError));
 }
 
 
@@ -388,134 +360,226 @@ DataFrame<T> _RKF45(ODE<T>& ode, T maxError)
 template <typename T>
 DataFrame<T> _RKF45(ODE<T>& ode) 
 {
-    return _RKF45(ode, (T)DEFAULT_MAX_ERROR);
+    return _RKF45(ode, tolerance_t<T>());
 }
 
 
 
+/**
+ * @brief Take one RKF45 step of size h from result (of the form (t, y_1, ..., 
+ * y_m)), given the derivative k_1j at that point. The fourth order solution is
+ * written to w1 (with its time entry set), and the difference to the fifth 
+ * order solution, which is used as the error estimate, to err.
+ * 
+ * @tparam T 
+ * @param ode 
+ * @param result 
+ * @param k_1j 
+ * @param h 
+ * @param w1 
+ * @param err 
+ * @param comp Compensation of result, updated to that of w1 (see summation.h);
+ * may be null.
+ */
 template <typename T>
-DataFrame<T> _RKF45(ODESystem<T>& ode, T maxError) 
+void _RKF45_step(ODESystem<T>& ode, std::vector<T>& result, std::vector<T>& k_1j, T h, std::vector<T>& w1, std::vector<T>& err,
+    std::vector<T>* comp = nullptr)
 {
-    timeBound_t<T> tBound = ode.getTimeBound();
-
     size_t m = ode.getNumEquations();
-    size_t row = 0;
-
-    T h = ode.getTimeStep();
-    T t = tBound.first;
-
-    DataFrame<T> res(0, m + 1);
-    res.addRow(ode.getInitialConditions().vec);
-
 
 #if defined(DIFFEQ_FLOAT_PRECISION)
     #define  _RKF45_TIME(a, b)        RKF45_TABF[b][0] - RKF45_TABF[a][0]
     #define  _RKF45_UNIT(a, b)        RKF45_TABF[a][b] * k_##b##j[i-1]
-    #define  _RKF45_SQRT(a)           sqrtf(a)
-    #define  _RKF45_POW(a, b)         powf(a, b)
 #elif defined(DIFFEQ_DOUBLE_PRECISION)
     #define  _RKF45_TIME(a, b)        RKF45_TAB[b][0]  - RKF45_TAB[a][0]
     #define  _RKF45_UNIT(a, b)        RKF45_TAB[a][b]  * k_##b##j[i-1] 
-    #define  _RKF45_SQRT(a)           sqrt(a)
-    #define  _RKF45_POW(a, b)         pow(a, b)
 #elif defined(DIFFEQ_LONG_DOUBLE_PRECISION)
     #define  _RKF45_TIME(a, b)        RKF45_TABL[b][0] - RKF45_TABL[a][0]
     #define  _RKF45_UNIT(a, b)        RKF45_TABL[a][b] * k_##b##j[i-1]
-    #define  _RKF45_SQRT(a)           sqrtl(a)
-    #define  _RKF45_POW(a, b)         powl(a, b)
+#elif defined(DIFFEQ_DOUBLE_DOUBLE_PRECISION)
+    #define  _RKF45_TIME(a, b)        RKF45_TABDD[b][0] - RKF45_TABDD[a][0]
+    #define  _RKF45_UNIT(a, b)        RKF45_TABDD[a][b] * k_##b##j[i-1]
 #else 
     #define  _RKF45_TIME(a, b)        (T)(RKF45_TAB[b][0]) - (T)(RKF45_TAB[b][0])
     #define  _RKF45_UNIT(a, b)        (T)(RKF45_TAB[a][b] * k_##b##j[i-1])
-    #define  _RKF45_SQRT(a)           (T)sqrt(a)
-    #define  _RKF45_POW(a, b)         (T)pow(a, b)
 #endif
 
     using namespace ButcherTableau;
-    while (t < tBound.second)
-    {
-        std::vector<T> k_1j, k_2j, k_3j, k_4j, k_5j, k_6j;
-        std::vector<T> inputs(res.getRow(row));
+    std::vector<T> k_2j, k_3j, k_4j, k_5j, k_6j;
+    std::vector<T> inputs(result);
 
-        k_1j = ode._eval(inputs);
+    _LOOP_TO_M(i, 0)
+        inputs[i] += h * (i == 0 ? _RKF45_TIME(0, 1) : _RKF45_UNIT(1, 1));
+         
+    k_2j = ode._eval(inputs);
 
-        _LOOP_TO_M(i, 0)
-            inputs[i] += h * (i == 0 ? _RKF45_TIME(0, 1) : _RKF45_UNIT(1, 1));
-             
-        k_2j = ode._eval(inputs);
+    _LOOP_TO_M(i, 0)
+        inputs[i] += h * (i == 0 ? _RKF45_TIME(1, 2) : 
+            ( _RKF45_UNIT(2, 1) + _RKF45_UNIT(2, 2) 
+            - _RKF45_UNIT(1, 1)));
+    
+    k_3j = ode._eval(inputs);
 
-        _LOOP_TO_M(i, 0)
-            inputs[i] += h * (i == 0 ? _RKF45_TIME(1, 2) : 
-                ( _RKF45_UNIT(2, 1) + _RKF45_UNIT(2, 2) 
-                - _RKF45_UNIT(1, 1)));
-        
-        k_3j = ode._eval(inputs);
+    _LOOP_TO_M(i, 0)
+        inputs[i] += h * (i == 0 ? _RKF45_TIME(2, 3) :
+            ( _RKF45_UNIT(3, 1) + _RKF45_UNIT(3, 2) + _RKF45_UNIT(3, 3)
+            - _RKF45_UNIT(2, 1) - _RKF45_UNIT(2, 2)));
 
-        _LOOP_TO_M(i, 0)
-            inputs[i] += h * (i == 0 ? _RKF45_TIME(2, 3) :
-                ( _RKF45_UNIT(3, 1) + _RKF45_UNIT(3, 2) + _RKF45_UNIT(3, 3)
-                - _RKF45_UNIT(2, 1) - _RKF45_UNIT(2, 2)));
+    k_4j = ode._eval(inputs);
 
-        k_4j = ode._eval(inputs);
+    _LOOP_TO_M(i, 0)
+        inputs[i] += h * (i == 0 ? _RKF45_TIME(3, 4) : 
+            ( _RKF45_UNIT(4, 1) + _RKF45_UNIT(4, 2) + _RKF45_UNIT(4, 3) + _RKF45_UNIT(4, 4)
+            - _RKF45_UNIT(3, 1) - _RKF45_UNIT(3, 2) - _RKF45_UNIT(3, 3)));
 
-        _LOOP_TO_M(i, 0)
-            inputs[i] += h * (i == 0 ? _RKF45_TIME(3, 4) : 
-                ( _RKF45_UNIT(4, 1) + _RKF45_UNIT(4, 2) + _RKF45_UNIT(4, 3) + _RKF45_UNIT(4, 4)
-                - _RKF45_UNIT(3, 1) - _RKF45_UNIT(3, 2) - _RKF45_UNIT(3, 3)));
+    k_5j = ode._eval(inputs);
 
-        k_5j = ode._eval(inputs);
+    _LOOP_TO_M(i, 0)
+        inputs[i] += h * (i == 0 ? _RKF45_TIME(4, 5) : 
+            ( _RKF45_UNIT(5, 1) + _RKF45_UNIT(5, 2) + _RKF45_UNIT(5, 3) + _RKF45_UNIT(5, 4) + _RKF45_UNIT(5, 5)
+            - _RKF45_UNIT(4, 1) - _RKF45_UNIT(4, 2) - _RKF45_UNIT(4, 3) - _RKF45_UNIT(4, 4)));
+    
+    k_6j = ode._eval(inputs);
 
-        _LOOP_TO_M(i, 0)
-            inputs[i] += h * (i == 0 ? _RKF45_TIME(4, 5) : 
-                ( _RKF45_UNIT(5, 1) + _RKF45_UNIT(5, 2) + _RKF45_UNIT(5, 3) + _RKF45_UNIT(5, 4) + _RKF45_UNIT(5, 5)
-                - _RKF45_UNIT(4, 1) - _RKF45_UNIT(4, 2) - _RKF45_UNIT(4, 3) - _RKF45_UNIT(4, 4)));
+    std::vector<T> w2(m + 1);
+
+    _LOOP_TO_M(i, 1)
+    {
+        T dy = h * (
+              _RKF45_UNIT(6, 1)
+            + _RKF45_UNIT(6, 2)
+            + _RKF45_UNIT(6, 3)
+            + _RKF45_UNIT(6, 4)
+            + _RKF45_UNIT(6, 5)
+            + _RKF45_UNIT(6, 6)
+        );
+        w1[i] = result[i] + dy;
         
-        k_6j = ode._eval(inputs);
+        w2[i] = result[i] + h * (
+              _RKF45_UNIT(7, 1)
+            + _RKF45_UNIT(7, 2)
+            + _RKF45_UNIT(7, 3)
+            + _RKF45_UNIT(7, 4)
+            + _RKF45_UNIT(7, 5)
+            + _RKF45_UNIT(7, 6)
+        );
 
-        std::vector<T> result(res.getRow(row)), w1(m + 1), w2(m + 1);
-        T R = 0;    // calculate the error as the magnitude of the difference between w1 and w2
+        err[i] = w2[i] - w1[i];
 
-        _LOOP_TO_M(i, 1)
+        if (comp)
         {
-            w1[i] = result[i] + h * (
-                  _RKF45_UNIT(6, 1)
-                + _RKF45_UNIT(6, 2)
-                + _RKF45_UNIT(6, 3)
-                + _RKF45_UNIT(6, 4)
-                + _RKF45_UNIT(6, 5)
-                + _RKF45_UNIT(6, 6)
-            );
-            
-            w2[i] = result[i] + h * (
-                  _RKF45_UNIT(7, 1)
-                + _RKF45_UNIT(7, 2)
-                + _RKF45_UNIT(7, 3)
-                + _RKF45_UNIT(7, 4)
-                + _RKF45_UNIT(7, 5)
-                + _RKF45_UNIT(7, 6)
-            );
-
-            R += _ABS(w2[i] - w1[i]) * _ABS(w2[i] - w1[i]);
+            w1[i] = result[i];
+            _accumulate(w1[i], (*comp)[i], dy);
         }
+    }
+
+    w1[0] = result[0];
+    if (comp)
+        _accumulate(w1[0], (*comp)[0], h);
+    else
+        w1[0] += h;
+}
+
+
+
+template <typename T>
+DataFrame<T> _RKF45(ODESystem<T>& ode, options_t<T> options) 
+{
+    timeBound_t<T> tBound = ode.getTimeBound();
+    tolerance_t<T>& tol = options.tolerance;
+
+    size_t m = ode.getNumEquations();
+    size_t save = 0;
+
+    T h = ode.getTimeStep();
+    T t = tBound.first;
+
+    std::vector<T> y(ode.getInitialConditions().vec);
+    std::vector<T> k_1j = ode._eval(y);
+
+    DataFrame<T> res(0, m + 1);
+    if (options.saveat.empty())
+        res.addRow(y);
+
+    // output times before the first accepted step
+    for (; save < options.saveat.size() && options.saveat[save] <= t; save++)
+        if (options.saveat[save] == t)
+            res.addRow(y);
+
+    if (h <= 0)
+        h = _initialStep(ode, y, k_1j, (T)4, tol, tBound.second);
+
+    std::vector<T> g0 = _evalEvents(options.events, y);
+    std::vector<T> comp(m + 1, 0);
+
+    while (t < tBound.second)
+    {
+        if (options.maxStep > 0)
+            h = _MIN(h, options.maxStep);
+        h = _MIN(h, tBound.second - t);     // ensure that the last entry stops at the upper bound
+        std::vector<T> w1(m + 1), err(m + 1), c1(comp);
 
-        R = _RKF45_SQRT(R) / h;
-        T delta = 0.84 * _RKF45_POW(maxError / R, 0.25);
+        _RKF45_step(ode, y, k_1j, h, w1, err, &c1);
 
-        if (R <= maxError) 
+        T R = _errorNorm(err, y, w1, tol);
+        T delta = _stepFactor(R, (T)4);
+
+        if (R <= 1) 
         {
-            result[0] += h;
-            _LOOP_TO_M(i, 1) 
+            // FSAL: the derivative at the end of the step is the next k_1, and 
+            // doubles as the right endpoint of the interpolant
+            std::vector<T> f1 = ode._eval(w1);
+            std::vector<T> g1 = _evalEvents(options.events, w1);
+            denseStep_t<T> dense(y, w1, k_1j, f1);
+
+            bool restart = false;
+            for (std::pair<T, size_t>& hit : _findEvents(options.events, dense, g0, g1))
             {
-                result[i] = w1[i];
+                event_t<T>& ev = options.events[hit.second];
+                std::vector<T> yEvent = dense(hit.first);
+                std::vector<T> yAction(yEvent);
+
+                if (ev.action)
+                    ev.action(yAction);
+
+                // every event is in the output, with the state before its action
+                _saveDense(res, options.saveat, save, dense, hit.first);
+                res.addRow(yEvent);
+
+                if (ev.terminal)
+                    return res;
+
+                // an event that leaves the state alone is only recorded
+                if (yAction == yEvent)
+                    continue;
+
+                // the action changed the state, so the step is cut short and
+                // restarts from it
+                t = hit.first;
+                y = yAction;
+                comp.assign(m + 1, 0);
+                k_1j = ode._eval(y);
+                g0 = _evalEvents(options.events, y);
+                restart = true;
+                break;
             }
-            res.addRow(result);
-
-            h *= delta;
-            t += h;
-            row++;
 
-        } else {
-            h *= delta;
+            if (!restart)
+            {
+                if (options.saveat.empty())
+                    res.addRow(w1);
+                else 
+                    _saveDense(res, options.saveat, save, dense, w1[0]);
+
+                t = w1[0];
+                y = w1;
+                comp = c1;
+                k_1j = f1;
+                g0 = g1;
+            }
         }
+
+        h *= delta;
     } 
 
     return res;
@@ -523,10 +587,26 @@ DataFrame<T> _RKF45(ODESystem<T>& ode, T maxError)
 
 
 
+template <typename T>
+DataFrame<T> _RKF45(ODESystem<T>& ode, tolerance_t<T> tol) 
+{
+    return _RKF45(ode, options_t<T>(tol));
+}
+
+
+
+template <typename T>
+DataFrame<T> _RKF45(ODESystem<T>& ode, T maxError)
+{
+    return _RKF45(ode, tolerance_t<T>(maxError));
+}
+
+
+
 template <typename T>
 DataFrame<T> _RKF45(ODESystem<T>& ode)
 {
-    return _RKF45(ode, (T)DEFAULT_MAX_ERROR);
+    return _RKF45(ode, tolerance_t<T>());
 } 
 
 
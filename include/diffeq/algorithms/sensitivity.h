@@ -0,0 +1,139 @@
+#ifndef DIFFEQ_ALGORITHMS_SENSITIVITY_H
+#define DIFFEQ_ALGORITHMS_SENSITIVITY_H
+
+#include <limits>
+#include <vector>
+
+#include "../parametric.h"
+#include "control.h"
+
+
+namespace DES
+{
+
+/**
+ * @brief Augment a parametric system with its forward sensitivity equations,
+ * ds_j/dt = (df/dy) s_j + df/dp_j for s_j = dy/dp_j. Each right hand side of the
+ * sensitivities is one directional derivative of f in the direction (s_j, e_j),
+ * from the system's directional derivative if it has one, and otherwise from a
+ * forward difference (one extra evaluation of f per parameter).
+ *
+ * The augmented state is (t, y_1, ..., y_m, s_1, ..., s_P), where s_j holds
+ * dy_1/dp_j, ..., dy_m/dp_j. The buffers for the perturbed arguments and
+ * derivatives are allocated once and reused by every stage of every step, so
+ * the returned system must not be evaluated from several threads at once.
+ *
+ * @tparam T
+ * @param sys
+ * @param s0 Initial sensitivities dy(t0)/dp in the same layout, m * P values;
+ * empty means the initial conditions do not depend on the parameters.
+ * @return ODESystem<T>
+ */
+template <typename T>
+ODESystem<T> _sensitivitySystem(ParametricODESystem<T>& sys, std::vector<T> s0 = std::vector<T>())
+{
+    size_t m = sys.getNumEquations();
+    size_t P = sys.getNumParameters();
+
+    if (s0.empty())
+        s0.assign(m * P, 0);
+    if (s0.size() != m * P)
+        throw std::invalid_argument("Initial sensitivities must have one value per equation and parameter");
+
+    std::vector<T> values(sys.getInitialConditions().vec);
+    values.insert(values.end(), s0.begin(), s0.end());
+    iv_t<T> iValues(values);
+    timeBound_t<T> tBound = sys.getTimeBound();
+
+    ParametricODESystem<T> copy(sys);
+    std::vector<T> params = sys.getParameters();
+    std::vector<T> y(m + 1), f(m), dy(m), dp(P, 0), df(m), pp(params);
+
+    systemFunction_t<T> func([=](const std::vector<T>& args, std::vector<T>& out) mutable {
+        const T root = _CONTROL_SQRT(std::numeric_limits<T>::epsilon());
+
+        for (size_t i = 0; i <= m; i++)
+            y[i] = args[i];
+
+        copy._eval(y, params, f);
+        for (size_t i = 0; i < m; i++)
+            out[i] = f[i];
+
+        for (size_t j = 0; j < P; j++)
+        {
+            const T* s = args.data() + 1 + m + j * m;
+            for (size_t i = 0; i < m; i++)
+                dy[i] = s[i];
+
+            if (copy.hasDirectionalDerivative())
+            {
+                dp[j] = 1;
+                copy._evalDirectional(y, params, dy, dp, df);
+                dp[j] = 0;
+            }
+            else
+            {
+                // step relative to the size of the point and of the direction
+                T yNorm = _CONTROL_ABS(params[j]), dNorm = 1;
+                for (size_t i = 0; i < m; i++)
+                {
+                    yNorm = _CONTROL_ABS(y[i + 1]) > yNorm ? _CONTROL_ABS(y[i + 1]) : yNorm;
+                    dNorm = _CONTROL_ABS(dy[i]) > dNorm ? _CONTROL_ABS(dy[i]) : dNorm;
+                }
+                T eps = root * (yNorm > 1 ? yNorm : 1) / dNorm;
+
+                for (size_t i = 0; i < m; i++)
+                    y[i + 1] = args[i + 1] + eps * dy[i];
+                pp[j] = params[j] + eps;
+
+                copy._eval(y, pp, df);
+
+                pp[j] = params[j];
+                for (size_t i = 0; i <= m; i++)
+                    y[i] = args[i];
+                for (size_t i = 0; i < m; i++)
+                    df[i] = (df[i] - f[i]) / eps;
+            }
+
+            for (size_t i = 0; i < m; i++)
+                out[m + j * m + i] = df[i];
+        }
+    });
+
+    return ODESystem<T>(iValues, func, tBound, sys.getTimeStep());
+}
+
+
+/**
+ * @brief Solve a parametric system together with the derivatives of its
+ * solution with respect to every parameter, in one integration. State and
+ * sensitivities share the step size controller, so they are computed to the
+ * same tolerance (vector tolerances cover the m * (P + 1) components).
+ *
+ * @tparam T
+ * @param sys
+ * @param alg
+ * @param options
+ * @return DataFrame<T> Columns (t, y_1, ..., y_m, dy_1/dp_1, ..., dy_m/dp_1,
+ * ..., dy_m/dp_P), so dy_i/dp_j is in column j * m + i (1-based i and j).
+ */
+template <typename T>
+DataFrame<T> solveSensitivity(ParametricODESystem<T>& sys, algorithm_t alg, options_t<T> options)
+{
+    ODESystem<T> ode = _sensitivitySystem(sys);
+    return solve(ode, alg, options);
+}
+
+
+template <typename T>
+DataFrame<T> solveSensitivity(ParametricODESystem<T>& sys, algorithm_t alg)
+{
+    ODESystem<T> ode = _sensitivitySystem(sys);
+    return solve(ode, alg);
+}
+
+
+} // namespace DES
+
+
+#endif
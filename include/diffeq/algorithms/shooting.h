@@ -0,0 +1,439 @@
+#ifndef DIFFEQ_ALGORITHMS_SHOOTING_H
+#define DIFFEQ_ALGORITHMS_SHOOTING_H
+
+#include <functional>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "../ode.h"
+#include "../parametric.h"
+#include "../threadpool.h"
+#include "../linalg/lu.h"
+#include "control.h"
+#include "jacobian.h"
+#include "parareal.h"
+#include "sensitivity.h"
+
+
+#define  _BVP_LINE_SEARCH_STEPS     10
+
+
+namespace DES
+{
+
+/**
+ * @brief std::function wrapper for the boundary conditions r(y(a), y(b)) = 0 of
+ * a two point boundary value problem. It receives the values at both ends, of
+ * the form (t, y_1, ..., y_m), and writes the m residuals to out.
+ *
+ * @tparam T
+ */
+template <typename T>
+struct boundaryFunction_t
+{
+    std::function<void(const std::vector<T>&, const std::vector<T>&, std::vector<T>&)> _func;
+
+    boundaryFunction_t(std::function<void(const std::vector<T>&, const std::vector<T>&, std::vector<T>&)> func) {
+        _func = func;
+    }
+
+    void operator()(const std::vector<T>& ya, const std::vector<T>& yb, std::vector<T>& out)
+    {
+        _func(ya, yb, out);
+    }
+};
+
+
+/**
+ * @brief Options for multiple shooting. The interval is split into equal
+ * segments, each integrated by the propagator, and Newton's method stops when
+ * the update of every node and the mismatch at every node are within the
+ * tolerance.
+ *
+ * @tparam T
+ */
+template <typename T>
+struct bvpOptions_t
+{
+    size_t segments;
+    propagator_t<T> propagator = propagator_t<T>(ALGORITHM_RKF45, options_t<T>(tolerance_t<T>(1e-10, 1e-10)));
+    tolerance_t<T> tolerance;
+    size_t maxIterations = 50;
+
+    bvpOptions_t(size_t n)                                  : segments(n) { }
+    bvpOptions_t(size_t n, propagator_t<T> prop)            : segments(n), propagator(prop) { }
+};
+
+
+/**
+ * @brief The flow of a system together with its derivative with respect to the
+ * initial values, as the forward sensitivity system of a parametric system
+ * whose m parameters do not enter f and whose initial sensitivities are the
+ * identity.
+ *
+ * @tparam T
+ * @param ode
+ * @return ParametricODESystem<T>
+ */
+template <typename T>
+ParametricODESystem<T> _variationalSystem(ODESystem<T>& ode)
+{
+    size_t m = ode.getNumEquations();
+
+    parametricFunction_t<T> func([ode](const std::vector<T>& args, const std::vector<T>&, std::vector<T>& out) mutable {
+        std::vector<T> inputs(args);
+        out = ode._eval(inputs);
+    });
+
+    iv_t<T> iValues = ode.getInitialConditions();
+    timeBound_t<T> tBound = ode.getTimeBound();
+    return ParametricODESystem<T>(iValues, func, std::vector<T>(m, 0), tBound, ode.getTimeStep());
+}
+
+
+/**
+ * @brief Solve the multiple shooting Newton system
+ *
+ *      G_k ds_k - ds_(k+1) = -F_k      (k = 0, ..., N-1)
+ *      A ds_0 + B ds_N     = -r
+ *
+ * by Gaussian elimination with partial pivoting that follows its block
+ * structure. The boundary rows are kept as a border: step k stacks them on the
+ * continuity rows of segment k and eliminates block column k from the 2m rows,
+ * choosing pivots among all of them. The m pivot rows are stored, and the other
+ * m rows become the border for the next block column, so fill-in only reaches
+ * the last block column. This is as stable as pivoting the full matrix, unlike
+ * condensing to (A + B G_(N-1) ... G_0) ds_0, which fails once the product of
+ * the segment Jacobians overflows the precision.
+ *
+ * @tparam T
+ * @param G Segment Jacobians, m x m row major.
+ * @param F Continuity defects.
+ * @param A Derivative of the boundary conditions at the start.
+ * @param B Derivative of the boundary conditions at the end.
+ * @param r Boundary residual.
+ * @param ds Updates of the N + 1 nodes.
+ */
+template <typename T>
+void _borderedSolve(std::vector<std::vector<T>>& G, std::vector<std::vector<T>>& F, std::vector<T>& A, std::vector<T>& B,
+    std::vector<T>& r, std::vector<std::vector<T>>& ds)
+{
+    size_t N = G.size();
+    size_t m = r.size();
+
+    // border rows: C in the current block column, D in the last one
+    std::vector<T> C(A), D(B), b(m);
+    for (size_t i = 0; i < m; i++)
+        b[i] = -r[i];
+
+    // stored pivot rows of every step: U (upper triangular) in column k, Y in column k + 1, Z in column N
+    std::vector<std::vector<T>> U(N), Y(N), Z(N), c(N);
+
+    for (size_t k = 0; k < N; k++)
+    {
+        bool last = k + 1 == N;
+
+        // 2m stacked rows: the border, then the continuity rows of segment k
+        std::vector<T> X(2 * m * m), Yk(2 * m * m, 0), Zk(2 * m * m, 0), rhs(2 * m);
+        for (size_t i = 0; i < m; i++)
+        {
+            for (size_t j = 0; j < m; j++)
+            {
+                X[i * m + j] = C[i * m + j];
+                Zk[i * m + j] = D[i * m + j];
+                X[(m + i) * m + j] = G[k][i * m + j];
+            }
+
+            if (last) Zk[(m + i) * m + i] -= 1;
+            else      Yk[(m + i) * m + i] = -1;
+
+            rhs[i] = b[i];
+            rhs[m + i] = -F[k][i];
+        }
+
+        for (size_t j = 0; j < m; j++)
+        {
+            size_t p = j;
+            for (size_t i = j + 1; i < 2 * m; i++)
+                if (_CONTROL_ABS(X[i * m + j]) > _CONTROL_ABS(X[p * m + j]))
+                    p = i;
+
+            if (X[p * m + j] == 0)
+                throw std::runtime_error("Singular shooting matrix");
+
+            if (p != j)
+            {
+                for (size_t l = 0; l < m; l++)
+                {
+                    std::swap(X[j * m + l], X[p * m + l]);
+                    std::swap(Yk[j * m + l], Yk[p * m + l]);
+                    std::swap(Zk[j * m + l], Zk[p * m + l]);
+                }
+                std::swap(rhs[j], rhs[p]);
+            }
+
+            for (size_t i = j + 1; i < 2 * m; i++)
+            {
+                T factor = X[i * m + j] / X[j * m + j];
+                if (factor == 0)
+                    continue;
+
+                for (size_t l = 0; l < m; l++)
+                {
+                    X[i * m + l] -= factor * X[j * m + l];
+                    Yk[i * m + l] -= factor * Yk[j * m + l];
+                    Zk[i * m + l] -= factor * Zk[j * m + l];
+                }
+                rhs[i] -= factor * rhs[j];
+            }
+        }
+
+        U[k].assign(X.begin(), X.begin() + m * m);
+        Y[k].assign(Yk.begin(), Yk.begin() + m * m);
+        Z[k].assign(Zk.begin(), Zk.begin() + m * m);
+        c[k].assign(rhs.begin(), rhs.begin() + m);
+
+        C.assign(Yk.begin() + m * m, Yk.end());
+        D.assign(Zk.begin() + m * m, Zk.end());
+        b.assign(rhs.begin() + m, rhs.end());
+    }
+
+    // the border now only has the last block column
+    std::vector<size_t> piv;
+    if (!_luDecompose(D, m, piv))
+        throw std::runtime_error("Singular shooting matrix");
+    _luSolve(D, m, piv, b);
+
+    ds.assign(N + 1, std::vector<T>(m));
+    ds[N] = b;
+
+    for (size_t k = N; k-- > 0;)
+    {
+        std::vector<T>& next = ds[k + 1];
+        for (size_t i = m; i-- > 0;)
+        {
+            T sum = c[k][i];
+            for (size_t l = 0; l < m; l++)
+                sum -= Y[k][i * m + l] * next[l] + Z[k][i * m + l] * ds[N][l];
+            for (size_t l = i + 1; l < m; l++)
+                sum -= U[k][i * m + l] * ds[k][l];
+
+            ds[k][i] = sum / U[k][i * m + i];
+        }
+    }
+}
+
+
+/**
+ * @brief Solve the boundary value problem dy/dt = f(t, y) on [a, b] with
+ * r(y(a), y(b)) = 0 by multiple shooting. The unknowns are the states s_k at
+ * the nodes a = t_0 < ... < t_N = b, and Newton's method drives the
+ * continuity conditions phi_k(s_k) - s_(k+1) = 0 and the boundary conditions to
+ * zero. Every iteration integrates all segments with their variational
+ * equations concurrently on the pool, which gives the blocks G_k = dphi_k/ds_k.
+ *
+ * The Newton system is block bidiagonal with the boundary conditions as its
+ * border row, and is solved with the pivoted block-bordered elimination of
+ * _borderedSolve. The update is damped by halving until the residual decreases.
+ *
+ * Because each segment is short, shooting over intervals where a single
+ * trajectory would diverge stays well conditioned.
+ *
+ * @tparam T
+ * @param ode The system; its initial conditions are only used when no guess is
+ * given.
+ * @param bc
+ * @param options
+ * @param guess Initial guess of the solution, returning (t, y_1, ..., y_m).
+ * @param pool
+ * @return DataFrame<T> Solution on [a, b], concatenated over the segments.
+ */
+template <typename T>
+DataFrame<T> solveBVP(ODESystem<T>& ode, boundaryFunction_t<T> bc, bvpOptions_t<T> options, std::function<std::vector<T>(T)> guess, ThreadPool& pool)
+{
+    timeBound_t<T> tBound = ode.getTimeBound();
+    tolerance_t<T>& tol = options.tolerance;
+
+    size_t m = ode.getNumEquations();
+    size_t N = options.segments;
+
+    if (N == 0)
+        throw std::invalid_argument("Multiple shooting needs at least one segment");
+
+    if (!guess)
+    {
+        std::vector<T> y0 = ode.getInitialConditions().vec;
+        guess = [y0](T t) {
+            std::vector<T> res(y0);
+            res[0] = t;
+            return res;
+        };
+    }
+
+    std::vector<T> times(N + 1);
+    for (size_t k = 0; k <= N; k++)
+        times[k] = tBound.first + (tBound.second - tBound.first) * k / N;
+    times[N] = tBound.second;
+
+    std::vector<std::vector<T>> s(N + 1);
+    for (size_t k = 0; k <= N; k++)
+    {
+        s[k] = guess(times[k]);
+        s[k][0] = times[k];
+    }
+
+    ParametricODESystem<T> variational = _variationalSystem(ode);
+    std::vector<std::vector<T>> phi(N), G(N);
+
+    // integrate every segment, with its flow derivative when needed
+    auto shoot = [&](std::vector<std::vector<T>>& nodes, bool derivatives) {
+        pool.parallelFor(0, N, [&](size_t k) {
+            ODESystem<T> segment = derivatives ? _sensitivitySystem(variational) : ode;
+            std::vector<T> y0(nodes[k]);
+
+            if (derivatives)
+                y0.resize(1 + m + m * m);
+            for (size_t i = 0; derivatives && i < m; i++)
+                y0[1 + m + i * m + i] = 1;
+
+            segment.setInitialConditions(iv_t<T>(y0));
+            segment.setTimeBound(timeBound_t<T>(times[k], times[k + 1]));
+
+            DataFrame<T> sol = options.propagator(segment);
+            std::vector<T> end = sol.getRow(sol.getNumRows() - 1);
+
+            phi[k].assign(end.begin(), end.begin() + m + 1);
+            if (derivatives)
+            {
+                // column j of G_k is the sensitivity to the j-th initial value
+                G[k].assign(m * m, 0);
+                for (size_t j = 0; j < m; j++)
+                    for (size_t i = 0; i < m; i++)
+                        G[k][i * m + j] = end[1 + m + j * m + i];
+            }
+        });
+    };
+
+    // continuity defects phi_k(s_k) - s_(k+1), then the boundary residual
+    auto residual = [&](std::vector<std::vector<T>>& nodes, std::vector<std::vector<T>>& F, std::vector<T>& r) {
+        F.assign(N, std::vector<T>(m));
+        for (size_t k = 0; k < N; k++)
+            for (size_t i = 0; i < m; i++)
+                F[k][i] = phi[k][i + 1] - nodes[k + 1][i + 1];
+
+        r.resize(m);
+        bc(nodes[0], nodes[N], r);
+
+        T sum = 0;
+        for (size_t k = 0; k < N; k++)
+            for (size_t i = 0; i < m; i++)
+                sum += F[k][i] * F[k][i];
+        for (size_t i = 0; i < m; i++)
+            sum += r[i] * r[i];
+
+        return sum;
+    };
+
+    std::vector<std::vector<T>> F;
+    std::vector<T> r;
+
+    shoot(s, true);
+    T norm = residual(s, F, r);
+
+    for (size_t iter = 0; iter < options.maxIterations; iter++)
+    {
+        // derivatives of the boundary conditions by forward differences
+        std::vector<T> A(m * m), B(m * m), rp(m);
+        for (size_t j = 1; j <= m; j++)
+        {
+            std::vector<T> ya(s[0]), yb(s[N]);
+            T stepA = _differenceStep(ya[j]), stepB = _differenceStep(yb[j]);
+
+            ya[j] += stepA;
+            bc(ya, s[N], rp);
+            for (size_t i = 0; i < m; i++)
+                A[i * m + j - 1] = (rp[i] - r[i]) / stepA;
+
+            yb[j] += stepB;
+            bc(s[0], yb, rp);
+            for (size_t i = 0; i < m; i++)
+                B[i * m + j - 1] = (rp[i] - r[i]) / stepB;
+        }
+
+        std::vector<std::vector<T>> ds;
+        _borderedSolve(G, F, A, B, r, ds);
+
+        // damped update
+        T lambda = 1;
+        std::vector<std::vector<T>> next(s);
+        for (int halving = 0; halving <= _BVP_LINE_SEARCH_STEPS; halving++, lambda /= 2)
+        {
+            for (size_t k = 0; k <= N; k++)
+                for (size_t i = 0; i < m; i++)
+                    next[k][i + 1] = s[k][i + 1] + lambda * ds[k][i];
+
+            shoot(next, true);
+            T trial = residual(next, F, r);
+            if (trial < norm || halving == _BVP_LINE_SEARCH_STEPS)
+            {
+                norm = trial;
+                break;
+            }
+        }
+
+        T change = 0;
+        for (size_t k = 0; k <= N; k++)
+            for (size_t i = 0; i < m; i++)
+            {
+                T sc = tol.absolute(i) + tol.relative(i) * _CONTROL_ABS(next[k][i + 1]);
+                T e = lambda * ds[k][i] / sc;
+                change = e * e > change ? e * e : change;
+
+                // the segments must also join up, which the update alone does not show
+                T d = k < N ? F[k][i] / sc : 0;
+                change = d * d > change ? d * d : change;
+            }
+
+        s.swap(next);
+
+        if (_CONTROL_SQRT(change) <= 1)
+        {
+            DataFrame<T> res(0, m + 1);
+            std::vector<DataFrame<T>> parts(N, DataFrame<T>(0, m + 1));
+
+            pool.parallelFor(0, N, [&](size_t k) {
+                ODESystem<T> segment(ode);
+                segment.setInitialConditions(iv_t<T>(s[k]));
+                segment.setTimeBound(timeBound_t<T>(times[k], times[k + 1]));
+                parts[k] = options.propagator(segment);
+            });
+
+            for (size_t k = 0; k < N; k++)
+                for (size_t row = 0; row < parts[k].getNumRows(); row++)
+                {
+                    std::vector<T> y = parts[k].getRow(row);
+                    if (res.getNumRows() == 0 || y[0] > res.getRow(res.getNumRows() - 1)[0])
+                        res.addRow(y);
+                }
+
+            return res;
+        }
+    }
+
+    throw std::runtime_error("Boundary value problem did not converge");
+}
+
+
+template <typename T>
+DataFrame<T> solveBVP(ODESystem<T>& ode, boundaryFunction_t<T> bc, bvpOptions_t<T> options, std::function<std::vector<T>(T)> guess = nullptr)
+{
+    ThreadPool pool(options.segments < std::thread::hardware_concurrency() ? options.segments : 0);
+    return solveBVP(ode, bc, options, guess, pool);
+}
+
+
+} // namespace DES
+
+
+#endif
@@ -0,0 +1,401 @@
+#ifndef DIFFEQ_ALGORITHMS_STOCHASTIC_H
+#define DIFFEQ_ALGORITHMS_STOCHASTIC_H
+
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+
+#include "../sde.h"
+#include "control.h"
+#include "rk.h"
+#include "tableau.h"
+
+
+#if defined(DIFFEQ_FLOAT_PRECISION)
+    #define  _SDE_SQRT(a)               sqrtf(a)
+    #define  _SRA_ENTRY(a, b)           SRA1_TABF[a][b]
+#elif defined(DIFFEQ_DOUBLE_PRECISION)
+    #define  _SDE_SQRT(a)               sqrt(a)
+    #define  _SRA_ENTRY(a, b)           SRA1_TAB[a][b]
+#elif defined(DIFFEQ_LONG_DOUBLE_PRECISION)
+    #define  _SDE_SQRT(a)               sqrtl(a)
+    #define  _SRA_ENTRY(a, b)           SRA1_TABL[a][b]
+#elif defined(DIFFEQ_DOUBLE_DOUBLE_PRECISION)
+    #define  _SDE_SQRT(a)               sqrt(a)
+    #define  _SRA_ENTRY(a, b)           SRA1_TABDD[a][b]
+#else
+    #define  _SDE_SQRT(a)               (T)sqrt(a)
+    #define  _SRA_ENTRY(a, b)           (T)(SRA1_TAB[a][b])
+#endif
+
+
+namespace DES
+{
+
+/**
+ * @brief Euler-Maruyama step of size h, in place. Strong order 0.5.
+ *
+ * @tparam T
+ * @param sde
+ * @param inputs Values of the form (t, y_1, ..., y_m).
+ * @param h
+ */
+template <typename T>
+void _EM_step(SDESystem<T>& sde, std::vector<T>& inputs, T h)
+{
+    size_t m = sde.getNumEquations();
+    T sqrtH = _SDE_SQRT(h);
+
+    std::vector<T> f = sde._evalDrift(inputs);
+    std::vector<T> g = sde._evalDiffusion(inputs);
+
+    inputs[0] += h;
+    _LOOP_TO_M(i, 1)
+        inputs[i] += f[i-1] * h + g[i-1] * sqrtH * sde.noise.next();
+}
+
+
+/**
+ * @brief Derivative-free Milstein step of size h (Kloeden and Platen, 11.1), in
+ * place. Strong order 1 for diagonal noise where g_j only depends on y_j; the
+ * derivative of the diffusion is replaced by a difference along the support
+ * value y + f h + g sqrt(h).
+ *
+ * @tparam T
+ * @param sde
+ * @param inputs
+ * @param h
+ */
+template <typename T>
+void _MILSTEIN_step(SDESystem<T>& sde, std::vector<T>& inputs, T h)
+{
+    size_t m = sde.getNumEquations();
+    T sqrtH = _SDE_SQRT(h);
+
+    std::vector<T> f = sde._evalDrift(inputs);
+    std::vector<T> g = sde._evalDiffusion(inputs);
+
+    std::vector<T> support(inputs);
+    _LOOP_TO_M(i, 1)
+        support[i] += f[i-1] * h + g[i-1] * sqrtH;
+
+    std::vector<T> gs = sde._evalDiffusion(support);
+
+    inputs[0] += h;
+    _LOOP_TO_M(i, 1)
+    {
+        T dW = sqrtH * sde.noise.next();
+        inputs[i] += f[i-1] * h + g[i-1] * dW + (gs[i-1] - g[i-1]) * (dW * dW - h) / (2 * sqrtH);
+    }
+}
+
+
+
+template <typename T>
+DataFrame<T> _EM(SDESystem<T>& sde)
+{
+    timeBound_t<T> tBound = sde.getTimeBound();
+
+    size_t m = sde.getNumEquations();
+    size_t row = 0;
+
+    T h = sde.getTimeStep();
+    T t = tBound.first;
+
+    DataFrame<T> res(0, m + 1);
+    res.addRow(sde.getInitialConditions().vec);
+    sde.noise.reset();
+
+    do
+    {
+        std::vector<T> result(res.getRow(row));
+
+        _EM_step(sde, result, h);
+        result[0] = t + h;
+
+        res.addRow(result);
+
+        row++;
+        t += h;
+
+    } while (t < tBound.second);
+
+    return res;
+}
+
+
+
+template <typename T>
+DataFrame<T> _MILSTEIN(SDESystem<T>& sde)
+{
+    timeBound_t<T> tBound = sde.getTimeBound();
+
+    size_t m = sde.getNumEquations();
+    size_t row = 0;
+
+    T h = sde.getTimeStep();
+    T t = tBound.first;
+
+    DataFrame<T> res(0, m + 1);
+    res.addRow(sde.getInitialConditions().vec);
+    sde.noise.reset();
+
+    do
+    {
+        std::vector<T> result(res.getRow(row));
+
+        _MILSTEIN_step(sde, result, h);
+        result[0] = t + h;
+
+        res.addRow(result);
+
+        row++;
+        t += h;
+
+    } while (t < tBound.second);
+
+    return res;
+}
+
+
+
+template <typename T>
+std::vector<T> _EM_i(SDESystem<T>& sde)
+{
+    _EM_step(sde, sde.lastValues, sde.getTimeStep());
+
+    return std::vector<T>(sde.lastValues);
+}
+
+
+
+template <typename T>
+std::vector<T> _MILSTEIN_i(SDESystem<T>& sde)
+{
+    _MILSTEIN_step(sde, sde.lastValues, sde.getTimeStep());
+
+    return std::vector<T>(sde.lastValues);
+}
+
+
+
+/**
+ * @brief Brownian increments over an interval of length h: dW drives the
+ * equations and dZ is the independent process used for the iterated integral
+ * I_(1,0) = h/2 (dW + dZ/sqrt(3)).
+ *
+ * @tparam T
+ */
+template <typename T>
+struct _increment_t
+{
+    T h;
+    std::vector<T> dW, dZ;
+};
+
+
+/**
+ * @brief Split an increment with the Brownian bridge: the first h of it is
+ * returned, and inc keeps the rest. Both parts together are exactly the
+ * original increment, so a rejected step does not change the sample path.
+ *
+ * @tparam T
+ * @param inc
+ * @param h
+ * @param noise
+ * @return _increment_t<T>
+ */
+template <typename T>
+_increment_t<T> _bridge(_increment_t<T>& inc, T h, normalStream_t<T>& noise)
+{
+    _increment_t<T> first = { h, std::vector<T>(inc.dW.size()), std::vector<T>(inc.dZ.size()) };
+    T ratio = h / inc.h;
+    T sd = _SDE_SQRT(h * (inc.h - h) / inc.h);
+
+    for (size_t i = 0; i < inc.dW.size(); i++)
+    {
+        first.dW[i] = ratio * inc.dW[i] + sd * noise.next();
+        first.dZ[i] = ratio * inc.dZ[i] + sd * noise.next();
+        inc.dW[i] -= first.dW[i];
+        inc.dZ[i] -= first.dZ[i];
+    }
+
+    inc.h -= h;
+    return first;
+}
+
+
+/**
+ * @brief One SRA1 step with the given increments. The new values are written
+ * to result, and the local error estimate (the drift compared to Euler plus the
+ * noise term of order 1.5) to err.
+ *
+ * @tparam T
+ * @param sde
+ * @param y
+ * @param inc
+ * @param result
+ * @param err
+ */
+template <typename T>
+void _SRA1_step(SDESystem<T>& sde, std::vector<T>& y, _increment_t<T>& inc, std::vector<T>& result, std::vector<T>& err)
+{
+    using namespace ButcherTableau;
+
+    size_t m = sde.getNumEquations();
+    T h = inc.h;
+    T t = y[0];
+
+    std::vector<T> inputs(y);
+    std::vector<T> a1 = sde._evalDrift(inputs);
+
+    // additive noise only depends on time
+    inputs[0] = t + _SRA_ENTRY(1, 0) * h;
+    std::vector<T> b1 = sde._evalDiffusion(inputs);
+    inputs[0] = t + _SRA_ENTRY(1, 1) * h;
+    std::vector<T> b2 = sde._evalDiffusion(inputs);
+
+    std::vector<T> I10(m);
+    for (size_t i = 0; i < m; i++)
+        I10[i] = h / 2 * (inc.dW[i] + inc.dZ[i] / _SDE_SQRT((T)3));
+
+    inputs[0] = t + _SRA_ENTRY(0, 1) * h;
+    _LOOP_TO_M(i, 1)
+        inputs[i] = y[i] + _SRA_ENTRY(5, 0) * a1[i-1] * h + _SRA_ENTRY(5, 1) * b1[i-1] * I10[i-1] / h;
+
+    std::vector<T> a2 = sde._evalDrift(inputs);
+
+    result[0] = t + h;
+    _LOOP_TO_M(i, 1)
+    {
+        T I1 = inc.dW[i-1], J = I10[i-1] / h;
+
+        result[i] = y[i] + h * (_SRA_ENTRY(2, 0) * a1[i-1] + _SRA_ENTRY(2, 1) * a2[i-1])
+            + (_SRA_ENTRY(3, 0) * I1 + _SRA_ENTRY(4, 0) * J) * b1[i-1]
+            + (_SRA_ENTRY(3, 1) * I1 + _SRA_ENTRY(4, 1) * J) * b2[i-1];
+
+        T drift = h * ((_SRA_ENTRY(2, 0) - 1) * a1[i-1] + _SRA_ENTRY(2, 1) * a2[i-1]);
+        T diffusion = (_SRA_ENTRY(4, 0) * b1[i-1] + _SRA_ENTRY(4, 1) * b2[i-1]) * J;
+        err[i] = (drift >= 0 ? drift : -drift) + (diffusion >= 0 ? diffusion : -diffusion);
+    }
+}
+
+
+/**
+ * @brief Solve an SDE with additive noise (g may depend on t only) with the
+ * adaptive SRA1 method. Rejected steps split their Brownian increment with the
+ * Brownian bridge and keep the unused part for later steps (RSwM1, Rackauckas
+ * and Nie, 2017), so adaptivity does not bias the sample path.
+ *
+ * @tparam T
+ * @param sde
+ * @param options Tolerances and the maximum step. Output times and events are
+ * not supported, and setting either throws std::invalid_argument.
+ * @return DataFrame<T>
+ */
+template <typename T>
+DataFrame<T> _SRA1(SDESystem<T>& sde, options_t<T> options)
+{
+    if (!options.saveat.empty() || !options.events.empty())
+        throw std::invalid_argument("SRA1 does not support output times or events");
+
+    timeBound_t<T> tBound = sde.getTimeBound();
+    tolerance_t<T>& tol = options.tolerance;
+
+    size_t m = sde.getNumEquations();
+
+    T h = sde.getTimeStep();
+    T t = tBound.first;
+    T eps = std::numeric_limits<T>::epsilon();
+
+    std::vector<T> y(sde.getInitialConditions().vec);
+
+    // the starting step follows the drift, with the order of the weak error
+    if (h <= 0)
+    {
+        ODESystem<T> ode = sde._getODESystem();
+        std::vector<T> f0 = sde._evalDrift(y);
+        h = _initialStep(ode, y, f0, (T)1, tol, tBound.second);
+    }
+    std::vector<_increment_t<T>> future;
+    _increment_t<T> inc;
+    bool pending = false;
+
+    DataFrame<T> res(0, m + 1);
+    res.addRow(y);
+    sde.noise.reset();
+
+    while (t < tBound.second)
+    {
+        if (!pending)
+        {
+            if (options.maxStep > 0)
+                h = _MIN(h, options.maxStep);
+            h = _MIN(h, tBound.second - t);
+
+            if (future.empty())
+            {
+                inc = { h, std::vector<T>(m), std::vector<T>(m) };
+                for (size_t i = 0; i < m; i++)
+                {
+                    inc.dW[i] = _SDE_SQRT(h) * sde.noise.next();
+                    inc.dZ[i] = _SDE_SQRT(h) * sde.noise.next();
+                }
+            }
+            else if (h >= future.back().h)
+            {
+                inc = future.back();
+                future.pop_back();
+            }
+            else
+                inc = _bridge(future.back(), h, sde.noise);
+        }
+
+        std::vector<T> result(m + 1), err(m + 1);
+        _SRA1_step(sde, y, inc, result, err);
+
+        T R = _errorNorm(err, y, result, tol);
+        if (!(R < std::numeric_limits<T>::infinity()))
+            throw std::runtime_error("Error estimate is not finite");
+
+        T delta = _stepFactor(R, (T)1);
+
+        if (R <= 1)
+        {
+            t += inc.h;
+            result[0] = t;
+            y = result;
+            res.addRow(result);
+
+            h = inc.h * delta;
+            pending = false;
+        }
+        else
+        {
+            if (inc.h * delta <= eps * (t >= 0 ? t : -t))
+                throw std::runtime_error("Step size too small");
+
+            _increment_t<T> first = _bridge(inc, inc.h * delta, sde.noise);
+            future.push_back(inc);
+            inc = first;
+            pending = true;
+        }
+    }
+
+    return res;
+}
+
+
+
+template <typename T>
+DataFrame<T> _SRA1(SDESystem<T>& sde)
+{
+    return _SRA1(sde, options_t<T>());
+}
+
+
+} // namespace DES
+
+
+#endif
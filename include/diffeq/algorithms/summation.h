@@ -0,0 +1,89 @@
+#ifndef DIFFEQ_ALGORITHMS_SUMMATION_H
+#define DIFFEQ_ALGORITHMS_SUMMATION_H
+
+
+// Accumulation of the state and time updates of the explicit steppers. Over
+// long runs, y += h * k loses the low bits of every small update against a
+// large y, which dominates the error in float. Defining
+//
+//  DIFFEQ_COMPENSATED_SUMMATION    carries the rounding error of every update
+//                                  (Neumaier, 1974) into the next one
+//  DIFFEQ_MIXED_PRECISION          adds float updates in double, while the
+//                                  stages are still evaluated in float
+//
+// keeps the accumulated values close to what a wider type would give. Each
+// value is stored with a compensation, the part of the sum below its rounding,
+// so the stored value is always the sum correctly rounded to T.
+
+
+#if defined(DIFFEQ_COMPENSATED_SUMMATION) || defined(DIFFEQ_MIXED_PRECISION)
+    #define  _DIFFEQ_ACCUMULATE
+#endif
+
+
+namespace DES
+{
+
+/**
+ * @brief Type the updates are added in.
+ *
+ * @tparam T
+ */
+template <typename T>
+struct _accumulator_t
+{
+    typedef T type;
+};
+
+
+#if defined(DIFFEQ_MIXED_PRECISION)
+template <>
+struct _accumulator_t<float>
+{
+    typedef double type;
+};
+#endif
+
+
+/**
+ * @brief sum += x, where comp holds what sum could not represent of the
+ * previous updates. Without DIFFEQ_COMPENSATED_SUMMATION or
+ * DIFFEQ_MIXED_PRECISION this is a plain addition and comp is unused.
+ *
+ * @tparam T
+ * @param sum
+ * @param comp
+ * @param x
+ */
+template <typename T>
+inline void _accumulate(T& sum, T& comp, T x)
+{
+#if defined(_DIFFEQ_ACCUMULATE)
+    typedef typename _accumulator_t<T>::type A;
+
+    A a = sum, b = x;
+    A s = a + b;
+
+#if defined(DIFFEQ_COMPENSATED_SUMMATION)
+    // exact rounding error of a + b, with the larger operand first
+    A e = (a >= 0 ? a : -a) >= (b >= 0 ? b : -b) ? (a - s) + b : (b - s) + a;
+#else
+    A e = 0;
+#endif
+
+    A c = (A)comp + e;
+
+    // renormalize, so sum stays the correctly rounded value
+    sum = (T)(s + c);
+    comp = (T)((s - (A)sum) + c);
+#else
+    (void)comp;
+    sum += x;
+#endif
+}
+
+
+} // namespace DES
+
+
+#endif
@@ -1,6 +1,10 @@
 #ifndef DIFFEQ_ALGORITHMS_TABLEAU_H
 #define DIFFEQ_ALGORITHMS_TABLEAU_H
 
+#if defined(DIFFEQ_DOUBLE_DOUBLE_PRECISION)
+#include "../ddouble.h"
+#endif
+
 
 namespace DES 
 {
@@ -16,6 +20,8 @@ namespace DES
  * to compute the error at each step, in order to modify the timestep.
  * 
  * Each tableau has a float and double version, depending on memory/precision needs.
+ * With DIFFEQ_DOUBLE_DOUBLE_PRECISION, there is also a double-double version, whose
+ * fractions are rounded to double-double rather than to double.
  * 
  */
 namespace ButcherTableau
@@ -25,6 +31,11 @@ namespace ButcherTableau
     #define TAB_NULLF   0.0f
     #define TAB_NULLL   0.0l
 
+#if defined(DIFFEQ_DOUBLE_DOUBLE_PRECISION)
+    #define TAB_NULLDD  ddouble(0)
+    #define _DD(p, q)   (ddouble(p) / ddouble(q))
+#endif
+
 
     const double EULER_TAB[2][2] 
     {
@@ -47,6 +58,15 @@ namespace ButcherTableau
     };
 
 
+#if defined(DIFFEQ_DOUBLE_DOUBLE_PRECISION)
+    const ddouble EULER_TABDD[2][2]
+    {
+        {    _DD(0, 1),   _DD(0, 1)   },
+        {   TAB_NULLDD,   _DD(1, 1)   }
+    };
+#endif
+
+
     const double RK4_TAB[5][5] 
     {
         {        0.0,   TAB_NULL,   TAB_NULL,   TAB_NULL,   TAB_NULL   },
@@ -77,6 +97,18 @@ namespace ButcherTableau
     };
 
 
+#if defined(DIFFEQ_DOUBLE_DOUBLE_PRECISION)
+    const ddouble RK4_TABDD[5][5]
+    {
+        {    _DD(0, 1),   TAB_NULLDD,   TAB_NULLDD,   TAB_NULLDD,   TAB_NULLDD   },
+        {    _DD(1, 2),    _DD(1, 2),   TAB_NULLDD,   TAB_NULLDD,   TAB_NULLDD   },
+        {    _DD(1, 2),    _DD(0, 1),    _DD(1, 2),   TAB_NULLDD,   TAB_NULLDD   },
+        {    _DD(1, 1),    _DD(0, 1),    _DD(0, 1),    _DD(1, 1),   TAB_NULLDD   },
+        {   TAB_NULLDD,    _DD(1, 6),    _DD(1, 3),    _DD(1, 3),    _DD(1, 6)   }
+    };
+#endif
+
+
     const double RK38_TAB[5][5] 
     {
         {        0.0,   TAB_NULL,   TAB_NULL,   TAB_NULL,   TAB_NULL   },
@@ -107,6 +139,18 @@ namespace ButcherTableau
     };
 
 
+#if defined(DIFFEQ_DOUBLE_DOUBLE_PRECISION)
+    const ddouble RK38_TABDD[5][5]
+    {
+        {    _DD(0, 1),   TAB_NULLDD,   TAB_NULLDD,   TAB_NULLDD,   TAB_NULLDD   },
+        {    _DD(1, 3),    _DD(1, 3),   TAB_NULLDD,   TAB_NULLDD,   TAB_NULLDD   },
+        {    _DD(2, 3),   _DD(-1, 3),    _DD(1, 1),   TAB_NULLDD,   TAB_NULLDD   },
+        {    _DD(1, 1),    _DD(1, 1),   _DD(-1, 1),    _DD(1, 1),   TAB_NULLDD   },
+        {   TAB_NULLDD,    _DD(1, 8),    _DD(3, 8),    _DD(3, 8),    _DD(3, 8)   }
+    };
+#endif
+
+
     const double RKF45_TAB[8][7] 
     {
         {         0.0,        TAB_NULL,         TAB_NULL,         TAB_NULL,          TAB_NULL,     TAB_NULL,   TAB_NULL    },
@@ -145,6 +189,112 @@ namespace ButcherTableau
         {     TAB_NULLL,      16.0l/135.0l,               0.0l,   6656.0l/12825.0l,   28561.0l/56430.0l,    -9.0l/50.0l,   2.0l/55.0l    }
     };
 
+
+#if defined(DIFFEQ_DOUBLE_DOUBLE_PRECISION)
+    const ddouble RKF45_TABDD[8][7]
+    {
+        {     _DD(0, 1),        TAB_NULLDD,         TAB_NULLDD,         TAB_NULLDD,          TAB_NULLDD,     TAB_NULLDD,   TAB_NULLDD   },
+        {     _DD(1, 4),         _DD(1, 4),         TAB_NULLDD,         TAB_NULLDD,          TAB_NULLDD,     TAB_NULLDD,   TAB_NULLDD   },
+        {     _DD(3, 8),        _DD(3, 32),         _DD(9, 32),         TAB_NULLDD,          TAB_NULLDD,     TAB_NULLDD,   TAB_NULLDD   },
+        {   _DD(12, 13),   _DD(1932, 2197),   _DD(-7200, 2197),    _DD(7296, 2197),          TAB_NULLDD,     TAB_NULLDD,   TAB_NULLDD   },
+        {     _DD(1, 1),     _DD(439, 216),         _DD(-8, 1),     _DD(3680, 513),     _DD(-845, 4104),     TAB_NULLDD,   TAB_NULLDD   },
+        {     _DD(1, 2),       _DD(-8, 27),          _DD(2, 1),   _DD(-3544, 2565),     _DD(1859, 4104),   _DD(-11, 40),   TAB_NULLDD   },
+        {    TAB_NULLDD,      _DD(25, 216),          _DD(0, 1),    _DD(1408, 2565),     _DD(2197, 4104),     _DD(-1, 5),    _DD(0, 1)   },
+        {    TAB_NULLDD,      _DD(16, 135),          _DD(0, 1),   _DD(6656, 12825),   _DD(28561, 56430),    _DD(-9, 50),   _DD(2, 55)   }
+    };
+#endif
+
+
+    /**
+     * MRI-GARK-ERK22a (Sandu, 2019). The first column holds the stage times c_i,
+     * and row i holds the coupling coefficients gamma_ij that weigh the slow 
+     * stage derivatives while the fast group is integrated from c_(i-1) to c_i. 
+     * The last row produces the solution.
+     */
+    const double MRI_GARK22_TAB[3][3]
+    {
+        {        0.0,   TAB_NULL,   TAB_NULL   },
+        {    1.0/2.0,    1.0/2.0,   TAB_NULL   },
+        {        1.0,   -1.0/2.0,        1.0   }
+    };
+
+
+    const float MRI_GARK22_TABF[3][3]
+    {
+        {        0.0f,   TAB_NULLF,   TAB_NULLF   },
+        {   1.0f/2.0f,   1.0f/2.0f,   TAB_NULLF   },
+        {        1.0f,  -1.0f/2.0f,        1.0f   }
+    };
+
+
+    const long double MRI_GARK22_TABL[3][3]
+    {
+        {        0.0l,   TAB_NULLL,   TAB_NULLL   },
+        {   1.0l/2.0l,   1.0l/2.0l,   TAB_NULLL   },
+        {        1.0l,  -1.0l/2.0l,        1.0l   }
+    };
+
+
+#if defined(DIFFEQ_DOUBLE_DOUBLE_PRECISION)
+    const ddouble MRI_GARK22_TABDD[3][3]
+    {
+        {   _DD(0, 1),   TAB_NULLDD,   TAB_NULLDD   },
+        {   _DD(1, 2),    _DD(1, 2),   TAB_NULLDD   },
+        {   _DD(1, 1),   _DD(-1, 2),    _DD(1, 1)   }
+    };
+#endif
+
+
+    /**
+     * SRA1 (Rossler, 2010), a strong order 1.5 method for SDEs with additive 
+     * noise. The rows are c0, c1, alpha, beta1, beta2 and (A0_21, B0_21), with 
+     * one column per stage.
+     */
+    const double SRA1_TAB[6][2]
+    {
+        {        0.0,    3.0/4.0   },
+        {        1.0,        0.0   },
+        {    1.0/3.0,    2.0/3.0   },
+        {        1.0,        0.0   },
+        {       -1.0,        1.0   },
+        {    3.0/4.0,    3.0/2.0   }
+    };
+
+
+    const float SRA1_TABF[6][2]
+    {
+        {        0.0f,   3.0f/4.0f   },
+        {        1.0f,        0.0f   },
+        {   1.0f/3.0f,   2.0f/3.0f   },
+        {        1.0f,        0.0f   },
+        {       -1.0f,        1.0f   },
+        {   3.0f/4.0f,   3.0f/2.0f   }
+    };
+
+
+    const long double SRA1_TABL[6][2]
+    {
+        {        0.0l,   3.0l/4.0l   },
+        {        1.0l,        0.0l   },
+        {   1.0l/3.0l,   2.0l/3.0l   },
+        {        1.0l,        0.0l   },
+        {       -1.0l,        1.0l   },
+        {   3.0l/4.0l,   3.0l/2.0l   }
+    };
+
+
+#if defined(DIFFEQ_DOUBLE_DOUBLE_PRECISION)
+    const ddouble SRA1_TABDD[6][2]
+    {
+        {    _DD(0, 1),   _DD(3, 4)   },
+        {    _DD(1, 1),   _DD(0, 1)   },
+        {    _DD(1, 3),   _DD(2, 3)   },
+        {    _DD(1, 1),   _DD(0, 1)   },
+        {   _DD(-1, 1),   _DD(1, 1)   },
+        {    _DD(3, 4),   _DD(3, 2)   }
+    };
+#endif
+
 };
 
 
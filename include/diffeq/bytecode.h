@@ -0,0 +1,565 @@
+#ifndef DIFFEQ_BYTECODE_H
+#define DIFFEQ_BYTECODE_H
+
+#include <cctype>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+
+#include "solver.h"
+#include "restrict.h"
+#include "vmath.h"
+
+
+// Equations read from text at run time, e.g.
+//
+//  dtheta = omega; domega = -g / l * sin(theta)
+//
+// Every statement dX = expression gives the derivative of a state X, and the
+// states are numbered in the order of their statements. Expressions use + - * /
+// ^, parentheses, the time t, numbers, pi, parameters (given by name with a
+// value) and the functions sin, cos, tan, exp, log, sqrt, tanh, abs and pow.
+//
+// The text is compiled to a register machine: every instruction reads one or two
+// registers and writes a new one. Equal instructions are only emitted once
+// (value numbering), which eliminates common subexpressions, and operations on
+// numbers alone are folded. The interpreter runs every instruction over a whole
+// batch of states at once, stored by component (the argument i of state l at
+// i * n + l), so decoding costs once per batch and the loop over the batch is
+// vectorized, by the compiler or with the functions of vmath.h.
+
+
+namespace DES
+{
+
+enum _opcode_t : uint8_t
+{
+    _OP_ADD, _OP_SUB, _OP_MUL, _OP_DIV, _OP_POW,
+    _OP_NEG, _OP_SIN, _OP_COS, _OP_TAN, _OP_EXP, _OP_LOG, _OP_SQRT, _OP_TANH, _OP_ABS
+};
+
+
+struct _instruction_t
+{
+    _opcode_t op;
+    uint32_t dst, a, b;
+};
+
+
+/**
+ * @brief Read a decimal number (digits, an optional fraction and exponent) into
+ * T. Built in floating types use strtold, which rounds correctly. Other types
+ * (e.g. ddouble) accumulate the digits and the power of ten in T itself, so the
+ * constant keeps the precision of T instead of that of long double.
+ *
+ * @tparam T
+ * @param s
+ * @param end Set to the first character after the number.
+ * @return T
+ */
+template <typename T>
+T _parseDecimal(const char* s, const char** end)
+{
+    if constexpr (std::is_floating_point<T>::value)
+    {
+        char* e;
+        T value = (T)std::strtold(s, &e);
+        *end = e;
+        return value;
+    }
+    else
+    {
+        T mantissa = 0;
+        long exponent = 0;
+
+        for (; std::isdigit((unsigned char)*s); s++)
+            mantissa = mantissa * 10 + (*s - '0');
+        if (*s == '.')
+            for (s++; std::isdigit((unsigned char)*s); s++, exponent--)
+                mantissa = mantissa * 10 + (*s - '0');
+
+        const char* e = s;
+        if (*e == 'e' || *e == 'E')
+        {
+            e++;
+            bool negative = *e == '-';
+            if (*e == '+' || *e == '-')
+                e++;
+
+            if (std::isdigit((unsigned char)*e))
+            {
+                long k = 0;
+                for (; std::isdigit((unsigned char)*e); e++)
+                    k = k < 100000 ? 10 * k + (*e - '0') : k;
+                exponent += negative ? -k : k;
+                s = e;
+            }
+        }
+        *end = s;
+
+        T scale = 1, power = 10;
+        for (unsigned long k = exponent < 0 ? -exponent : exponent; k > 0; k >>= 1, power *= power)
+            if (k & 1)
+                scale *= power;
+
+        return exponent < 0 ? mantissa / scale : mantissa * scale;
+    }
+}
+
+
+/**
+ * @brief One operation on scalars, for folding constants.
+ *
+ * @tparam T
+ */
+template <typename T>
+T _applyOpcode(_opcode_t op, T a, T b)
+{
+    using std::sin; using std::cos; using std::tan; using std::exp; using std::log;
+    using std::sqrt; using std::tanh; using std::pow; using std::abs;
+
+    switch (op)
+    {
+        case _OP_ADD:   return a + b;
+        case _OP_SUB:   return a - b;
+        case _OP_MUL:   return a * b;
+        case _OP_DIV:   return a / b;
+        case _OP_POW:   return pow(a, b);
+        case _OP_NEG:   return -a;
+        case _OP_SIN:   return sin(a);
+        case _OP_COS:   return cos(a);
+        case _OP_TAN:   return tan(a);
+        case _OP_EXP:   return exp(a);
+        case _OP_LOG:   return log(a);
+        case _OP_SQRT:  return sqrt(a);
+        case _OP_TANH:  return tanh(a);
+        default:        return abs(a);
+    }
+}
+
+
+/**
+ * @brief A system of equations compiled from text, see above. Registers 0 to m
+ * hold the arguments (t, y_1, ..., y_m); parameters, constants and results of
+ * instructions follow.
+ *
+ * @tparam T
+ */
+template <typename T>
+class program_t
+{
+
+private:
+    std::vector<std::string> _states;
+    std::vector<_instruction_t> _code;
+    std::vector<uint32_t> _outputs;
+
+    std::vector<std::pair<uint32_t, T>> _constants;         // register, value
+    std::map<std::string, uint32_t> _params;                // name, register
+    std::map<std::string, T> _paramValues;
+    std::map<std::tuple<int, uint32_t, uint32_t>, uint32_t> _emitted;
+    std::map<uint32_t, T> _folded;                          // registers of numbers
+    uint32_t _registers = 0;
+
+    // parser state
+    std::string _src;
+    size_t _pos = 0;
+
+    [[noreturn]] void _error(const std::string& what)
+    {
+        throw std::invalid_argument("Equation parse error at " + std::to_string(_pos) + ": " + what);
+    }
+
+    void _skip()
+    {
+        while (_pos < _src.size() && (_src[_pos] == ' ' || _src[_pos] == '\t' || _src[_pos] == '\r'))
+            _pos++;
+    }
+
+    bool _accept(char c)
+    {
+        _skip();
+        if (_pos < _src.size() && _src[_pos] == c)
+        {
+            _pos++;
+            return true;
+        }
+        return false;
+    }
+
+    std::string _identifier()
+    {
+        _skip();
+        size_t start = _pos;
+        while (_pos < _src.size() && (std::isalnum((unsigned char)_src[_pos]) || _src[_pos] == '_'))
+            _pos++;
+
+        if (start == _pos || std::isdigit((unsigned char)_src[start]))
+            _error("expected a name");
+        return _src.substr(start, _pos - start);
+    }
+
+    uint32_t _constant(T value)
+    {
+        for (std::pair<uint32_t, T>& c : _constants)
+            if (c.second == value)
+                return c.first;
+
+        _constants.push_back({ _registers, value });
+        _folded[_registers] = value;
+        return _registers++;
+    }
+
+    uint32_t _emit(_opcode_t op, uint32_t a, uint32_t b = 0)
+    {
+        bool unary = op >= _OP_NEG;
+        if (_folded.count(a) && (unary || _folded.count(b)))
+            return _constant(_applyOpcode(op, _folded[a], unary ? T(0) : _folded[b]));
+
+        // commutative operations are keyed with their operands in order
+        if ((op == _OP_ADD || op == _OP_MUL) && b < a)
+            std::swap(a, b);
+
+        std::tuple<int, uint32_t, uint32_t> key((int)op, a, unary ? 0 : b);
+        auto it = _emitted.find(key);
+        if (it != _emitted.end())
+            return it->second;
+
+        _code.push_back({ op, _registers, a, b });
+        _emitted[key] = _registers;
+        return _registers++;
+    }
+
+    uint32_t _expression()
+    {
+        uint32_t r = _term();
+        while (true)
+        {
+            if (_accept('+'))       r = _emit(_OP_ADD, r, _term());
+            else if (_accept('-'))  r = _emit(_OP_SUB, r, _term());
+            else                    return r;
+        }
+    }
+
+    uint32_t _term()
+    {
+        uint32_t r = _unary();
+        while (true)
+        {
+            if (_accept('*'))       r = _emit(_OP_MUL, r, _unary());
+            else if (_accept('/'))  r = _emit(_OP_DIV, r, _unary());
+            else                    return r;
+        }
+    }
+
+    uint32_t _unary()
+    {
+        if (_accept('-'))
+            return _emit(_OP_NEG, _unary());
+        if (_accept('+'))
+            return _unary();
+        return _power();
+    }
+
+    uint32_t _power()
+    {
+        uint32_t r = _primary();
+        if (_accept('^'))
+            return _emit(_OP_POW, r, _unary());         // right associative
+        return r;
+    }
+
+    uint32_t _primary()
+    {
+        _skip();
+        if (_pos >= _src.size())
+            _error("unexpected end of equation");
+
+        if (_accept('('))
+        {
+            uint32_t r = _expression();
+            if (!_accept(')'))
+                _error("expected ')'");
+            return r;
+        }
+
+        if (std::isdigit((unsigned char)_src[_pos]) || _src[_pos] == '.')
+        {
+            const char* start = _src.c_str() + _pos;
+            const char* end;
+            T value = _parseDecimal<T>(start, &end);
+            _pos += end - start;
+            return _constant(value);
+        }
+
+        std::string name = _identifier();
+
+        if (_accept('('))
+        {
+            static const std::map<std::string, _opcode_t> functions = {
+                { "sin", _OP_SIN }, { "cos", _OP_COS }, { "tan", _OP_TAN }, { "exp", _OP_EXP }, { "log", _OP_LOG },
+                { "sqrt", _OP_SQRT }, { "tanh", _OP_TANH }, { "abs", _OP_ABS }, { "pow", _OP_POW }
+            };
+
+            auto f = functions.find(name);
+            if (f == functions.end())
+                _error("unknown function '" + name + "'");
+
+            uint32_t a = _expression(), b = 0;
+            if (f->second == _OP_POW)
+            {
+                if (!_accept(','))
+                    _error("pow takes two arguments");
+                b = _expression();
+            }
+            if (!_accept(')'))
+                _error("expected ')'");
+
+            return _emit(f->second, a, b);
+        }
+
+        for (size_t i = 0; i < _states.size(); i++)
+            if (_states[i] == name)
+                return (uint32_t)(i + 1);
+
+        if (name == "t")
+            return 0;
+        if (name == "pi")
+        {
+            const char* end;
+            return _constant(_parseDecimal<T>("3.141592653589793238462643383279502884", &end));
+        }
+
+        auto p = _params.find(name);
+        if (p != _params.end())
+            return p->second;
+
+        auto v = _paramValues.find(name);
+        if (v == _paramValues.end())
+            _error("unknown symbol '" + name + "'");
+
+        _params[name] = _registers;
+        return _registers++;
+    }
+
+    static std::vector<std::string> _statements(const std::string& source)
+    {
+        std::vector<std::string> res;
+        std::string current;
+        for (char c : source)
+        {
+            if (c == ';' || c == '\n')
+            {
+                if (current.find_first_not_of(" \t\r") != std::string::npos)
+                    res.push_back(current);
+                current.clear();
+            }
+            else
+                current += c;
+        }
+        if (current.find_first_not_of(" \t\r") != std::string::npos)
+            res.push_back(current);
+
+        return res;
+    }
+
+public:
+    program_t() = default;
+
+
+    /**
+     * @brief Compile equations from text.
+     *
+     * @param source Statements dX = expression, separated by ';' or new lines.
+     * @param parameters Values of the parameters the equations use.
+     */
+    program_t(const std::string& source, std::map<std::string, T> parameters = {})
+        : _paramValues(parameters)
+    {
+        std::vector<std::string> statements = _statements(source);
+        std::vector<std::string> rhs;
+
+        if (statements.empty())
+            throw std::invalid_argument("No equations given");
+
+        for (std::string& s : statements)
+        {
+            size_t eq = s.find('=');
+            _src = s.substr(0, eq);
+            _pos = 0;
+
+            std::string lhs = _identifier();
+            _skip();
+            if (eq == std::string::npos || _pos != _src.size() || lhs.size() < 2 || lhs[0] != 'd')
+                throw std::invalid_argument("Equations must be of the form dX = expression: '" + s + "'");
+
+            for (std::string& state : _states)
+                if (state == lhs.substr(1))
+                    throw std::invalid_argument("State '" + state + "' has two equations");
+
+            _states.push_back(lhs.substr(1));
+            rhs.push_back(s.substr(eq + 1));
+        }
+
+        _registers = (uint32_t)_states.size() + 1;
+
+        for (std::string& s : rhs)
+        {
+            _src = s;
+            _pos = 0;
+            _outputs.push_back(_expression());
+
+            _skip();
+            if (_pos != _src.size())
+                _error("unexpected '" + _src.substr(_pos, 1) + "'");
+        }
+
+        _emitted.clear();
+        _src.clear();
+    }
+
+
+    size_t getNumEquations() const
+    {
+        return _states.size();
+    }
+
+
+    /**
+     * @brief Names of the states, in the order of their equations.
+     *
+     * @return const std::vector<std::string>&
+     */
+    const std::vector<std::string>& getStates() const
+    {
+        return _states;
+    }
+
+
+    size_t getNumInstructions() const
+    {
+        return _code.size();
+    }
+
+
+    /**
+     * @brief Change the value of a parameter the equations use.
+     *
+     * @param name
+     * @param value
+     */
+    void setParameter(const std::string& name, T value)
+    {
+        if (!_params.count(name))
+            throw std::invalid_argument("Equations have no parameter '" + name + "'");
+        _paramValues[name] = value;
+    }
+
+
+    /**
+     * @brief Evaluate the equations for a batch of n states, stored by component:
+     * args[i * n + l] is argument i (t, y_1, ..., y_m) of state l, and
+     * out[i * n + l] is dy_(i+1)/dt of state l.
+     *
+     * @param args
+     * @param out
+     * @param n
+     */
+    void evalBatch(const T* args, T* out, size_t n) const
+    {
+        using std::tan; using std::sqrt; using std::abs;
+
+        thread_local std::vector<T> registers;
+        registers.resize(_registers * n);
+        T* R = registers.data();
+
+        for (size_t i = 0; i < (_states.size() + 1) * n; i++)
+            R[i] = args[i];
+        for (const std::pair<uint32_t, T>& c : _constants)
+            for (size_t l = 0; l < n; l++)
+                R[c.first * n + l] = c.second;
+        for (const std::pair<const std::string, uint32_t>& p : _params)
+        {
+            T value = _paramValues.at(p.first);
+            for (size_t l = 0; l < n; l++)
+                R[p.second * n + l] = value;
+        }
+
+        for (const _instruction_t& ins : _code)
+        {
+            T* _DIFFEQ_RESTRICT d = R + ins.dst * n;
+            const T* _DIFFEQ_RESTRICT a = R + ins.a * n;
+            const T* _DIFFEQ_RESTRICT b = R + ins.b * n;
+
+            switch (ins.op)
+            {
+                case _OP_ADD:   for (size_t l = 0; l < n; l++) d[l] = a[l] + b[l];      break;
+                case _OP_SUB:   for (size_t l = 0; l < n; l++) d[l] = a[l] - b[l];      break;
+                case _OP_MUL:   for (size_t l = 0; l < n; l++) d[l] = a[l] * b[l];      break;
+                case _OP_DIV:   for (size_t l = 0; l < n; l++) d[l] = a[l] / b[l];      break;
+                case _OP_POW:   vpow(a, b, d, n);                                       break;
+                case _OP_NEG:   for (size_t l = 0; l < n; l++) d[l] = -a[l];            break;
+                case _OP_SIN:   vsin(a, d, n);                                          break;
+                case _OP_COS:   vcos(a, d, n);                                          break;
+                case _OP_TAN:   for (size_t l = 0; l < n; l++) d[l] = tan(a[l]);        break;
+                case _OP_EXP:   vexp(a, d, n);                                          break;
+                case _OP_LOG:   vlog(a, d, n);                                          break;
+                case _OP_SQRT:  for (size_t l = 0; l < n; l++) d[l] = sqrt(a[l]);       break;
+                case _OP_TANH:  vtanh(a, d, n);                                         break;
+                case _OP_ABS:   for (size_t l = 0; l < n; l++) d[l] = abs(a[l]);        break;
+            }
+        }
+
+        for (size_t i = 0; i < _outputs.size(); i++)
+            for (size_t l = 0; l < n; l++)
+                out[i * n + l] = R[_outputs[i] * n + l];
+    }
+
+
+    void operator()(const std::vector<T>& args, std::vector<T>& out) const
+    {
+        out.resize(_states.size());
+        evalBatch(args.data(), out.data(), 1);
+    }
+
+
+    /**
+     * @brief The equations as the right hand side of an ODESystem, evaluated as a
+     * batch of one.
+     *
+     * @return systemFunction_t<T>
+     */
+    systemFunction_t<T> function() const
+    {
+        program_t<T> program(*this);
+        return systemFunction_t<T>([program](const std::vector<T>& args, std::vector<T>& out) {
+            program(args, out);
+        });
+    }
+
+
+    /**
+     * @brief The equations as the right hand side of an EnsembleSystem.
+     *
+     * @return batchFunction_t<T>
+     */
+    batchFunction_t<T> batchFunction() const
+    {
+        program_t<T> program(*this);
+        return batchFunction_t<T>([program](const T* args, T* out, size_t n) {
+            program.evalBatch(args, out, n);
+        });
+    }
+};
+
+
+} // namespace DES
+
+
+#endif
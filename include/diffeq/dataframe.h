@@ -4,6 +4,8 @@
 #include <cstddef>
 #include <iostream>
 #include <iomanip>
+#include <limits>
+#include <stdexcept>
 #include <tuple>
 #include <vector>
 
@@ -0,0 +1,353 @@
+#ifndef DIFFEQ_DDE_H
+#define DIFFEQ_DDE_H
+
+#include <functional>
+#include <stdexcept>
+#include <vector>
+
+#include "ode.h"
+#include "algorithms/dense.h"
+
+
+namespace DES
+{
+
+/**
+ * @brief Past values of a delay differential equation. The accepted steps are
+ * kept as their interpolants in a ring buffer, and steps that end more than
+ * maxDelay before the latest one are dropped, so memory stays bounded over long
+ * integrations. Times before the initial time come from the initial history
+ * function.
+ *
+ * @tparam T
+ */
+template <typename T>
+class history_t
+{
+
+private:
+    std::vector<denseStep_t<T>> _ring;
+    size_t _head = 0;
+    size_t _count = 0;
+
+    T _t0;
+    T _maxDelay;
+    std::function<std::vector<T>(T)> _initial;
+
+    denseStep_t<T>& _at(size_t k) { return _ring[(_head + k) % _ring.size()]; }
+    size_t _find(T t);
+
+public:
+    history_t() = default;
+    history_t(T t0, T maxDelay, std::function<std::vector<T>(T)> initial)
+        : _t0(t0)
+        , _maxDelay(maxDelay)
+        , _initial(initial)
+    { }
+
+    void            push        (denseStep_t<T>& step);
+    void            clear       ();
+    size_t          size        ();
+    std::vector<T>  operator()  (T t);
+    T               operator()  (T t, size_t i);
+};
+
+
+/**
+ * @brief std::function wrapper for the right hand side of a delay differential
+ * equation, dy_j/dt = f_j(t, y_1, ..., y_m, history). The history can be queried
+ * at any time t - tau with 0 < tau <= maxDelay, so both constant and state
+ * dependent delays are supported.
+ *
+ * @tparam T
+ */
+template <typename T>
+struct ddeFunction_t
+{
+    std::function<T(std::vector<T>, history_t<T>&)> _func;
+
+    ddeFunction_t(std::function<T(std::vector<T>, history_t<T>&)> func) {
+        _func = func;
+    }
+
+    T operator()(std::vector<T> args, history_t<T>& history)
+    {
+        return _func(args, history);
+    }
+};
+
+
+/**
+ * @brief A system of delay differential equations. maxDelay bounds every delay
+ * used by the functions and sets how much history is retained. If every delay
+ * is at least minDelay > 0, steps are limited to minDelay so that delayed values
+ * never fall inside the step being taken; otherwise they are extrapolated from
+ * the last accepted step.
+ *
+ * @tparam T
+ */
+template <typename T>
+class DDESystem
+{
+
+private:
+    std::vector<ddeFunction_t<T>> _functions;
+    timeBound_t<T> _timeBound;
+    iv_t<T> _iValues;
+    T _timeStep;
+    T _maxDelay;
+    T _minDelay;
+
+public:
+    history_t<T> history;
+
+    DDESystem() = default;
+    DDESystem(iv_t<T>& iValues, std::initializer_list<ddeFunction_t<T>> funcs, timeBound_t<T>& bounds, T timeStep,
+        T maxDelay, T minDelay = 0, std::function<std::vector<T>(T)> initialHistory = nullptr);
+
+    std::vector<T>  _eval(std::vector<T>& inputs);
+    ODESystem<T>    _getODESystem();
+    iv_t<T>         getInitialConditions();
+    timeBound_t<T>  getTimeBound();
+    T               getTimeStep();
+    T               getMaxDelay();
+    T               getMinDelay();
+    size_t          getNumEquations();
+};
+
+
+
+template <typename T>   DataFrame<T>  _RKF45    (DDESystem<T>& dde);
+template <typename T>   DataFrame<T>  _RKF45    (DDESystem<T>& dde, options_t<T> options);
+
+
+
+template <typename T>
+void history_t<T>::push(denseStep_t<T>& step)
+{
+    if (_count == _ring.size())
+    {
+        // grow, keeping the steps in time order
+        std::vector<denseStep_t<T>> ring(_ring.empty() ? 16 : 2 * _ring.size());
+        for (size_t k = 0; k < _count; k++)
+            ring[k] = _at(k);
+
+        _ring.swap(ring);
+        _head = 0;
+    }
+
+    _ring[(_head + _count) % _ring.size()] = step;
+    _count++;
+
+    // drop steps that no delay can reach any more
+    while (_count > 1 && _at(0).end() < step.end() - _maxDelay)
+    {
+        _head = (_head + 1) % _ring.size();
+        _count--;
+    }
+}
+
+
+template <typename T>
+void history_t<T>::clear()
+{
+    _head = 0;
+    _count = 0;
+}
+
+
+template <typename T>
+size_t history_t<T>::size()
+{
+    return _count;
+}
+
+
+/**
+ * @brief Index of the stored step that contains t, found by bisection. Times
+ * past the last step map to the last step, which is then extrapolated.
+ *
+ * @tparam T
+ * @param t
+ * @return size_t
+ */
+template <typename T>
+size_t history_t<T>::_find(T t)
+{
+    if (t < _at(0).begin())
+        throw std::out_of_range("Delay exceeds the maximum delay");
+
+    size_t lo = 0, hi = _count - 1;
+    while (lo < hi)
+    {
+        size_t mid = (lo + hi) / 2;
+        if (_at(mid).end() < t) lo = mid + 1;
+        else                    hi = mid;
+    }
+
+    return lo;
+}
+
+
+/**
+ * @brief Values of every component at a past time t.
+ *
+ * @tparam T
+ * @param t
+ * @return std::vector<T> Values of the form (t, y_1, ..., y_m).
+ */
+template <typename T>
+std::vector<T> history_t<T>::operator()(T t)
+{
+    if (t <= _t0 || _count == 0)
+        return _initial(t <= _t0 ? t : _t0);
+
+    return _at(_find(t))(t);
+}
+
+
+/**
+ * @brief Value of component i (1 <= i <= m) at a past time t.
+ *
+ * @tparam T
+ * @param t
+ * @param i
+ * @return T
+ */
+template <typename T>
+T history_t<T>::operator()(T t, size_t i)
+{
+    if (t <= _t0 || _count == 0)
+        return _initial(t <= _t0 ? t : _t0)[i];
+
+    return _at(_find(t)).eval(t, i);
+}
+
+
+
+template <typename T>
+DDESystem<T>::DDESystem(iv_t<T>& iValues, std::initializer_list<ddeFunction_t<T>> funcs, timeBound_t<T>& bounds, T timeStep,
+    T maxDelay, T minDelay, std::function<std::vector<T>(T)> initialHistory)
+    : _functions(funcs)
+    , _timeBound(bounds)
+    , _iValues(iValues)
+    , _timeStep(timeStep)
+    , _maxDelay(maxDelay)
+    , _minDelay(minDelay)
+{
+    if (!initialHistory)
+    {
+        // constant history equal to the initial conditions
+        std::vector<T> y0 = iValues.vec;
+        initialHistory = [y0](T t) {
+            std::vector<T> res(y0);
+            res[0] = t;
+            return res;
+        };
+    }
+
+    history = history_t<T>(bounds.first, maxDelay, initialHistory);
+}
+
+
+template <typename T>
+std::vector<T> DDESystem<T>::_eval(std::vector<T>& inputs)
+{
+    std::vector<T> res;
+    for (ddeFunction_t<T>& func : _functions)
+        res.push_back(func(inputs, history));
+
+    return res;
+}
+
+
+/**
+ * @brief View the system as an ODESystem whose functions read the current
+ * history, so the ODE steppers can be reused. The DDESystem must outlive it.
+ *
+ * @tparam T
+ * @return ODESystem<T>
+ */
+template <typename T>
+ODESystem<T> DDESystem<T>::_getODESystem()
+{
+    std::vector<function_t<T>> funcs;
+    for (size_t j = 0; j < _functions.size(); j++)
+        funcs.push_back(function_t<T>([this, j](std::vector<T> args) {
+            return _functions[j](args, history);
+        }));
+
+    return ODESystem<T>(_iValues, funcs, _timeBound, _timeStep);
+}
+
+
+template <typename T>
+iv_t<T> DDESystem<T>::getInitialConditions()
+{
+    return _iValues;
+}
+
+
+template <typename T>
+timeBound_t<T> DDESystem<T>::getTimeBound()
+{
+    return _timeBound;
+}
+
+
+template <typename T>
+T DDESystem<T>::getTimeStep()
+{
+    return _timeStep;
+}
+
+
+template <typename T>
+T DDESystem<T>::getMaxDelay()
+{
+    return _maxDelay;
+}
+
+
+template <typename T>
+T DDESystem<T>::getMinDelay()
+{
+    return _minDelay;
+}
+
+
+template <typename T>
+size_t DDESystem<T>::getNumEquations()
+{
+    return _functions.size();
+}
+
+
+template <typename T>
+DataFrame<T> solve(DDESystem<T>& eq, algorithm_t alg)
+{
+    switch (alg)
+    {
+        case ALGORITHM_RKF45:   return _RKF45(eq);
+
+        default:                throw std::runtime_error("Invalid algorithm");
+    }
+}
+
+
+template <typename T>
+DataFrame<T> solve(DDESystem<T>& eq, algorithm_t alg, options_t<T> options)
+{
+    switch (alg)
+    {
+        case ALGORITHM_RKF45:   return _RKF45(eq, options);
+
+        default:                throw std::runtime_error("Invalid algorithm");
+    }
+}
+
+
+} // namespace DES
+
+
+#endif
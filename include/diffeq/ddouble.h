@@ -0,0 +1,591 @@
+#ifndef DIFFEQ_DDOUBLE_H
+#define DIFFEQ_DDOUBLE_H
+
+#include <cmath>
+#include <limits>
+#include <ostream>
+#include <string>
+#include <type_traits>
+
+
+// Double-double arithmetic: a value is the unevaluated sum hi + lo of two
+// doubles with |lo| <= ulp(hi) / 2, which gives 106 bits (about 31 digits).
+// Every operation is built from the error free transformations of Dekker and
+// Knuth, as in the QD library of Hida, Li and Bailey (2001). Addition and
+// multiplication are branch free, and the exact product is one fma when the
+// target has it (-mfma or -march=native on x86-64). Each operation is still
+// several double operations, so ddouble is not faster than the x87 long double
+// in general; see the README for measurements. They rely on IEEE rounding, so
+// must not be compiled with -ffast-math (or /fp:fast).
+
+
+namespace DES
+{
+
+/**
+ * @brief s + e = a + b exactly, for any a and b.
+ *
+ * @param a
+ * @param b
+ * @param e
+ * @return double s = fl(a + b)
+ */
+inline double _twoSum(double a, double b, double& e)
+{
+    double s = a + b;
+    double bb = s - a;
+    e = (a - (s - bb)) + (b - bb);
+    return s;
+}
+
+
+/**
+ * @brief s + e = a + b exactly, for |a| >= |b|.
+ *
+ * @param a
+ * @param b
+ * @param e
+ * @return double
+ */
+inline double _quickTwoSum(double a, double b, double& e)
+{
+    double s = a + b;
+    e = b - (s - a);
+    return s;
+}
+
+
+/**
+ * @brief hi + lo = a exactly, with hi holding the upper 26 bits of the mantissa
+ * (Veltkamp's split). For |a| > 2^996 the scaled value overflows, and hi and lo
+ * are NaN.
+ *
+ * @param a
+ * @param hi
+ * @param lo
+ */
+inline void _split(double a, double& hi, double& lo)
+{
+    double t = 134217729.0 * a;     // 2^27 + 1
+    hi = t - (t - a);
+    lo = a - hi;
+}
+
+
+/**
+ * @brief p + e = a * b exactly. With a hardware fused multiply-add this is one
+ * fma. Otherwise std::fma is a call into libm, and Dekker's product of the split
+ * factors is used instead. A factor above 2^996 makes the split overflow, and
+ * e is then dropped rather than branched on, so such products are only double
+ * precision.
+ *
+ * @param a
+ * @param b
+ * @param e
+ * @return double
+ */
+inline double _twoProd(double a, double b, double& e)
+{
+    double p = a * b;
+
+#if defined(__FMA__) || defined(FP_FAST_FMA)
+    e = std::fma(a, b, -p);
+#else
+    double ah, al, bh, bl;
+    _split(a, ah, al);
+    _split(b, bh, bl);
+    e = ((ah * bh - p) + ah * bl + al * bh) + al * bl;
+    e = e == e ? e : 0;
+#endif
+
+    return p;
+}
+
+
+/**
+ * @brief Double-double scalar, usable as T by the solvers when
+ * DIFFEQ_DOUBLE_DOUBLE_PRECISION is defined.
+ *
+ */
+struct ddouble
+{
+    double hi;
+    double lo;
+
+    ddouble()                               : hi(0), lo(0) { }
+    ddouble(double h)                       : hi(h), lo(0) { }
+    ddouble(double h, double l)             : hi(h), lo(l) { }
+    ddouble(long double h)                  : hi((double)h), lo((double)(h - (long double)(double)h)) { }
+
+    // integers wider than 53 bits keep their low bits in lo
+    template <typename I, typename std::enable_if<std::is_integral<I>::value, int>::type = 0>
+    ddouble(I h)                            : hi((double)h), lo(0)
+    {
+        if (std::fabs(hi) < 0x1p63)
+            lo = h >= (I)hi ? (double)(h - (I)hi) : -(double)((I)hi - h);
+    }
+
+    explicit operator double() const        { return hi + lo; }
+    explicit operator float() const         { return (float)(hi + lo); }
+    explicit operator long double() const   { return (long double)hi + lo; }
+    explicit operator int() const           { return (int)_trunc(); }
+    explicit operator long() const          { return _trunc(); }
+    explicit operator unsigned long() const { return (unsigned long)_trunc(); }
+
+    // truncation toward zero: if hi is not an integer, lo cannot move hi + lo
+    // past the next integer, and otherwise lo alone decides the rounding
+    long _trunc() const
+    {
+        double t = std::trunc(hi);
+        if (t != hi)
+            return (long)t;
+
+        return (long)hi + (long)(hi > 0 ? std::floor(lo) : std::ceil(lo));
+    }
+
+    ddouble& operator+=(const ddouble& b);
+    ddouble& operator-=(const ddouble& b);
+    ddouble& operator*=(const ddouble& b);
+    ddouble& operator/=(const ddouble& b);
+};
+
+
+inline ddouble operator-(const ddouble& a)
+{
+    return ddouble(-a.hi, -a.lo);
+}
+
+
+inline ddouble operator+(const ddouble& a, const ddouble& b)
+{
+    double e, f;
+    double s = _twoSum(a.hi, b.hi, e);
+    double t = _twoSum(a.lo, b.lo, f);
+
+    e += t;
+    s = _quickTwoSum(s, e, e);
+    e += f;
+    s = _quickTwoSum(s, e, e);
+
+    return ddouble(s, e);
+}
+
+
+inline ddouble operator-(const ddouble& a, const ddouble& b)
+{
+    return a + (-b);
+}
+
+
+inline ddouble operator*(const ddouble& a, const ddouble& b)
+{
+    double e;
+    double p = _twoProd(a.hi, b.hi, e);
+
+    e += a.hi * b.lo + a.lo * b.hi;
+    p = _quickTwoSum(p, e, e);
+
+    return ddouble(p, e);
+}
+
+
+// scaling by a double skips the lo * lo terms
+inline ddouble operator*(const ddouble& a, double b)
+{
+    double e;
+    double p = _twoProd(a.hi, b, e);
+
+    e += a.lo * b;
+    p = _quickTwoSum(p, e, e);
+
+    return ddouble(p, e);
+}
+
+
+inline ddouble operator*(double a, const ddouble& b)
+{
+    return b * a;
+}
+
+
+inline ddouble operator/(const ddouble& a, const ddouble& b)
+{
+    // long division, one double digit at a time
+    double q1 = a.hi / b.hi;
+    ddouble r = a - b * q1;
+
+    double q2 = r.hi / b.hi;
+    r = r - b * q2;
+
+    double q3 = r.hi / b.hi;
+
+    double e;
+    q1 = _quickTwoSum(q1, q2, e);
+    return ddouble(q1, e) + ddouble(q3);
+}
+
+
+inline ddouble& ddouble::operator+=(const ddouble& b) { return *this = *this + b; }
+inline ddouble& ddouble::operator-=(const ddouble& b) { return *this = *this - b; }
+inline ddouble& ddouble::operator*=(const ddouble& b) { return *this = *this * b; }
+inline ddouble& ddouble::operator/=(const ddouble& b) { return *this = *this / b; }
+
+
+inline bool operator==(const ddouble& a, const ddouble& b) { return a.hi == b.hi && a.lo == b.lo; }
+inline bool operator!=(const ddouble& a, const ddouble& b) { return !(a == b); }
+inline bool operator< (const ddouble& a, const ddouble& b) { return a.hi < b.hi || (a.hi == b.hi && a.lo < b.lo); }
+inline bool operator> (const ddouble& a, const ddouble& b) { return b < a; }
+inline bool operator<=(const ddouble& a, const ddouble& b) { return !(b < a); }
+inline bool operator>=(const ddouble& a, const ddouble& b) { return !(a < b); }
+
+
+// the standard overloads stay visible next to the ddouble ones inside DES
+using std::abs;
+using std::fabs;
+using std::floor;
+using std::ceil;
+using std::sqrt;
+using std::exp;
+using std::log;
+using std::pow;
+using std::sin;
+using std::cos;
+using std::tan;
+using std::tanh;
+
+
+#define  _DD_PI             ddouble(3.141592653589793116e+00, 1.224646799147353207e-16)
+#define  _DD_2PI            ddouble(6.283185307179586232e+00, 2.449293598294706414e-16)
+#define  _DD_PI_2           ddouble(1.570796326794896558e+00, 6.123233995736766036e-17)
+#define  _DD_LN2            ddouble(6.931471805599452862e-01, 2.319046813846299558e-17)
+#define  _DD_EPSILON        4.93038065763132e-32        // 2^-104
+
+
+inline ddouble fabs(const ddouble& a)
+{
+    return a.hi < 0 ? -a : a;
+}
+
+
+inline ddouble abs(const ddouble& a)
+{
+    return fabs(a);
+}
+
+
+inline ddouble floor(const ddouble& a)
+{
+    double hi = std::floor(a.hi);
+    if (hi != a.hi)
+        return ddouble(hi);
+
+    // hi is integral, so only lo decides
+    double e;
+    hi = _quickTwoSum(hi, std::floor(a.lo), e);
+    return ddouble(hi, e);
+}
+
+
+inline ddouble ceil(const ddouble& a)
+{
+    return -floor(-a);
+}
+
+
+/**
+ * @brief Square root by one Newton step on the double result (Karp and
+ * Markstein, 1997).
+ *
+ * @param a
+ * @return ddouble
+ */
+inline ddouble sqrt(const ddouble& a)
+{
+    if (a.hi <= 0)
+        return ddouble(std::sqrt(a.hi));
+
+    double x = 1 / std::sqrt(a.hi);
+    double ax = a.hi * x;
+
+    ddouble diff = a - ddouble(ax) * ddouble(ax);
+    return ddouble(ax) + ddouble(diff.hi * x * 0.5);
+}
+
+
+/**
+ * @brief exp(a) = 2^k exp(r)^512, with a = k ln 2 + 512 r, and exp(r) from its
+ * Taylor series, which converges quickly for |r| <= ln(2) / 1024.
+ *
+ * @param a
+ * @return ddouble
+ */
+inline ddouble exp(const ddouble& a)
+{
+    if (a.hi > 709.78)
+        return ddouble(std::numeric_limits<double>::infinity());
+    if (a.hi < -745.2)
+        return ddouble(0);
+
+    double k = std::floor(a.hi / _DD_LN2.hi + 0.5);
+    ddouble r = (a - _DD_LN2 * k) * (1.0 / 512);
+
+    // exp(r) - 1, kept small so squaring does not lose the low bits
+    ddouble term = r, sum = r;
+    for (int n = 2; n < 20 && std::fabs(term.hi) > _DD_EPSILON * std::fabs(sum.hi); n++)
+    {
+        term = term * r / ddouble(n);
+        sum = sum + term;
+    }
+
+    // (1 + s)^2 - 1 = 2 s + s^2
+    for (int i = 0; i < 9; i++)
+        sum = sum * 2.0 + sum * sum;
+
+    sum = sum + ddouble(1);
+    return ddouble(std::ldexp(sum.hi, (int)k), std::ldexp(sum.lo, (int)k));
+}
+
+
+/**
+ * @brief Natural logarithm by one Newton step, x + a exp(-x) - 1, on the double
+ * logarithm.
+ *
+ * @param a
+ * @return ddouble
+ */
+inline ddouble log(const ddouble& a)
+{
+    if (a.hi <= 0)
+        return ddouble(std::log(a.hi));
+
+    ddouble x = std::log(a.hi);
+    return x + a * exp(-x) - ddouble(1);
+}
+
+
+inline ddouble pow(const ddouble& a, int n)
+{
+    ddouble base = n < 0 ? ddouble(1) / a : a;
+    ddouble res(1);
+
+    for (unsigned int k = n < 0 ? -(unsigned int)n : n; k > 0; k >>= 1)
+    {
+        if (k & 1)
+            res = res * base;
+        base = base * base;
+    }
+
+    return res;
+}
+
+
+inline ddouble pow(const ddouble& a, const ddouble& b)
+{
+    if (b == floor(b) && fabs(b).hi < 1024)
+        return pow(a, (int)b.hi);
+
+    return exp(b * log(a));
+}
+
+
+/**
+ * @brief sin and cos of a reduced argument |r| <= pi / 4, from their Taylor
+ * series.
+ *
+ * @param r
+ * @param s
+ * @param c
+ */
+inline void _sincosReduced(const ddouble& r, ddouble& s, ddouble& c)
+{
+    ddouble r2 = -(r * r);
+
+    ddouble term = r;
+    s = r;
+    for (int n = 2; std::fabs(term.hi) > _DD_EPSILON * 1e-2; n += 2)
+    {
+        term = term * r2 / ddouble((double)(n * (n + 1)));
+        s = s + term;
+    }
+
+    term = ddouble(1);
+    c = term;
+    for (int n = 1; std::fabs(term.hi) > _DD_EPSILON * 1e-2; n += 2)
+    {
+        term = term * r2 / ddouble((double)(n * (n + 1)));
+        c = c + term;
+    }
+}
+
+
+/**
+ * @brief sin(a) and cos(a). The argument is reduced modulo 2 pi and then to a
+ * quadrant; the reduction is accurate while |a| is small compared to 1e16.
+ *
+ * @param a
+ * @param s
+ * @param c
+ */
+inline void sincos(const ddouble& a, ddouble& s, ddouble& c)
+{
+    ddouble r = a - _DD_2PI * floor(a / _DD_2PI + ddouble(0.5));
+
+    double q = std::floor(r.hi / _DD_PI_2.hi + 0.5);
+    r = r - _DD_PI_2 * q;
+
+    ddouble sr, cr;
+    _sincosReduced(r, sr, cr);
+
+    switch (((int)q % 4 + 4) % 4)
+    {
+        case 0:  s = sr;   c = cr;   break;
+        case 1:  s = cr;   c = -sr;  break;
+        case 2:  s = -sr;  c = -cr;  break;
+        default: s = -cr;  c = sr;   break;
+    }
+}
+
+
+inline ddouble sin(const ddouble& a)
+{
+    ddouble s, c;
+    sincos(a, s, c);
+    return s;
+}
+
+
+inline ddouble cos(const ddouble& a)
+{
+    ddouble s, c;
+    sincos(a, s, c);
+    return c;
+}
+
+
+inline ddouble tan(const ddouble& a)
+{
+    ddouble s, c;
+    sincos(a, s, c);
+    return s / c;
+}
+
+
+inline ddouble tanh(const ddouble& a)
+{
+    if (fabs(a).hi > 40)
+        return ddouble(a.hi > 0 ? 1.0 : -1.0);
+
+    ddouble e = exp(a * 2.0);
+    return (e - ddouble(1)) / (e + ddouble(1));
+}
+
+
+/**
+ * @brief Decimal representation with the given number of significant digits.
+ *
+ * @param a
+ * @param digits
+ * @return std::string
+ */
+inline std::string _ddToString(ddouble a, int digits)
+{
+    if (a.hi != a.hi)
+        return "nan";
+    if (a.hi == 0)
+        return "0";
+    if (std::fabs(a.hi) == std::numeric_limits<double>::infinity())
+        return a.hi > 0 ? "inf" : "-inf";
+
+    std::string res = a.hi < 0 ? "-" : "";
+    a = fabs(a);
+
+    // scale into [1, 10)
+    int exponent = (int)std::floor(std::log10(a.hi));
+    a = a / pow(ddouble(10), exponent);
+    if (a.hi >= 10) { a = a / ddouble(10); exponent++; }
+    if (a.hi < 1)   { a = a * 10.0; exponent--; }
+
+    // one guard digit for rounding
+    std::string mantissa;
+    for (int i = 0; i <= digits; i++)
+    {
+        int d = (int)std::floor(a.hi);
+        if (d < 0) d = 0;
+        if (d > 9) d = 9;
+
+        mantissa += (char)('0' + d);
+        a = (a - ddouble(d)) * 10.0;
+    }
+
+    bool carry = mantissa[digits] >= '5';
+    mantissa.resize(digits);
+    for (int i = digits - 1; i >= 0 && carry; i--)
+    {
+        carry = mantissa[i] == '9';
+        mantissa[i] = carry ? '0' : mantissa[i] + 1;
+    }
+    if (carry)
+    {
+        mantissa.insert(mantissa.begin(), '1');
+        mantissa.resize(digits);
+        exponent++;
+    }
+
+    // fixed notation for moderate exponents, like the default stream format
+    if (exponent >= -5 && exponent < digits)
+    {
+        std::string fixed;
+        if (exponent < 0)
+            fixed = "0." + std::string(-exponent - 1, '0') + mantissa;
+        else
+            fixed = mantissa.substr(0, exponent + 1) + "." + mantissa.substr(exponent + 1);
+
+        size_t last = fixed.find_last_not_of('0');
+        fixed.erase(fixed[last] == '.' ? last : last + 1);
+        return res + fixed;
+    }
+
+    return res + mantissa.substr(0, 1) + "." + mantissa.substr(1) + "e" + std::to_string(exponent);
+}
+
+
+inline std::ostream& operator<<(std::ostream& os, const ddouble& a)
+{
+    int digits = os.precision() > 0 ? (int)os.precision() : 6;
+    return os << _ddToString(a, digits > 32 ? 32 : digits);
+}
+
+
+} // namespace DES
+
+
+namespace std
+{
+
+template <>
+class numeric_limits<DES::ddouble>
+{
+public:
+    static constexpr bool is_specialized = true;
+    static constexpr bool is_signed = true;
+    static constexpr bool is_integer = false;
+    static constexpr bool is_exact = false;
+    static constexpr bool has_infinity = true;
+    static constexpr bool has_quiet_NaN = true;
+    static constexpr int digits = 106;
+    static constexpr int digits10 = 31;
+    static constexpr int max_digits10 = 33;
+    static constexpr int radix = 2;
+
+    static DES::ddouble epsilon()       { return DES::ddouble(_DD_EPSILON); }
+    static DES::ddouble min()           { return DES::ddouble(numeric_limits<double>::min() * 0x1p53); }
+    static DES::ddouble max()           { return DES::ddouble(numeric_limits<double>::max(), 0x1.fffffffffffffp968); }
+    static DES::ddouble lowest()        { return -max(); }
+    static DES::ddouble infinity()      { return DES::ddouble(numeric_limits<double>::infinity()); }
+    static DES::ddouble quiet_NaN()     { return DES::ddouble(numeric_limits<double>::quiet_NaN()); }
+};
+
+} // namespace std
+
+
+#endif
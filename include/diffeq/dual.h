@@ -0,0 +1,441 @@
+#ifndef DIFFEQ_DUAL_H
+#define DIFFEQ_DUAL_H
+
+#include <cmath>
+#include <cstddef>
+#include <type_traits>
+#include <vector>
+
+#include "solver.h"
+#include "sparsity.h"
+
+
+// Forward mode automatic differentiation. A dual number carries a value and N
+// partial derivatives ("lanes"), so one evaluation of a function on duals
+// gives its derivatives along N directions at once, exact to rounding. The
+// Jacobian of an m equation system then costs ceil(m / N) evaluations instead
+// of the m of forward differences, and has no truncation error.
+//
+// Right hand sides that should be differentiated are written once, generic in
+// their scalar type, e.g. as a C++14 generic lambda
+//
+//      auto f = [](const auto& y, auto& out) { out[0] = y[2]; out[1] = -sin(y[1]); };
+//
+// and call the math functions unqualified, so the dual overloads are found.
+
+
+#define  _DUAL_CHUNK            8
+
+
+namespace DES
+{
+
+/**
+ * @brief Dual number with N derivative lanes.
+ *
+ * @tparam T
+ * @tparam N
+ */
+template <typename T, size_t N>
+struct dual_t
+{
+    typedef T value_type;
+
+    T value;
+    T grad[N];
+
+    dual_t() : value(0)
+    {
+        for (size_t l = 0; l < N; l++)
+            grad[l] = 0;
+    }
+
+    dual_t(const T& v) : value(v)
+    {
+        for (size_t l = 0; l < N; l++)
+            grad[l] = 0;
+    }
+
+    // constants such as 1 or 0.5, also when T is not a built-in type
+    template <typename S, typename std::enable_if<std::is_arithmetic<S>::value && !std::is_same<S, T>::value, int>::type = 0>
+    dual_t(S v) : dual_t(T(v))
+    { }
+
+    dual_t& operator+=(const dual_t& b) { return *this = *this + b; }
+    dual_t& operator-=(const dual_t& b) { return *this = *this - b; }
+    dual_t& operator*=(const dual_t& b) { return *this = *this * b; }
+    dual_t& operator/=(const dual_t& b) { return *this = *this / b; }
+};
+
+
+/**
+ * @brief Dual with the given value whose derivatives are df times those of x,
+ * the chain rule for f(x) with f'(x) = df.
+ *
+ * @tparam T
+ * @tparam N
+ * @param x
+ * @param f
+ * @param df
+ * @return dual_t<T, N>
+ */
+template <typename T, size_t N>
+inline dual_t<T, N> _dualChain(const dual_t<T, N>& x, const T& f, const T& df)
+{
+    dual_t<T, N> res(f);
+    for (size_t l = 0; l < N; l++)
+        res.grad[l] = df * x.grad[l];
+    return res;
+}
+
+
+template <typename T, size_t N>
+inline dual_t<T, N> operator-(const dual_t<T, N>& a)
+{
+    return _dualChain(a, T(-a.value), T(-1));
+}
+
+
+template <typename T, size_t N>
+inline dual_t<T, N> operator+(const dual_t<T, N>& a, const dual_t<T, N>& b)
+{
+    dual_t<T, N> res(a.value + b.value);
+    for (size_t l = 0; l < N; l++)
+        res.grad[l] = a.grad[l] + b.grad[l];
+    return res;
+}
+
+
+template <typename T, size_t N>
+inline dual_t<T, N> operator-(const dual_t<T, N>& a, const dual_t<T, N>& b)
+{
+    dual_t<T, N> res(a.value - b.value);
+    for (size_t l = 0; l < N; l++)
+        res.grad[l] = a.grad[l] - b.grad[l];
+    return res;
+}
+
+
+template <typename T, size_t N>
+inline dual_t<T, N> operator*(const dual_t<T, N>& a, const dual_t<T, N>& b)
+{
+    dual_t<T, N> res(a.value * b.value);
+    for (size_t l = 0; l < N; l++)
+        res.grad[l] = a.grad[l] * b.value + a.value * b.grad[l];
+    return res;
+}
+
+
+template <typename T, size_t N>
+inline dual_t<T, N> operator/(const dual_t<T, N>& a, const dual_t<T, N>& b)
+{
+    T inv = T(1) / b.value;
+    T q = a.value * inv;
+
+    dual_t<T, N> res(q);
+    for (size_t l = 0; l < N; l++)
+        res.grad[l] = (a.grad[l] - q * b.grad[l]) * inv;
+    return res;
+}
+
+
+// mixed operations with constants; the constant's type is not deduced, so
+// literals of any arithmetic type convert to T
+template <typename T, size_t N>
+inline dual_t<T, N> operator+(const dual_t<T, N>& a, const typename dual_t<T, N>::value_type& b)
+{
+    dual_t<T, N> res(a);
+    res.value = a.value + b;
+    return res;
+}
+
+
+template <typename T, size_t N>
+inline dual_t<T, N> operator+(const typename dual_t<T, N>::value_type& a, const dual_t<T, N>& b)
+{
+    return b + a;
+}
+
+
+template <typename T, size_t N>
+inline dual_t<T, N> operator-(const dual_t<T, N>& a, const typename dual_t<T, N>::value_type& b)
+{
+    dual_t<T, N> res(a);
+    res.value = a.value - b;
+    return res;
+}
+
+
+template <typename T, size_t N>
+inline dual_t<T, N> operator-(const typename dual_t<T, N>::value_type& a, const dual_t<T, N>& b)
+{
+    return _dualChain(b, T(a - b.value), T(-1));
+}
+
+
+template <typename T, size_t N>
+inline dual_t<T, N> operator*(const dual_t<T, N>& a, const typename dual_t<T, N>::value_type& b)
+{
+    return _dualChain(a, T(a.value * b), b);
+}
+
+
+template <typename T, size_t N>
+inline dual_t<T, N> operator*(const typename dual_t<T, N>::value_type& a, const dual_t<T, N>& b)
+{
+    return b * a;
+}
+
+
+template <typename T, size_t N>
+inline dual_t<T, N> operator/(const dual_t<T, N>& a, const typename dual_t<T, N>::value_type& b)
+{
+    T inv = T(1) / b;
+    return _dualChain(a, T(a.value * inv), inv);
+}
+
+
+template <typename T, size_t N>
+inline dual_t<T, N> operator/(const typename dual_t<T, N>::value_type& a, const dual_t<T, N>& b)
+{
+    T q = a / b.value;
+    return _dualChain(b, q, T(-q / b.value));
+}
+
+
+// comparisons only look at the value, so branches follow the primal path
+#define  _DUAL_COMPARE(op)                                                                                          \
+    template <typename T, size_t N>                                                                                 \
+    inline bool operator op(const dual_t<T, N>& a, const dual_t<T, N>& b) { return a.value op b.value; }           \
+    template <typename T, size_t N>                                                                                 \
+    inline bool operator op(const dual_t<T, N>& a, const typename dual_t<T, N>::value_type& b) { return a.value op b; } \
+    template <typename T, size_t N>                                                                                 \
+    inline bool operator op(const typename dual_t<T, N>::value_type& a, const dual_t<T, N>& b) { return a op b.value; }
+
+_DUAL_COMPARE(==)
+_DUAL_COMPARE(!=)
+_DUAL_COMPARE(<)
+_DUAL_COMPARE(>)
+_DUAL_COMPARE(<=)
+_DUAL_COMPARE(>=)
+
+#undef _DUAL_COMPARE
+
+
+// the standard overloads stay visible next to the dual ones inside DES
+using std::abs;
+using std::fabs;
+using std::sqrt;
+using std::exp;
+using std::log;
+using std::pow;
+using std::sin;
+using std::cos;
+using std::tan;
+using std::tanh;
+
+
+template <typename T, size_t N>
+inline dual_t<T, N> sin(const dual_t<T, N>& x)
+{
+    return _dualChain(x, T(sin(x.value)), T(cos(x.value)));
+}
+
+
+template <typename T, size_t N>
+inline dual_t<T, N> cos(const dual_t<T, N>& x)
+{
+    return _dualChain(x, T(cos(x.value)), T(-sin(x.value)));
+}
+
+
+template <typename T, size_t N>
+inline dual_t<T, N> tan(const dual_t<T, N>& x)
+{
+    T t = tan(x.value);
+    return _dualChain(x, t, T(1 + t * t));
+}
+
+
+template <typename T, size_t N>
+inline dual_t<T, N> exp(const dual_t<T, N>& x)
+{
+    T e = exp(x.value);
+    return _dualChain(x, e, e);
+}
+
+
+template <typename T, size_t N>
+inline dual_t<T, N> log(const dual_t<T, N>& x)
+{
+    return _dualChain(x, T(log(x.value)), T(T(1) / x.value));
+}
+
+
+template <typename T, size_t N>
+inline dual_t<T, N> sqrt(const dual_t<T, N>& x)
+{
+    T r = sqrt(x.value);
+    return _dualChain(x, r, T(T(0.5) / r));
+}
+
+
+template <typename T, size_t N>
+inline dual_t<T, N> tanh(const dual_t<T, N>& x)
+{
+    T t = tanh(x.value);
+    return _dualChain(x, t, T(1 - t * t));
+}
+
+
+template <typename T, size_t N>
+inline dual_t<T, N> fabs(const dual_t<T, N>& x)
+{
+    return x.value < 0 ? -x : x;
+}
+
+
+template <typename T, size_t N>
+inline dual_t<T, N> abs(const dual_t<T, N>& x)
+{
+    return fabs(x);
+}
+
+
+template <typename T, size_t N>
+inline dual_t<T, N> pow(const dual_t<T, N>& x, const typename dual_t<T, N>::value_type& p)
+{
+    T xp = pow(x.value, p);
+    return _dualChain(x, xp, T(p * pow(x.value, T(p - 1))));
+}
+
+
+template <typename T, size_t N>
+inline dual_t<T, N> pow(const dual_t<T, N>& x, const dual_t<T, N>& p)
+{
+    // x^p = exp(p log x), which needs x > 0 unless p has no derivatives
+    return exp(p * log(x));
+}
+
+
+/**
+ * @brief Jacobian of a system by forward mode automatic differentiation, for
+ * ODESystem::setJacobian. func is the right hand side written generically in
+ * its scalar type (see the top of this file); the Jacobian takes ceil(m / N)
+ * evaluations of it on dual numbers with N lanes.
+ *
+ * @tparam T
+ * @tparam N Lanes per evaluation.
+ * @tparam F
+ * @param func
+ * @return jacobianFunction_t<T>
+ */
+template <typename T, size_t N = _DUAL_CHUNK, typename F>
+jacobianFunction_t<T> autodiffJacobian(F func)
+{
+    return jacobianFunction_t<T>([func](const std::vector<T>& args, std::vector<T>& J) mutable {
+        typedef dual_t<T, N> D;
+        size_t m = args.size() - 1;
+
+        std::vector<D> x(args.begin(), args.end()), out(m);
+        J.assign(m * m, 0);
+
+        // seed the next N state components, one lane each
+        for (size_t c = 0; c < m; c += N)
+        {
+            size_t lanes = m - c < N ? m - c : N;
+            for (size_t l = 0; l < lanes; l++)
+                x[1 + c + l].grad[l] = 1;
+
+            func(x, out);
+
+            for (size_t i = 0; i < m; i++)
+                for (size_t l = 0; l < lanes; l++)
+                    J[i * m + c + l] = out[i].grad[l];
+
+            for (size_t l = 0; l < lanes; l++)
+                x[1 + c + l].grad[l] = 0;
+        }
+    });
+}
+
+
+/**
+ * @brief Jacobian with a known sparsity pattern by forward mode automatic
+ * differentiation. Each lane seeds a whole color group of columns, so the
+ * Jacobian takes ceil(colors / N) evaluations of func, independent of m for
+ * banded or otherwise local couplings.
+ *
+ * @tparam T
+ * @tparam N Lanes per evaluation.
+ * @tparam F
+ * @param func
+ * @param sparsity
+ * @return jacobianFunction_t<T>
+ */
+template <typename T, size_t N = _DUAL_CHUNK, typename F>
+jacobianFunction_t<T> autodiffJacobian(F func, sparsity_t sparsity)
+{
+    return jacobianFunction_t<T>([func, sparsity](const std::vector<T>& args, std::vector<T>& J) mutable {
+        typedef dual_t<T, N> D;
+        size_t m = args.size() - 1;
+        size_t colors = sparsity.getNumColors();
+
+        std::vector<D> x(args.begin(), args.end()), out(m);
+        J.assign(m * m, 0);
+
+        for (size_t c = 0; c < colors; c += N)
+        {
+            size_t lanes = colors - c < N ? colors - c : N;
+            for (size_t l = 0; l < lanes; l++)
+                for (size_t j : sparsity.groups[c + l])
+                    x[1 + j].grad[l] = 1;
+
+            func(x, out);
+
+            for (size_t l = 0; l < lanes; l++)
+                for (size_t j : sparsity.groups[c + l])
+                {
+                    for (size_t i : sparsity.columns[j])
+                        J[i * m + j] = out[i].grad[l];
+                    x[1 + j].grad[l] = 0;
+                }
+        }
+    });
+}
+
+
+/**
+ * @brief Jacobian-vector product of a system by forward mode automatic
+ * differentiation, for ODESystem::setJacobianVectorProduct. One evaluation of
+ * func on single lane duals, without forming the Jacobian.
+ *
+ * @tparam T
+ * @tparam F
+ * @param func
+ * @return jvpFunction_t<T>
+ */
+template <typename T, typename F>
+jvpFunction_t<T> autodiffJVP(F func)
+{
+    return jvpFunction_t<T>([func](const std::vector<T>& args, const std::vector<T>& v, std::vector<T>& out) mutable {
+        typedef dual_t<T, 1> D;
+        size_t m = args.size() - 1;
+
+        std::vector<D> x(args.begin(), args.end()), res(m);
+        for (size_t i = 0; i < m; i++)
+            x[i + 1].grad[0] = v[i];
+
+        func(x, res);
+
+        out.resize(m);
+        for (size_t i = 0; i < m; i++)
+            out[i] = res[i].grad[0];
+    });
+}
+
+
+} // namespace DES
+
+
+#endif
@@ -0,0 +1,177 @@
+#ifndef DIFFEQ_ENSEMBLE_H
+#define DIFFEQ_ENSEMBLE_H
+
+#include <stdexcept>
+#include <vector>
+
+#include "solver.h"
+#include "threadpool.h"
+
+
+namespace DES
+{
+
+/**
+ * @brief Many trajectories of the same system of first order ordinary
+ * differential equations, from different initial conditions, advanced together.
+ * The right hand side is a batchFunction_t (e.g. program_t::batchFunction, see
+ * bytecode.h), so every stage evaluates a whole batch of members in one call;
+ * see the batched methods in algorithms/batch.h.
+ *
+ * @tparam T
+ */
+template <typename T>
+class EnsembleSystem
+{
+
+private:
+    batchFunction_t<T> _func;
+    timeBound_t<T> _timeBound;
+    std::vector<iv_t<T>> _iValues;
+    size_t _equations;
+    T _timeStep;
+
+public:
+    EnsembleSystem(std::vector<iv_t<T>>& iValues, batchFunction_t<T> func, timeBound_t<T>& bounds, T timeStep);
+
+    void            _evalBatch(const T* args, T* out, size_t n);
+    iv_t<T>         getInitialConditions(size_t member);
+    timeBound_t<T>  getTimeBound();
+    T               getTimeStep();
+    size_t          getNumEquations();
+    size_t          getNumMembers();
+};
+
+
+
+template <typename T>   void            _RK4_batch      (EnsembleSystem<T>& ode, size_t first, size_t n, std::vector<T>& y);
+template <typename T>   DataFrame<T>    _RK4_ensemble   (EnsembleSystem<T>& ode, ThreadPool* pool);
+
+
+
+template <typename T>
+EnsembleSystem<T>::EnsembleSystem(std::vector<iv_t<T>>& iValues, batchFunction_t<T> func, timeBound_t<T>& bounds, T timeStep)
+    : _func(func)
+    , _timeBound(bounds)
+    , _iValues(iValues)
+    , _timeStep(timeStep)
+{
+    if (iValues.empty() || iValues[0].vec.size() < 2)
+        throw std::invalid_argument("Ensemble needs at least one member with one equation");
+
+    _equations = iValues[0].vec.size() - 1;
+    for (iv_t<T>& iv : iValues)
+        if (iv.vec.size() != _equations + 1)
+            throw std::invalid_argument("Ensemble members must have the same number of equations");
+
+    if (timeStep <= 0)
+        throw std::invalid_argument("Time step must be positive");
+}
+
+
+/**
+ * @brief Evaluate the right hand side for n members, stored by component, see
+ * batchFunction_t.
+ *
+ * @tparam T
+ * @param args
+ * @param out
+ * @param n
+ */
+template <typename T>
+void EnsembleSystem<T>::_evalBatch(const T* args, T* out, size_t n)
+{
+    _func(args, out, n);
+}
+
+
+/**
+ * @brief Initial conditions of one member. All members start at the beginning
+ * of the time bound, so their first entries are not used.
+ *
+ * @tparam T
+ * @param member
+ * @return iv_t<T>
+ */
+template <typename T>
+iv_t<T> EnsembleSystem<T>::getInitialConditions(size_t member)
+{
+    return _iValues.at(member);
+}
+
+
+template <typename T>
+timeBound_t<T> EnsembleSystem<T>::getTimeBound()
+{
+    return _timeBound;
+}
+
+
+template <typename T>
+T EnsembleSystem<T>::getTimeStep()
+{
+    return _timeStep;
+}
+
+
+template <typename T>
+size_t EnsembleSystem<T>::getNumEquations()
+{
+    return _equations;
+}
+
+
+template <typename T>
+size_t EnsembleSystem<T>::getNumMembers()
+{
+    return _iValues.size();
+}
+
+
+/**
+ * @brief Solve every member of the ensemble. The result has one row per member
+ * with its final state (t, y_1, ..., y_m).
+ *
+ * @tparam T
+ * @param eq
+ * @param alg
+ * @return DataFrame<T>
+ */
+template <typename T>
+DataFrame<T> solve(EnsembleSystem<T>& eq, algorithm_t alg)
+{
+    switch (alg)
+    {
+        case ALGORITHM_RK4:     return _RK4_ensemble(eq, (ThreadPool*)nullptr);
+
+        default:                throw std::runtime_error("Invalid algorithm");
+    }
+}
+
+
+/**
+ * @brief Solve every member of the ensemble, with the batches spread over the
+ * workers of pool. The right hand side must then be safe to call concurrently.
+ *
+ * @tparam T
+ * @param eq
+ * @param alg
+ * @param pool
+ * @return DataFrame<T>
+ */
+template <typename T>
+DataFrame<T> solve(EnsembleSystem<T>& eq, algorithm_t alg, ThreadPool& pool)
+{
+    switch (alg)
+    {
+        case ALGORITHM_RK4:     return _RK4_ensemble(eq, &pool);
+
+        default:                throw std::runtime_error("Invalid algorithm");
+    }
+}
+
+
+} // namespace DES
+
+
+#endif
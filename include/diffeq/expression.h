@@ -0,0 +1,671 @@
+#ifndef DIFFEQ_EXPRESSION_H
+#define DIFFEQ_EXPRESSION_H
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <tuple>
+#include <type_traits>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "solver.h"
+
+
+// Equations written as expressions of symbols instead of lambdas over args.
+// Every expression is an object whose type spells out its structure, e.g.
+//
+//  sin(o1 - o2)    _unary_t<_sinOp, _binary_t<_subOp, _symbol_t<1>, _symbol_t<2>>>
+//
+// so two equal subexpressions have the same type, wherever they appear. The
+// right hand side and the Jacobian are compiled from that: all subexpressions
+// of all equations are collected once, at compile time, into a list of distinct
+// types in evaluation order, and every entry of the list is evaluated once per
+// call, which eliminates the common subexpressions. The Jacobian is derived
+// symbolically with the same node types, so it shares them too (cos(o1 - o2) in
+// the derivatives of sin(o1 - o2), for instance).
+//
+// States, time and parameters are symbols. Numbers are either compile time
+// integers (2_c, constant<2>()), which take part in the elimination, or plain
+// literals, whose value is only known at run time. A literal keeps the type it
+// is written in, and is converted to T only when evaluated, so ddouble(1) / 10
+// is exact to 31 digits where 0.1 is not. Subexpressions holding a literal are
+// evaluated where they appear, without being shared, so constants that repeat
+// are best given as integers or parameters.
+
+
+namespace DES
+{
+
+/**
+ * @brief Argument I of (t, y_1, ..., y_m): the time for I = 0, a state otherwise.
+ */
+template <size_t I>
+struct _symbol_t { };
+
+
+/**
+ * @brief Parameter I, whose value is given when the equations are compiled.
+ */
+template <size_t I>
+struct _param_t { };
+
+
+/**
+ * @brief Integer constant known at compile time.
+ */
+template <long N>
+struct _int_t { };
+
+
+/**
+ * @brief Constant known at run time, of the number type V it is written in.
+ */
+template <typename V>
+struct _literal_t
+{
+    V value;
+};
+
+
+template <typename Op, typename A>
+struct _unary_t
+{
+    A a;
+};
+
+
+template <typename Op, typename A, typename B>
+struct _binary_t
+{
+    A a;
+    B b;
+};
+
+
+template <typename E> struct _isExpr                            : std::false_type { };
+template <size_t I> struct _isExpr<_symbol_t<I>>                : std::true_type { };
+template <size_t I> struct _isExpr<_param_t<I>>                 : std::true_type { };
+template <long N> struct _isExpr<_int_t<N>>                     : std::true_type { };
+template <typename V> struct _isExpr<_literal_t<V>>             : std::true_type { };
+template <typename Op, typename A> struct _isExpr<_unary_t<Op, A>>              : std::true_type { };
+template <typename Op, typename A, typename B> struct _isExpr<_binary_t<Op, A, B>> : std::true_type { };
+
+
+// whether a subexpression holds a run time literal
+template <typename E> struct _hasLiteral                        : std::false_type { };
+template <typename V> struct _hasLiteral<_literal_t<V>>         : std::true_type { };
+template <typename Op, typename A> struct _hasLiteral<_unary_t<Op, A>>          : _hasLiteral<A> { };
+template <typename Op, typename A, typename B> struct _hasLiteral<_binary_t<Op, A, B>>
+    : std::integral_constant<bool, _hasLiteral<A>::value || _hasLiteral<B>::value> { };
+
+
+// whether a subexpression depends on argument I
+template <typename E, size_t I> struct _dependsOn               : std::false_type { };
+template <size_t J, size_t I> struct _dependsOn<_symbol_t<J>, I> : std::integral_constant<bool, I == J> { };
+template <typename Op, typename A, size_t I> struct _dependsOn<_unary_t<Op, A>, I> : _dependsOn<A, I> { };
+template <typename Op, typename A, typename B, size_t I> struct _dependsOn<_binary_t<Op, A, B>, I>
+    : std::integral_constant<bool, _dependsOn<A, I>::value || _dependsOn<B, I>::value> { };
+
+
+// number of parameters a subexpression needs
+template <typename E> struct _numParams                         : std::integral_constant<size_t, 0> { };
+template <size_t I> struct _numParams<_param_t<I>>              : std::integral_constant<size_t, I + 1> { };
+template <typename Op, typename A> struct _numParams<_unary_t<Op, A>>           : _numParams<A> { };
+template <typename Op, typename A, typename B> struct _numParams<_binary_t<Op, A, B>>
+    : std::integral_constant<size_t, (_numParams<A>::value > _numParams<B>::value ? _numParams<A>::value : _numParams<B>::value)> { };
+
+
+// operations, evaluated on any scalar type with unqualified math functions
+struct _negOp   { template <typename T> static T apply(const T& a) { return -a; } };
+struct _sinOp   { template <typename T> static T apply(const T& a) { using std::sin; return sin(a); } };
+struct _cosOp   { template <typename T> static T apply(const T& a) { using std::cos; return cos(a); } };
+struct _tanOp   { template <typename T> static T apply(const T& a) { using std::tan; return tan(a); } };
+struct _expOp   { template <typename T> static T apply(const T& a) { using std::exp; return exp(a); } };
+struct _logOp   { template <typename T> static T apply(const T& a) { using std::log; return log(a); } };
+struct _sqrtOp  { template <typename T> static T apply(const T& a) { using std::sqrt; return sqrt(a); } };
+struct _tanhOp  { template <typename T> static T apply(const T& a) { using std::tanh; return tanh(a); } };
+
+struct _addOp   { template <typename T> static T apply(const T& a, const T& b) { return a + b; } };
+struct _subOp   { template <typename T> static T apply(const T& a, const T& b) { return a - b; } };
+struct _mulOp   { template <typename T> static T apply(const T& a, const T& b) { return a * b; } };
+struct _divOp   { template <typename T> static T apply(const T& a, const T& b) { return a / b; } };
+struct _powOp   { template <typename T> static T apply(const T& a, const T& b) { using std::pow; return pow(a, b); } };
+
+
+template <typename A>
+using _if_expr = typename std::enable_if<_isExpr<A>::value, int>::type;
+
+template <typename A, typename B>
+using _if_exprs = typename std::enable_if<_isExpr<A>::value && _isExpr<B>::value, int>::type;
+
+// an expression and a number V, built in or a class such as ddouble
+template <typename A, typename V>
+using _if_expr_literal = typename std::enable_if<_isExpr<A>::value && !_isExpr<V>::value
+    && std::is_constructible<double, V>::value, int>::type;
+
+
+// builders that fold integer constants and drop zeros and ones, which keeps
+// the derivatives small
+template <typename A> constexpr bool _isZero() { return std::is_same<A, _int_t<0>>::value; }
+template <typename A> constexpr bool _isOne()  { return std::is_same<A, _int_t<1>>::value; }
+
+
+template <typename A>
+auto _neg(A a)
+{
+    if constexpr (_isZero<A>())
+        return a;
+    else
+        return _unary_t<_negOp, A>{ a };
+}
+
+
+template <typename A, typename B>
+auto _add(A a, B b)
+{
+    if constexpr (_isZero<A>())
+        return b;
+    else if constexpr (_isZero<B>())
+        return a;
+    else
+        return _binary_t<_addOp, A, B>{ a, b };
+}
+
+
+template <typename A, typename B>
+auto _sub(A a, B b)
+{
+    if constexpr (_isZero<B>())
+        return a;
+    else if constexpr (_isZero<A>())
+        return _neg(b);
+    else
+        return _binary_t<_subOp, A, B>{ a, b };
+}
+
+
+template <typename A, typename B>
+auto _mul(A a, B b)
+{
+    if constexpr (_isZero<A>() || _isZero<B>())
+        return _int_t<0>{};
+    else if constexpr (_isOne<A>())
+        return b;
+    else if constexpr (_isOne<B>())
+        return a;
+    else
+        return _binary_t<_mulOp, A, B>{ a, b };
+}
+
+
+template <typename A, typename B>
+auto _div(A a, B b)
+{
+    if constexpr (_isZero<A>())
+        return _int_t<0>{};
+    else if constexpr (_isOne<B>())
+        return a;
+    else
+        return _binary_t<_divOp, A, B>{ a, b };
+}
+
+
+template <long N, long M> auto _add(_int_t<N>, _int_t<M>) { return _int_t<N + M>{}; }
+template <long N, long M> auto _sub(_int_t<N>, _int_t<M>) { return _int_t<N - M>{}; }
+template <long N, long M> auto _mul(_int_t<N>, _int_t<M>) { return _int_t<N * M>{}; }
+
+
+template <typename A, typename B, _if_exprs<A, B> = 0> auto operator+(A a, B b) { return _binary_t<_addOp, A, B>{ a, b }; }
+template <typename A, typename B, _if_exprs<A, B> = 0> auto operator-(A a, B b) { return _binary_t<_subOp, A, B>{ a, b }; }
+template <typename A, typename B, _if_exprs<A, B> = 0> auto operator*(A a, B b) { return _binary_t<_mulOp, A, B>{ a, b }; }
+template <typename A, typename B, _if_exprs<A, B> = 0> auto operator/(A a, B b) { return _binary_t<_divOp, A, B>{ a, b }; }
+template <typename A, _if_expr<A> = 0> auto operator-(A a) { return _unary_t<_negOp, A>{ a }; }
+
+template <typename A, typename V, _if_expr_literal<A, V> = 0> auto operator+(A a, V b) { return a + _literal_t<V>{ b }; }
+template <typename A, typename V, _if_expr_literal<A, V> = 0> auto operator+(V a, A b) { return _literal_t<V>{ a } + b; }
+template <typename A, typename V, _if_expr_literal<A, V> = 0> auto operator-(A a, V b) { return a - _literal_t<V>{ b }; }
+template <typename A, typename V, _if_expr_literal<A, V> = 0> auto operator-(V a, A b) { return _literal_t<V>{ a } - b; }
+template <typename A, typename V, _if_expr_literal<A, V> = 0> auto operator*(A a, V b) { return a * _literal_t<V>{ b }; }
+template <typename A, typename V, _if_expr_literal<A, V> = 0> auto operator*(V a, A b) { return _literal_t<V>{ a } * b; }
+template <typename A, typename V, _if_expr_literal<A, V> = 0> auto operator/(A a, V b) { return a / _literal_t<V>{ b }; }
+template <typename A, typename V, _if_expr_literal<A, V> = 0> auto operator/(V a, A b) { return _literal_t<V>{ a } / b; }
+
+
+using std::sin;
+using std::cos;
+using std::tan;
+using std::exp;
+using std::log;
+using std::sqrt;
+using std::tanh;
+using std::pow;
+
+
+template <typename A, _if_expr<A> = 0> auto sin(A a)  { return _unary_t<_sinOp, A>{ a }; }
+template <typename A, _if_expr<A> = 0> auto cos(A a)  { return _unary_t<_cosOp, A>{ a }; }
+template <typename A, _if_expr<A> = 0> auto tan(A a)  { return _unary_t<_tanOp, A>{ a }; }
+template <typename A, _if_expr<A> = 0> auto exp(A a)  { return _unary_t<_expOp, A>{ a }; }
+template <typename A, _if_expr<A> = 0> auto log(A a)  { return _unary_t<_logOp, A>{ a }; }
+template <typename A, _if_expr<A> = 0> auto sqrt(A a) { return _unary_t<_sqrtOp, A>{ a }; }
+template <typename A, _if_expr<A> = 0> auto tanh(A a) { return _unary_t<_tanhOp, A>{ a }; }
+
+template <typename A, typename B, _if_exprs<A, B> = 0> auto pow(A a, B b) { return _binary_t<_powOp, A, B>{ a, b }; }
+template <typename A, typename V, _if_expr_literal<A, V> = 0> auto pow(A a, V b) { return pow(a, _literal_t<V>{ b }); }
+
+
+/**
+ * @brief Integer constant that takes part in the elimination of common
+ * subexpressions, unlike a plain number.
+ *
+ * @tparam N
+ * @return _int_t<N>
+ */
+template <long N>
+_int_t<N> constant()
+{
+    return _int_t<N>{};
+}
+
+
+template <long N>
+constexpr long _parseDigits()
+{
+    return N;
+}
+
+
+template <long N, char D, char... Ds>
+constexpr long _parseDigits()
+{
+    static_assert(D >= '0' && D <= '9', "Integer constants take decimal digits only");
+    return _parseDigits<N * 10 + (D - '0'), Ds...>();
+}
+
+
+/**
+ * @brief 2_c is constant<2>().
+ */
+template <char... Ds>
+auto operator""_c()
+{
+    return _int_t<_parseDigits<0, Ds...>()>{};
+}
+
+
+template <size_t... I>
+auto _symbols(std::index_sequence<I...>)
+{
+    return std::make_tuple(_symbol_t<I + 1>{}...);
+}
+
+
+template <size_t... I>
+auto _params(std::index_sequence<I...>)
+{
+    return std::make_tuple(_param_t<I>{}...);
+}
+
+
+/**
+ * @brief Symbols of the states y_1, ..., y_M, to be unpacked with a structured
+ * binding: auto [x, v] = states<2>();
+ *
+ * @tparam M
+ * @return std::tuple<_symbol_t<1>, ..., _symbol_t<M>>
+ */
+template <size_t M>
+auto states()
+{
+    return _symbols(std::make_index_sequence<M>());
+}
+
+
+/**
+ * @brief Symbols of the parameters 0, ..., P - 1.
+ *
+ * @tparam P
+ * @return std::tuple<_param_t<0>, ..., _param_t<P - 1>>
+ */
+template <size_t P>
+auto parameters()
+{
+    return _params(std::make_index_sequence<P>());
+}
+
+
+/**
+ * @brief Symbol of the time t.
+ *
+ * @return _symbol_t<0>
+ */
+inline _symbol_t<0> timeSymbol()
+{
+    return _symbol_t<0>{};
+}
+
+
+// derivative of an expression with respect to argument I
+template <size_t I, size_t J> auto _diff(_symbol_t<J>)  { return _int_t<I == J ? 1 : 0>{}; }
+template <size_t I, size_t J> auto _diff(_param_t<J>)   { return _int_t<0>{}; }
+template <size_t I, long N> auto _diff(_int_t<N>)       { return _int_t<0>{}; }
+template <size_t I, typename V> auto _diff(_literal_t<V>) { return _int_t<0>{}; }
+
+
+template <size_t I, typename Op, typename A>
+auto _diff(_unary_t<Op, A> e)
+{
+    if constexpr (!_dependsOn<A, I>::value)
+        return _int_t<0>{};
+    else
+    {
+        auto da = _diff<I>(e.a);
+
+        if constexpr (std::is_same<Op, _negOp>::value)
+            return _neg(da);
+        else if constexpr (std::is_same<Op, _sinOp>::value)
+            return _mul(cos(e.a), da);
+        else if constexpr (std::is_same<Op, _cosOp>::value)
+            return _neg(_mul(sin(e.a), da));
+        else if constexpr (std::is_same<Op, _tanOp>::value)
+            return _div(da, _mul(cos(e.a), cos(e.a)));
+        else if constexpr (std::is_same<Op, _expOp>::value)
+            return _mul(e, da);
+        else if constexpr (std::is_same<Op, _logOp>::value)
+            return _div(da, e.a);
+        else if constexpr (std::is_same<Op, _sqrtOp>::value)
+            return _div(da, _mul(_int_t<2>{}, e));
+        else
+            return _mul(_sub(_int_t<1>{}, _mul(e, e)), da);
+    }
+}
+
+
+template <size_t I, typename Op, typename A, typename B>
+auto _diff(_binary_t<Op, A, B> e)
+{
+    if constexpr (!_dependsOn<A, I>::value && !_dependsOn<B, I>::value)
+        return _int_t<0>{};
+    else
+    {
+        auto da = _diff<I>(e.a);
+        auto db = _diff<I>(e.b);
+
+        if constexpr (std::is_same<Op, _addOp>::value)
+            return _add(da, db);
+        else if constexpr (std::is_same<Op, _subOp>::value)
+            return _sub(da, db);
+        else if constexpr (std::is_same<Op, _mulOp>::value)
+            return _add(_mul(da, e.b), _mul(e.a, db));
+        else if constexpr (std::is_same<Op, _divOp>::value)
+            return _sub(_div(da, e.b), _div(_mul(e, db), e.b));
+        else if constexpr (!_dependsOn<B, I>::value)
+            return _mul(_mul(e.b, pow(e.a, _sub(e.b, _int_t<1>{}))), da);     // b a^(b - 1) a'
+        else
+            return _mul(e, _add(_mul(db, log(e.a)), _div(_mul(e.b, da), e.a)));
+    }
+}
+
+
+template <typename... Ts>
+struct _typeList
+{
+    static constexpr size_t size = sizeof...(Ts);
+};
+
+
+template <typename L, typename X> struct _listAppend;
+template <typename X, typename... Ts>
+struct _listAppend<_typeList<Ts...>, X>
+{
+    typedef typename std::conditional<(std::is_same<X, Ts>::value || ...), _typeList<Ts...>, _typeList<Ts..., X>>::type type;
+};
+
+
+template <typename L, typename X> struct _listIndex;
+template <typename X, typename... Ts>
+struct _listIndex<_typeList<X, Ts...>, X> : std::integral_constant<size_t, 0> { };
+template <typename X, typename Y, typename... Ts>
+struct _listIndex<_typeList<Y, Ts...>, X> : std::integral_constant<size_t, 1 + _listIndex<_typeList<Ts...>, X>::value> { };
+
+
+// a subexpression is shared if it is an operation without literals
+template <typename E> struct _isShared                          : std::false_type { };
+template <typename Op, typename A> struct _isShared<_unary_t<Op, A>>             : std::integral_constant<bool, !_hasLiteral<A>::value> { };
+template <typename Op, typename A, typename B> struct _isShared<_binary_t<Op, A, B>>
+    : std::integral_constant<bool, !_hasLiteral<_binary_t<Op, A, B>>::value> { };
+
+
+// shared subexpressions of E appended to L, children before parents
+template <typename L, typename E>
+struct _collect
+{
+    typedef L type;
+};
+
+template <typename L, typename Op, typename A>
+struct _collect<L, _unary_t<Op, A>>
+{
+    typedef typename _collect<L, A>::type inner;
+    typedef typename std::conditional<_isShared<_unary_t<Op, A>>::value,
+        typename _listAppend<inner, _unary_t<Op, A>>::type, inner>::type type;
+};
+
+template <typename L, typename Op, typename A, typename B>
+struct _collect<L, _binary_t<Op, A, B>>
+{
+    typedef typename _collect<typename _collect<L, A>::type, B>::type inner;
+    typedef typename std::conditional<_isShared<_binary_t<Op, A, B>>::value,
+        typename _listAppend<inner, _binary_t<Op, A, B>>::type, inner>::type type;
+};
+
+
+template <typename L, typename... Es> struct _collectAll { typedef L type; };
+template <typename L, typename E, typename... Es>
+struct _collectAll<L, E, Es...>
+{
+    typedef typename _collectAll<typename _collect<L, E>::type, Es...>::type type;
+};
+
+
+/**
+ * @brief Values an expression is evaluated with: the arguments, the parameters
+ * and the shared subexpressions of the list L computed so far.
+ */
+template <typename T, typename L>
+struct _exprContext_t
+{
+    const std::vector<T>& args;
+    const std::vector<T>& params;
+    std::array<T, L::size> values;
+};
+
+
+template <typename T, typename L, size_t I> T _evalExpr(const _symbol_t<I>&, _exprContext_t<T, L>& ctx) { return ctx.args[I]; }
+template <typename T, typename L, size_t I> T _evalExpr(const _param_t<I>&, _exprContext_t<T, L>& ctx)  { return ctx.params[I]; }
+template <typename T, typename L, long N> T _evalExpr(const _int_t<N>&, _exprContext_t<T, L>&)          { return T(N); }
+template <typename T, typename L, typename V> T _evalExpr(const _literal_t<V>& e, _exprContext_t<T, L>&) { return T(e.value); }
+
+
+template <typename T, typename L, typename Op, typename A>
+T _applyExpr(const _unary_t<Op, A>& e, _exprContext_t<T, L>& ctx)
+{
+    return Op::apply(_evalExpr(e.a, ctx));
+}
+
+
+template <typename T, typename L, typename Op, typename A, typename B>
+T _applyExpr(const _binary_t<Op, A, B>& e, _exprContext_t<T, L>& ctx)
+{
+    return Op::apply(_evalExpr(e.a, ctx), _evalExpr(e.b, ctx));
+}
+
+
+template <typename T, typename L, typename Op, typename A>
+T _evalExpr(const _unary_t<Op, A>& e, _exprContext_t<T, L>& ctx)
+{
+    if constexpr (_isShared<_unary_t<Op, A>>::value)
+        return ctx.values[_listIndex<L, _unary_t<Op, A>>::value];
+    else
+        return _applyExpr(e, ctx);
+}
+
+
+template <typename T, typename L, typename Op, typename A, typename B>
+T _evalExpr(const _binary_t<Op, A, B>& e, _exprContext_t<T, L>& ctx)
+{
+    if constexpr (_isShared<_binary_t<Op, A, B>>::value)
+        return ctx.values[_listIndex<L, _binary_t<Op, A, B>>::value];
+    else
+        return _applyExpr(e, ctx);
+}
+
+
+// shared subexpressions hold no literal, so their value follows from their type
+template <typename T, typename L, typename... Ns>
+void _evalShared(_typeList<Ns...>, _exprContext_t<T, L>& ctx)
+{
+    size_t k = 0;
+    ((ctx.values[k++] = _applyExpr(Ns{}, ctx)), ...);
+}
+
+
+/**
+ * @brief Expressions evaluated together, each shared subexpression once.
+ *
+ * @tparam Es
+ */
+template <typename... Es>
+struct _fused_t
+{
+    typedef typename _collectAll<_typeList<>, Es...>::type shared;
+
+    std::tuple<Es...> exprs;
+
+    template <typename T, size_t... K>
+    void _eval(const std::vector<T>& args, const std::vector<T>& params, std::vector<T>& out, std::index_sequence<K...>) const
+    {
+        _exprContext_t<T, shared> ctx{ args, params, {} };
+        _evalShared(shared(), ctx);
+        ((out[K] = _evalExpr(std::get<K>(exprs), ctx)), ...);
+    }
+
+    template <typename T>
+    void operator()(const std::vector<T>& args, const std::vector<T>& params, std::vector<T>& out) const
+    {
+        out.resize(sizeof...(Es));
+        _eval(args, params, out, std::index_sequence_for<Es...>());
+    }
+};
+
+
+template <typename... Es>
+_fused_t<Es...> _fuse(std::tuple<Es...> exprs)
+{
+    return _fused_t<Es...>{ exprs };
+}
+
+
+/**
+ * @brief Right hand side dy_i/dt = E_i given by expressions of the states, the
+ * time and parameters. It compiles to a systemFunction_t that evaluates all
+ * equations in one pass, and to their Jacobian, derived symbolically.
+ *
+ * @tparam Es
+ */
+template <typename... Es>
+struct equations_t
+{
+    static constexpr size_t m = sizeof...(Es);
+
+    std::tuple<Es...> exprs;
+
+    template <size_t... K>
+    auto _jacobianExprs(std::index_sequence<K...>) const
+    {
+        return std::make_tuple(_diff<K % m + 1>(std::get<K / m>(exprs))...);
+    }
+
+
+    template <typename T>
+    static void _checkParams(const std::vector<T>& params)
+    {
+        if (params.size() < std::max({ (size_t)0, _numParams<Es>::value... }))
+            throw std::invalid_argument("Missing parameter values");
+    }
+
+
+    /**
+     * @brief Fused right hand side.
+     *
+     * @tparam T
+     * @param params Values of the parameters.
+     * @return systemFunction_t<T>
+     */
+    template <typename T>
+    systemFunction_t<T> function(std::vector<T> params = {}) const
+    {
+        _checkParams(params);
+
+        _fused_t<Es...> f = _fuse(exprs);
+        return systemFunction_t<T>([f, params](const std::vector<T>& args, std::vector<T>& out) {
+            f(args, params, out);
+        });
+    }
+
+
+    /**
+     * @brief Jacobian df/dy from the symbolic derivatives, evaluated in one pass
+     * with its own shared subexpressions, for setJacobian.
+     *
+     * @tparam T
+     * @param params Values of the parameters.
+     * @return jacobianFunction_t<T>
+     */
+    template <typename T>
+    jacobianFunction_t<T> jacobian(std::vector<T> params = {}) const
+    {
+        _checkParams(params);
+
+        auto J = _fuse(_jacobianExprs(std::make_index_sequence<m * m>()));
+        return jacobianFunction_t<T>([J, params](const std::vector<T>& args, std::vector<T>& out) {
+            J(args, params, out);
+        });
+    }
+
+
+    /**
+     * @brief Number of distinct subexpressions the right hand side is evaluated
+     * with (operations that hold no literal).
+     *
+     * @return size_t
+     */
+    static constexpr size_t getNumShared()
+    {
+        return _fused_t<Es...>::shared::size;
+    }
+};
+
+
+/**
+ * @brief Equations dy_1/dt = e_1, ..., dy_m/dt = e_m, in the order of the
+ * states.
+ *
+ * @tparam Es
+ * @param e
+ * @return equations_t<Es...>
+ */
+template <typename... Es>
+equations_t<Es...> equations(Es... e)
+{
+    static_assert((_isExpr<Es>::value && ...), "Equations must be expressions of symbols");
+    return equations_t<Es...>{ std::make_tuple(e...) };
+}
+
+
+} // namespace DES
+
+
+#endif
@@ -0,0 +1,238 @@
+#ifndef DIFFEQ_LINALG_BANDED_H
+#define DIFFEQ_LINALG_BANDED_H
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+#include "lu.h"
+
+
+// Band storage of an n x n matrix with kl subdiagonals and ku superdiagonals:
+// row i keeps the columns i - kl, ..., i + ku + kl, and entry (i, j) is
+//
+//  A[i * (2 kl + ku + 1) + j - i + kl]
+//
+// The extra kl columns to the right of the band take the fill-in of the upper
+// factor from row interchanges, so the factorization is done in place. Banded
+// LU costs O(n kl (kl + ku)) instead of O(n^3).
+
+
+namespace DES
+{
+
+/**
+ * @brief Number of entries per row of the band storage.
+ *
+ * @param kl
+ * @param ku
+ * @return size_t
+ */
+inline size_t _bandWidth(size_t kl, size_t ku)
+{
+    return 2 * kl + ku + 1;
+}
+
+
+/**
+ * @brief LU decomposition with partial pivoting of a banded matrix in band
+ * storage, in place. As in LAPACK's gbtrf, the interchanges are not applied to
+ * the multipliers of earlier columns, so _bandSolve applies them one column at
+ * a time; piv[k] is the row that was swapped with row k.
+ *
+ * @tparam T
+ * @param A
+ * @param n
+ * @param kl
+ * @param ku
+ * @param piv
+ * @return bool False if the matrix is singular.
+ */
+template <typename T>
+bool _bandDecompose(std::vector<T>& A, size_t n, size_t kl, size_t ku, std::vector<size_t>& piv)
+{
+    size_t w = _bandWidth(kl, ku);
+    piv.resize(n);
+
+    for (size_t k = 0; k < n; k++)
+    {
+        size_t last = std::min(n - 1, k + kl);          // last row below the pivot
+        size_t right = std::min(n - 1, k + kl + ku);    // last column of the pivot row
+
+        size_t p = k;
+        T best = A[k * w + kl] >= 0 ? A[k * w + kl] : -A[k * w + kl];
+        for (size_t i = k + 1; i <= last; i++)
+        {
+            T a = A[i * w + k - i + kl] >= 0 ? A[i * w + k - i + kl] : -A[i * w + k - i + kl];
+            if (a > best) { best = a; p = i; }
+        }
+
+        piv[k] = p;
+        if (best == 0)
+            return false;
+
+        if (p != k)
+            for (size_t j = k; j <= right; j++)
+                std::swap(A[k * w + j - k + kl], A[p * w + j - p + kl]);
+
+        T inv = 1 / A[k * w + kl];
+        for (size_t i = k + 1; i <= last; i++)
+        {
+            T* row = &A[i * w + kl - i];
+            const T* pivot = &A[k * w + kl - k];
+
+            T l = row[k] *= inv;
+            for (size_t j = k + 1; j <= right; j++)
+                row[j] -= l * pivot[j];
+        }
+    }
+
+    return true;
+}
+
+
+/**
+ * @brief Solve A x = b in place, given the factors from _bandDecompose.
+ *
+ * @tparam T
+ * @param LU
+ * @param n
+ * @param kl
+ * @param ku
+ * @param piv
+ * @param b Right hand side, overwritten with the solution.
+ */
+template <typename T>
+void _bandSolve(std::vector<T>& LU, size_t n, size_t kl, size_t ku, std::vector<size_t>& piv, std::vector<T>& b)
+{
+    size_t w = _bandWidth(kl, ku);
+
+    for (size_t k = 0; k < n; k++)
+    {
+        if (piv[k] != k)
+            std::swap(b[k], b[piv[k]]);
+
+        for (size_t i = k + 1; i <= std::min(n - 1, k + kl); i++)
+            b[i] -= LU[i * w + k - i + kl] * b[k];
+    }
+
+    for (size_t i = n; i-- > 0;)
+    {
+        for (size_t j = i + 1; j <= std::min(n - 1, i + kl + ku); j++)
+            b[i] -= LU[i * w + j - i + kl] * b[j];
+        b[i] /= LU[i * w + kl];
+    }
+}
+
+
+/**
+ * @brief Block LU of a block tridiagonal matrix with N diagonal blocks of size
+ * bs (the block Thomas algorithm), in place. Each of L, D and U holds N blocks
+ * of bs x bs entries, row major, one after the other: L[k] is left of D[k] and
+ * U[k] right of it, so L[0] and U[N - 1] are not used.
+ *
+ * Afterwards D[k] holds the LU factors of the k-th pivot block
+ * D[k] - L[k] U'[k - 1], and U[k] holds U'[k] = D'[k]^-1 U[k]. Pivoting is only
+ * done within the blocks, which is stable for block diagonally dominant
+ * matrices. The cost is O(N bs^3).
+ *
+ * @tparam T
+ * @param L
+ * @param D
+ * @param U
+ * @param N
+ * @param bs
+ * @param piv Pivots of the diagonal blocks, bs per block.
+ * @return bool False if a pivot block is singular.
+ */
+template <typename T>
+bool _blockTridiagonalDecompose(std::vector<T>& L, std::vector<T>& D, std::vector<T>& U, size_t N, size_t bs,
+    std::vector<size_t>& piv)
+{
+    size_t bb = bs * bs;
+    std::vector<T> block(bb), rhs(bb);
+    std::vector<size_t> p;
+
+    piv.resize(N * bs);
+
+    for (size_t k = 0; k < N; k++)
+    {
+        if (k > 0)
+        {
+            // D[k] -= L[k] U'[k - 1]
+            for (size_t i = 0; i < bs; i++)
+                for (size_t l = 0; l < bs; l++)
+                {
+                    T a = L[k * bb + i * bs + l];
+                    for (size_t j = 0; j < bs; j++)
+                        D[k * bb + i * bs + j] -= a * U[(k - 1) * bb + l * bs + j];
+                }
+        }
+
+        std::copy(D.begin() + k * bb, D.begin() + (k + 1) * bb, block.begin());
+        if (!_luDecompose(block, bs, p))
+            return false;
+
+        std::copy(block.begin(), block.end(), D.begin() + k * bb);
+        std::copy(p.begin(), p.end(), piv.begin() + k * bs);
+
+        if (k + 1 < N)
+        {
+            std::copy(U.begin() + k * bb, U.begin() + (k + 1) * bb, rhs.begin());
+            _luSolve(block, bs, p, rhs, bs);
+            std::copy(rhs.begin(), rhs.end(), U.begin() + k * bb);
+        }
+    }
+
+    return true;
+}
+
+
+/**
+ * @brief Solve A x = b in place, given the factors from
+ * _blockTridiagonalDecompose.
+ *
+ * @tparam T
+ * @param L
+ * @param D
+ * @param U
+ * @param N
+ * @param bs
+ * @param piv
+ * @param b Right hand side of N bs entries, overwritten with the solution.
+ */
+template <typename T>
+void _blockTridiagonalSolve(std::vector<T>& L, std::vector<T>& D, std::vector<T>& U, size_t N, size_t bs,
+    std::vector<size_t>& piv, std::vector<T>& b)
+{
+    size_t bb = bs * bs;
+    std::vector<T> block(bb), x(bs);
+    std::vector<size_t> p(bs);
+
+    for (size_t k = 0; k < N; k++)
+    {
+        for (size_t i = 0; i < bs; i++)
+        {
+            x[i] = b[k * bs + i];
+            for (size_t j = 0; k > 0 && j < bs; j++)
+                x[i] -= L[k * bb + i * bs + j] * b[(k - 1) * bs + j];
+        }
+
+        std::copy(D.begin() + k * bb, D.begin() + (k + 1) * bb, block.begin());
+        std::copy(piv.begin() + k * bs, piv.begin() + (k + 1) * bs, p.begin());
+        _luSolve(block, bs, p, x);
+
+        std::copy(x.begin(), x.end(), b.begin() + k * bs);
+    }
+
+    for (size_t k = N - 1; k-- > 0;)
+        for (size_t i = 0; i < bs; i++)
+            for (size_t j = 0; j < bs; j++)
+                b[k * bs + i] -= U[k * bb + i * bs + j] * b[(k + 1) * bs + j];
+}
+
+
+} // namespace DES
+
+
+#endif
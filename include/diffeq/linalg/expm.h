@@ -0,0 +1,168 @@
+#ifndef DIFFEQ_LINALG_EXPM_H
+#define DIFFEQ_LINALG_EXPM_H
+
+#include <limits>
+#include <stdexcept>
+#include <vector>
+
+#include "lu.h"
+#include "../restrict.h"
+
+
+namespace DES
+{
+
+/**
+ * @brief C = A B for n x n matrices, row major. C must not alias A or B.
+ *
+ * @tparam T
+ * @param A
+ * @param B
+ * @param C
+ * @param n
+ */
+template <typename T>
+void _matMul(const std::vector<T>& A, const std::vector<T>& B, std::vector<T>& C, size_t n)
+{
+    C.assign(n * n, 0);
+
+    for (size_t i = 0; i < n; i++)
+    {
+        T* _DIFFEQ_RESTRICT ci = C.data() + i * n;
+        for (size_t k = 0; k < n; k++)
+        {
+            const T* _DIFFEQ_RESTRICT bk = B.data() + k * n;
+            T a = A[i * n + k];
+            for (size_t j = 0; j < n; j++)
+                ci[j] += a * bk[j];
+        }
+    }
+}
+
+
+/**
+ * @brief Largest 1-norm of h A for which the [13/13] Pade approximant of e^(hA)
+ * is exact to the precision of T (Higham, 2005). 5.37 is his value for double;
+ * the others follow from the leading term of the same backward error bound,
+ * (13!)^2 / (26! 27!) theta^26 <= u, for 64 and 106 bit mantissas.
+ *
+ * @tparam T
+ * @return T
+ */
+template <typename T>
+T _expmTheta()
+{
+    T eps = std::numeric_limits<T>::epsilon();
+
+    if (eps > (T)1e-17)
+        return (T)5.371920351148152;
+    if (eps > (T)1e-25)
+        return (T)3.9;
+    return (T)1.3;
+}
+
+
+/**
+ * @brief Matrix exponential of the n x n matrix A, row major, by scaling and
+ * squaring with the [13/13] Pade approximant: A is divided by 2^s until its
+ * 1-norm is below _expmTheta, e^(A / 2^s) is the solution R of
+ * (V - U) R = V + U, with U and V the odd and even parts of the approximant,
+ * and R is squared s times.
+ *
+ * @tparam T
+ * @param A
+ * @param n
+ * @return std::vector<T> e^A, row major.
+ */
+template <typename T>
+std::vector<T> _expm(const std::vector<T>& A, size_t n)
+{
+    static const T b[] = {
+        (T)64764752532480000.0, (T)32382376266240000.0, (T)7771770303897600.0, (T)1187353796428800.0,
+        (T)129060195264000.0, (T)10559470521600.0, (T)670442572800.0, (T)33522128640.0,
+        (T)1323241920.0, (T)40840800.0, (T)960960.0, (T)16380.0, (T)182.0, (T)1.0
+    };
+
+    if (A.size() != n * n)
+        throw std::invalid_argument("Matrix must be n x n");
+
+    T norm = 0;
+    for (size_t j = 0; j < n; j++)
+    {
+        T col = 0;
+        for (size_t i = 0; i < n; i++)
+            col += A[i * n + j] < 0 ? -A[i * n + j] : A[i * n + j];
+        norm = col > norm ? col : norm;
+    }
+
+    if (!(norm < std::numeric_limits<T>::infinity()))
+        throw std::runtime_error("Matrix exponential of a matrix that is not finite");
+
+    // halving is exact, so A / 2^s loses nothing
+    size_t s = 0;
+    T scale = 1;
+    for (T theta = _expmTheta<T>(); norm > theta; norm /= 2, scale /= 2)
+        s++;
+
+    std::vector<T> A1(A), A2, A4, A6, W, Z, U, V;
+    for (T& a : A1)
+        a *= scale;
+
+    _matMul(A1, A1, A2, n);
+    _matMul(A2, A2, A4, n);
+    _matMul(A2, A4, A6, n);
+
+    // U = A1 (A6 (b13 A6 + b11 A4 + b9 A2) + b7 A6 + b5 A4 + b3 A2 + b1 I)
+    // V = A6 (b12 A6 + b10 A4 + b8 A2) + b6 A6 + b4 A4 + b2 A2 + b0 I
+    W.resize(n * n);
+    Z.resize(n * n);
+    for (size_t k = 0; k < n * n; k++)
+    {
+        W[k] = b[13] * A6[k] + b[11] * A4[k] + b[9] * A2[k];
+        Z[k] = b[12] * A6[k] + b[10] * A4[k] + b[8] * A2[k];
+    }
+
+    _matMul(A6, W, U, n);
+    _matMul(A6, Z, V, n);
+
+    for (size_t k = 0; k < n * n; k++)
+    {
+        W[k] = U[k] + b[7] * A6[k] + b[5] * A4[k] + b[3] * A2[k];
+        V[k] += b[6] * A6[k] + b[4] * A4[k] + b[2] * A2[k];
+    }
+    for (size_t i = 0; i < n; i++)
+    {
+        W[i * n + i] += b[1];
+        V[i * n + i] += b[0];
+    }
+
+    _matMul(A1, W, U, n);
+
+    // (V - U) R = V + U
+    std::vector<T>& P = W;
+    std::vector<T>& R = Z;
+    for (size_t k = 0; k < n * n; k++)
+    {
+        P[k] = V[k] - U[k];
+        R[k] = V[k] + U[k];
+    }
+
+    std::vector<size_t> piv;
+    if (!_luDecompose(P, n, piv))
+        throw std::runtime_error("Singular Pade denominator in matrix exponential");
+    _luSolve(P, n, piv, R, n);
+
+    for (size_t k = 0; k < s; k++)
+    {
+        _matMul(R, R, U, n);
+        R.swap(U);
+    }
+
+    return R;
+}
+
+
+} // namespace DES
+
+
+#endif
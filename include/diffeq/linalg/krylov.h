@@ -0,0 +1,161 @@
+#ifndef DIFFEQ_LINALG_KRYLOV_H
+#define DIFFEQ_LINALG_KRYLOV_H
+
+#include <cmath>
+#include <functional>
+#include <vector>
+
+
+namespace DES
+{
+
+/**
+ * @brief Euclidean norm.
+ *
+ * @tparam T
+ * @param v
+ * @return T
+ */
+template <typename T>
+T _norm2(const std::vector<T>& v)
+{
+    using std::sqrt;
+
+    T sum = 0;
+    for (const T& x : v)
+        sum += x * x;
+
+    return sqrt(sum);
+}
+
+
+/**
+ * @brief Restarted GMRES(k) for A x = b with right preconditioning, where only
+ * the products with A and with the preconditioner are known. It keeps k + 1
+ * basis vectors, O(n k) memory, orthogonalized by modified Gram-Schmidt, and
+ * minimizes the residual over the Krylov space with Givens rotations (Saad and
+ * Schultz, 1986). Right preconditioning leaves the residual that is minimized
+ * the true one.
+ *
+ * @tparam T
+ * @param A out = A v.
+ * @param P v = P^-1 v in place, with P close to A; empty for none.
+ * @param b
+ * @param x Initial guess, overwritten with the solution.
+ * @param restart k, the dimension of the Krylov space before a restart.
+ * @param maxIterations Total number of products with A.
+ * @param tol Stop once the residual's norm is at most tol.
+ * @return bool False if the tolerance was not reached.
+ */
+template <typename T>
+bool _gmres(std::function<void(const std::vector<T>&, std::vector<T>&)> A, std::function<void(std::vector<T>&)> P,
+    const std::vector<T>& b, std::vector<T>& x, size_t restart, size_t maxIterations, T tol)
+{
+    using std::sqrt;
+
+    size_t n = b.size();
+    size_t iterations = 0;
+
+    std::vector<std::vector<T>> V(1, std::vector<T>(n));       // grows as the space does
+    std::vector<T> H((restart + 1) * restart), cs(restart), sn(restart), g(restart + 1), w(n), z(n);
+
+    while (true)
+    {
+        // r = b - A x
+        A(x, w);
+        for (size_t i = 0; i < n; i++)
+            V[0][i] = b[i] - w[i];
+
+        T beta = _norm2(V[0]);
+        if (beta <= tol)
+            return true;
+        if (iterations >= maxIterations)
+            return false;
+
+        for (size_t i = 0; i < n; i++)
+            V[0][i] /= beta;
+
+        g.assign(restart + 1, 0);
+        g[0] = beta;
+
+        size_t k = 0;
+        T res = beta;
+
+        while (k < restart && iterations < maxIterations && res > tol)
+        {
+            z = V[k];
+            if (P)
+                P(z);
+            A(z, w);
+            iterations++;
+
+            for (size_t j = 0; j <= k; j++)
+            {
+                T h = 0;
+                for (size_t i = 0; i < n; i++)
+                    h += w[i] * V[j][i];
+                for (size_t i = 0; i < n; i++)
+                    w[i] -= h * V[j][i];
+                H[j * restart + k] = h;
+            }
+
+            T h = _norm2(w);
+            H[(k + 1) * restart + k] = h;
+            if (V.size() < k + 2)
+                V.emplace_back(n);
+            for (size_t i = 0; i < n && h != 0; i++)
+                V[k + 1][i] = w[i] / h;
+
+            for (size_t j = 0; j < k; j++)
+            {
+                T a = H[j * restart + k], c = H[(j + 1) * restart + k];
+                H[j * restart + k] = cs[j] * a + sn[j] * c;
+                H[(j + 1) * restart + k] = -sn[j] * a + cs[j] * c;
+            }
+
+            T a = H[k * restart + k];
+            T r = sqrt(a * a + h * h);
+            cs[k] = r == 0 ? 1 : a / r;
+            sn[k] = r == 0 ? 0 : h / r;
+            H[k * restart + k] = r;
+            H[(k + 1) * restart + k] = 0;
+
+            g[k + 1] = -sn[k] * g[k];
+            g[k] = cs[k] * g[k];
+            res = g[k + 1] >= 0 ? g[k + 1] : -g[k + 1];
+            k++;
+
+            // breakdown: the Krylov space is invariant and holds the solution
+            if (h == 0)
+                break;
+        }
+
+        // x += P^-1 V y, with H y = g
+        std::vector<T> y(k);
+        for (size_t j = k; j-- > 0;)
+        {
+            T sum = g[j];
+            for (size_t l = j + 1; l < k; l++)
+                sum -= H[j * restart + l] * y[l];
+            y[j] = H[j * restart + j] != 0 ? sum / H[j * restart + j] : 0;
+        }
+
+        z.assign(n, 0);
+        for (size_t j = 0; j < k; j++)
+            for (size_t i = 0; i < n; i++)
+                z[i] += y[j] * V[j][i];
+        if (P)
+            P(z);
+        for (size_t i = 0; i < n; i++)
+            x[i] += z[i];
+
+        if (res <= tol)
+            return true;
+    }
+}
+
+
+} // namespace DES
+
+
+#endif
@@ -0,0 +1,245 @@
+#ifndef DIFFEQ_LINALG_LU_H
+#define DIFFEQ_LINALG_LU_H
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+#include "../restrict.h"
+
+
+#define  _LU_BLOCK      32      // columns per panel
+#define  _LU_TILE       256     // columns per tile of the trailing update
+
+
+namespace DES
+{
+
+/**
+ * @brief Unblocked LU with partial pivoting of the panel of columns [k0, k1) of
+ * rows [k0, n). Pivot rows are swapped over the whole width of A, and only the
+ * panel's own columns are updated.
+ *
+ * @tparam T
+ * @param A
+ * @param n
+ * @param k0
+ * @param k1
+ * @param piv
+ * @return bool False if the matrix is singular.
+ */
+template <typename T>
+bool _luPanel(std::vector<T>& A, size_t n, size_t k0, size_t k1, std::vector<size_t>& piv)
+{
+    for (size_t k = k0; k < k1; k++)
+    {
+        size_t p = k;
+        T best = A[k * n + k] >= 0 ? A[k * n + k] : -A[k * n + k];
+        for (size_t i = k + 1; i < n; i++)
+        {
+            T a = A[i * n + k] >= 0 ? A[i * n + k] : -A[i * n + k];
+            if (a > best) { best = a; p = i; }
+        }
+
+        piv[k] = p;
+        if (best == 0)
+            return false;
+
+        if (p != k)
+            std::swap_ranges(A.begin() + k * n, A.begin() + (k + 1) * n, A.begin() + p * n);
+
+        T inv = 1 / A[k * n + k];
+        for (size_t i = k + 1; i < n; i++)
+        {
+            T l = A[i * n + k] *= inv;
+            for (size_t j = k + 1; j < k1; j++)
+                A[i * n + j] -= l * A[k * n + j];
+        }
+    }
+
+    return true;
+}
+
+
+/**
+ * @brief C -= L U on the rows [i0, i1) and columns [j0, j1) of A, where L is
+ * columns [p0, p1) of those rows and U is rows [p0, p1) of those columns. Four
+ * rows are updated at once so that each row of U is loaded once per four, and
+ * the innermost loop runs over contiguous columns, which compilers vectorize.
+ *
+ * @tparam T
+ * @param A
+ * @param n
+ */
+template <typename T>
+void _luUpdate(std::vector<T>& A, size_t n, size_t i0, size_t i1, size_t j0, size_t j1, size_t p0, size_t p1)
+{
+    T* a = A.data();
+    size_t i = i0;
+
+    for (; i + 4 <= i1; i += 4)
+    {
+        T* _DIFFEQ_RESTRICT c0 = a + i * n;
+        T* _DIFFEQ_RESTRICT c1 = c0 + n;
+        T* _DIFFEQ_RESTRICT c2 = c1 + n;
+        T* _DIFFEQ_RESTRICT c3 = c2 + n;
+
+        for (size_t p = p0; p < p1; p++)
+        {
+            const T* _DIFFEQ_RESTRICT u = a + p * n;
+            T l0 = c0[p], l1 = c1[p], l2 = c2[p], l3 = c3[p];
+
+            for (size_t j = j0; j < j1; j++)
+            {
+                T x = u[j];
+                c0[j] -= l0 * x;
+                c1[j] -= l1 * x;
+                c2[j] -= l2 * x;
+                c3[j] -= l3 * x;
+            }
+        }
+    }
+
+    for (; i < i1; i++)
+    {
+        T* _DIFFEQ_RESTRICT c = a + i * n;
+        for (size_t p = p0; p < p1; p++)
+        {
+            const T* _DIFFEQ_RESTRICT u = a + p * n;
+            T l = c[p];
+            for (size_t j = j0; j < j1; j++)
+                c[j] -= l * u[j];
+        }
+    }
+}
+
+
+/**
+ * @brief LU decomposition with partial pivoting of a dense n x n matrix, stored
+ * row major, in place. Afterwards A holds the unit lower triangular factor below
+ * the diagonal and the upper triangular factor on and above it, and piv[k] is the
+ * row that was swapped with row k.
+ *
+ * Large matrices are factored by blocks of _LU_BLOCK columns: the panel is
+ * factored unblocked, the block row to its right is solved with the panel's
+ * lower factor, and the trailing matrix gets one rank _LU_BLOCK update, done in
+ * tiles of _LU_TILE columns that stay in cache.
+ *
+ * @tparam T
+ * @param A
+ * @param n
+ * @param piv
+ * @return bool False if the matrix is singular.
+ */
+template <typename T>
+bool _luDecompose(std::vector<T>& A, size_t n, std::vector<size_t>& piv)
+{
+    piv.resize(n);
+
+    for (size_t k0 = 0; k0 < n; k0 += _LU_BLOCK)
+    {
+        size_t k1 = k0 + _LU_BLOCK < n ? k0 + _LU_BLOCK : n;
+
+        if (!_luPanel(A, n, k0, k1, piv))
+            return false;
+
+        if (k1 == n)
+            break;
+
+        // U12 = L11^-1 A12
+        for (size_t i = k0 + 1; i < k1; i++)
+            _luUpdate(A, n, i, i + 1, k1, n, k0, i);
+
+        // A22 -= L21 U12
+        for (size_t j0 = k1; j0 < n; j0 += _LU_TILE)
+            _luUpdate(A, n, k1, n, j0, j0 + _LU_TILE < n ? j0 + _LU_TILE : n, k0, k1);
+    }
+
+    return true;
+}
+
+
+/**
+ * @brief Solve A x = b in place, given the factors from _luDecompose.
+ *
+ * @tparam T
+ * @param LU
+ * @param n
+ * @param piv
+ * @param b Right hand side, overwritten with the solution.
+ */
+template <typename T>
+void _luSolve(std::vector<T>& LU, size_t n, std::vector<size_t>& piv, std::vector<T>& b)
+{
+    for (size_t k = 0; k < n; k++)
+        if (piv[k] != k)
+            std::swap(b[k], b[piv[k]]);
+
+    for (size_t i = 1; i < n; i++)
+        for (size_t j = 0; j < i; j++)
+            b[i] -= LU[i * n + j] * b[j];
+
+    for (size_t i = n; i-- > 0;)
+    {
+        for (size_t j = i + 1; j < n; j++)
+            b[i] -= LU[i * n + j] * b[j];
+        b[i] /= LU[i * n + i];
+    }
+}
+
+
+/**
+ * @brief Solve A X = B in place for nrhs right hand sides at once, given the
+ * factors from _luDecompose. B is n x nrhs, row major, so the substitutions
+ * update whole rows of B, which vectorizes over the right hand sides.
+ *
+ * @tparam T
+ * @param LU
+ * @param n
+ * @param piv
+ * @param B Right hand sides, overwritten with the solutions.
+ * @param nrhs
+ */
+template <typename T>
+void _luSolve(std::vector<T>& LU, size_t n, std::vector<size_t>& piv, std::vector<T>& B, size_t nrhs)
+{
+    T* b = B.data();
+
+    for (size_t k = 0; k < n; k++)
+        if (piv[k] != k)
+            std::swap_ranges(b + k * nrhs, b + (k + 1) * nrhs, b + piv[k] * nrhs);
+
+    for (size_t i = 1; i < n; i++)
+    {
+        T* _DIFFEQ_RESTRICT bi = b + i * nrhs;
+        for (size_t j = 0; j < i; j++)
+        {
+            const T* _DIFFEQ_RESTRICT bj = b + j * nrhs;
+            T l = LU[i * n + j];
+            for (size_t r = 0; r < nrhs; r++)
+                bi[r] -= l * bj[r];
+        }
+    }
+
+    for (size_t i = n; i-- > 0;)
+    {
+        T* _DIFFEQ_RESTRICT bi = b + i * nrhs;
+        for (size_t j = i + 1; j < n; j++)
+        {
+            const T* _DIFFEQ_RESTRICT bj = b + j * nrhs;
+            T u = LU[i * n + j];
+            for (size_t r = 0; r < nrhs; r++)
+                bi[r] -= u * bj[r];
+        }
+
+        T inv = 1 / LU[i * n + i];
+        for (size_t r = 0; r < nrhs; r++)
+            bi[r] *= inv;
+    }
+}
+
+
+} // namespace DES
+
+
+#endif
@@ -0,0 +1,197 @@
+#ifndef DIFFEQ_LINEAR_H
+#define DIFFEQ_LINEAR_H
+
+#include <map>
+#include <stdexcept>
+#include <vector>
+
+#include "solver.h"
+#include "linalg/expm.h"
+
+
+#define  _EXPM_CACHE        16      // step sizes whose propagators are kept
+
+
+namespace DES
+{
+
+/**
+ * @brief A linear system with constant coefficients, y' = A y + b, where A is
+ * m x m (row major) and b has m entries. Its solution over a step h is exact:
+ *
+ *      y(t + h) = e^(hA) y(t) + h phi_1(hA) b,
+ *
+ * and both terms are read off the exponential of the (m + 1) x (m + 1) matrix
+ * h [A b; 0 0]. That exponential (the propagator) is computed once per step size
+ * by _expm and cached, so each step is one matrix-vector product, and the step
+ * is not limited by stability. The rounding error of the propagator grows in
+ * proportion to the norm of hA through the squarings of _expm, to about 1e-11
+ * relative for |hA| = 1e6 in double.
+ *
+ * @tparam T
+ */
+template <typename T>
+class LinearODESystem
+{
+
+private:
+    std::vector<T> _A;
+    std::vector<T> _b;
+    timeBound_t<T> _timeBound;
+    iv_t<T> _iValues;
+    T _timeStep;
+    size_t _equations;
+    std::map<T, std::vector<T>> _propagators;
+
+public:
+    std::vector<T> lastValues;
+
+    LinearODESystem() = default;
+    LinearODESystem(iv_t<T>& iValues, std::vector<T> A, timeBound_t<T>& bounds, T timeStep)
+        : LinearODESystem(iValues, A, std::vector<T>(iValues.vec.size() > 1 ? iValues.vec.size() - 1 : 0, 0), bounds, timeStep)
+    { }
+
+    LinearODESystem(iv_t<T>& iValues, std::vector<T> A, std::vector<T> b, timeBound_t<T>& bounds, T timeStep)
+        : _A(A)
+        , _b(b)
+        , _timeBound(bounds)
+        , _iValues(iValues)
+        , _timeStep(timeStep)
+    {
+        if (iValues.vec.size() < 2)
+            throw std::invalid_argument("Linear system needs at least one equation");
+
+        _equations = iValues.vec.size() - 1;
+        if (_A.size() != _equations * _equations)
+            throw std::invalid_argument("Matrix must be m x m for m equations");
+        if (_b.size() != _equations)
+            throw std::invalid_argument("Forcing must have one entry per equation");
+
+        lastValues = iValues.vec;
+    }
+
+    const std::vector<T>&   getPropagator   (T h);
+    std::vector<T>          getMatrix       ();
+    std::vector<T>          getForcing      ();
+    iv_t<T>                 getInitialConditions();
+    timeBound_t<T>          getTimeBound    ();
+    T                       getTimeStep     ();
+    size_t                  getNumEquations ();
+};
+
+
+
+template <typename T>   DataFrame<T>    _EXPM       (LinearODESystem<T>& ode);
+template <typename T>   std::vector<T>  _EXPM_i     (LinearODESystem<T>& ode);
+
+
+
+/**
+ * @brief The propagator of a step of size h, the first m rows of
+ * e^(h [A b; 0 0]): m x (m + 1), row major, with e^(hA) in the first m columns
+ * and h phi_1(hA) b in the last. It is computed on the first request for h and
+ * cached; the cache is cleared once it holds _EXPM_CACHE step sizes, so the
+ * reference is only valid until the propagator of another step is requested.
+ *
+ * @tparam T
+ * @param h
+ * @return const std::vector<T>&
+ */
+template <typename T>
+const std::vector<T>& LinearODESystem<T>::getPropagator(T h)
+{
+    auto it = _propagators.find(h);
+    if (it != _propagators.end())
+        return it->second;
+
+    size_t m = _equations;
+    size_t n = m + 1;
+
+    std::vector<T> M(n * n, 0);
+    for (size_t i = 0; i < m; i++)
+    {
+        for (size_t j = 0; j < m; j++)
+            M[i * n + j] = h * _A[i * m + j];
+        M[i * n + m] = h * _b[i];
+    }
+
+    std::vector<T> E = _expm(M, n);
+    E.resize(m * n);
+
+    if (_propagators.size() >= _EXPM_CACHE)
+        _propagators.clear();
+
+    return _propagators[h] = E;
+}
+
+
+template <typename T>
+std::vector<T> LinearODESystem<T>::getMatrix()
+{
+    return _A;
+}
+
+
+template <typename T>
+std::vector<T> LinearODESystem<T>::getForcing()
+{
+    return _b;
+}
+
+
+template <typename T>
+iv_t<T> LinearODESystem<T>::getInitialConditions()
+{
+    return _iValues;
+}
+
+
+template <typename T>
+timeBound_t<T> LinearODESystem<T>::getTimeBound()
+{
+    return _timeBound;
+}
+
+
+template <typename T>
+T LinearODESystem<T>::getTimeStep()
+{
+    return _timeStep;
+}
+
+
+template <typename T>
+size_t LinearODESystem<T>::getNumEquations()
+{
+    return _equations;
+}
+
+
+template <typename T>
+DataFrame<T> solve(LinearODESystem<T>& eq, algorithm_t alg)
+{
+    switch (alg)
+    {
+        case ALGORITHM_EXPM:        return _EXPM(eq);
+
+        default:                    throw std::runtime_error("Invalid algorithm");
+    }
+}
+
+
+template <typename T>
+std::vector<T> solve_i(LinearODESystem<T>& eq, algorithm_t alg)
+{
+    switch (alg)
+    {
+        case ALGORITHM_EXPM:        return _EXPM_i(eq);
+
+        default:                    throw std::runtime_error("Invalid algorithm");
+    }
+}
+
+
+} // namespace DES
+
+
+#endif
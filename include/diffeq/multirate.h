@@ -0,0 +1,212 @@
+#ifndef DIFFEQ_MULTIRATE_H
+#define DIFFEQ_MULTIRATE_H
+
+#include <functional>
+#include <stdexcept>
+#include <vector>
+
+#include "solver.h"
+
+
+namespace DES
+{
+
+/**
+ * @brief A group of state components that are advanced with the same timestep.
+ * Indices refer to positions in the argument vector, so they start at 1 (index 0
+ * is always time), and functions[j] is the derivative of component indices[j].
+ *
+ * @tparam T
+ */
+template <typename T>
+struct partition_t
+{
+    std::vector<size_t> indices;
+    std::vector<function_t<T>> functions;
+    T timeStep;
+
+    partition_t() = default;
+    partition_t(std::initializer_list<size_t> idx, std::initializer_list<function_t<T>> funcs, T step)
+        : indices(idx)
+        , functions(funcs)
+        , timeStep(step)
+    { }
+};
+
+
+/**
+ * @brief A system of first order ordinary differential equations whose components
+ * are split into a slow group and a fast group. The slow right hand side is only
+ * evaluated once per slow stage, while the fast group is subcycled with its own
+ * (smaller) timestep, see the MRI-GARK methods in algorithms/mri.h.
+ *
+ * @tparam T
+ */
+template <typename T>
+class MultirateODESystem
+{
+
+private:
+    partition_t<T> _slow;
+    partition_t<T> _fast;
+    timeBound_t<T> _timeBound;
+    iv_t<T> _iValues;
+    size_t _equations;
+
+    std::vector<T> _evalPartition(partition_t<T>& part, std::vector<T>& inputs);
+
+public:
+    std::vector<T> lastValues;
+
+    MultirateODESystem() = default;
+    MultirateODESystem(iv_t<T>& iValues, partition_t<T>& slow, partition_t<T>& fast, timeBound_t<T>& bounds);
+
+    std::vector<T>  _evalSlow(std::vector<T>& inputs);
+    std::vector<T>  _evalFast(std::vector<T>& inputs);
+    iv_t<T>         getInitialConditions();
+    timeBound_t<T>  getTimeBound();
+    T               getSlowTimeStep();
+    T               getFastTimeStep();
+    size_t          getNumEquations();
+};
+
+
+
+template <typename T>   DataFrame<T>    _MRIGARK22      (MultirateODESystem<T>& ode);
+template <typename T>   std::vector<T>  _MRIGARK22_i    (MultirateODESystem<T>& ode);
+
+
+
+template <typename T>
+MultirateODESystem<T>::MultirateODESystem(iv_t<T>& iValues, partition_t<T>& slow, partition_t<T>& fast, timeBound_t<T>& bounds)
+    : _slow(slow)
+    , _fast(fast)
+    , _timeBound(bounds)
+    , _iValues(iValues)
+{
+    if (slow.indices.size() != slow.functions.size() || fast.indices.size() != fast.functions.size())
+        throw std::runtime_error("Each partition index needs exactly one function");
+
+    _equations = slow.indices.size() + fast.indices.size();
+    if (_equations + 1 != iValues.vec.size())
+        throw std::runtime_error("Partitions do not cover the initial conditions");
+
+    // every component must belong to exactly one of the two groups
+    std::vector<bool> seen(_equations + 1, false);
+    for (partition_t<T>* part : { &_slow, &_fast })
+        for (size_t idx : part->indices)
+        {
+            if (idx == 0 || idx > _equations || seen[idx])
+                throw std::runtime_error("Invalid partition index");
+            seen[idx] = true;
+        }
+
+    lastValues = iValues.vec;
+}
+
+
+template <typename T>
+std::vector<T> MultirateODESystem<T>::_evalPartition(partition_t<T>& part, std::vector<T>& inputs)
+{
+    std::vector<T> res(_equations, 0);
+    for (size_t j = 0; j < part.indices.size(); j++)
+        res[part.indices[j] - 1] = part.functions[j](inputs);
+
+    return res;
+}
+
+
+/**
+ * @brief Evaluate the slow group. The result has one entry per equation, with
+ * zeros in the positions owned by the fast group, so it can be added directly to
+ * a full state update.
+ *
+ * @tparam T
+ * @param inputs
+ * @return std::vector<T>
+ */
+template <typename T>
+std::vector<T> MultirateODESystem<T>::_evalSlow(std::vector<T>& inputs)
+{
+    return _evalPartition(_slow, inputs);
+}
+
+
+/**
+ * @brief Evaluate the fast group, with zeros in the positions owned by the slow
+ * group.
+ *
+ * @tparam T
+ * @param inputs
+ * @return std::vector<T>
+ */
+template <typename T>
+std::vector<T> MultirateODESystem<T>::_evalFast(std::vector<T>& inputs)
+{
+    return _evalPartition(_fast, inputs);
+}
+
+
+template <typename T>
+iv_t<T> MultirateODESystem<T>::getInitialConditions()
+{
+    return _iValues;
+}
+
+
+template <typename T>
+timeBound_t<T> MultirateODESystem<T>::getTimeBound()
+{
+    return _timeBound;
+}
+
+
+template <typename T>
+T MultirateODESystem<T>::getSlowTimeStep()
+{
+    return _slow.timeStep;
+}
+
+
+template <typename T>
+T MultirateODESystem<T>::getFastTimeStep()
+{
+    return _fast.timeStep;
+}
+
+
+template <typename T>
+size_t MultirateODESystem<T>::getNumEquations()
+{
+    return _equations;
+}
+
+
+template <typename T>
+DataFrame<T> solve(MultirateODESystem<T>& eq, algorithm_t alg)
+{
+    switch (alg)
+    {
+        case ALGORITHM_MRIGARK22:   return _MRIGARK22(eq);
+
+        default:                    throw std::runtime_error("Invalid algorithm");
+    }
+}
+
+
+template <typename T>
+std::vector<T> solve_i(MultirateODESystem<T>& eq, algorithm_t alg)
+{
+    switch (alg)
+    {
+        case ALGORITHM_MRIGARK22:   return _MRIGARK22_i(eq);
+
+        default:                    throw std::runtime_error("Invalid algorithm");
+    }
+}
+
+
+} // namespace DES
+
+
+#endif
@@ -2,9 +2,11 @@
 #define DIFFEQ_ODE_H
 
 #include <functional>
+#include <stdexcept>
 #include <vector>
 
 #include "solver.h"
+#include "sparsity.h"
 
 
 namespace DES 
@@ -23,6 +25,7 @@ class ODE : public DiffEq<T>
 
 public:
     std::vector<T> lastValues;
+    std::vector<T> lastCompensation;    // rounding error of lastValues, see algorithms/summation.h
 
     ODE(function_t<T>& func, timeBound_t<T>& bounds, iv_t<T>& initialCondition, T timeStep) 
     : DiffEq<T>(func, bounds, initialCondition, timeStep) 
@@ -30,6 +33,11 @@ public:
         lastValues = initialCondition.vec;
     }
 
+    // adaptive methods choose the first step themselves when none is given
+    ODE(function_t<T>& func, timeBound_t<T>& bounds, iv_t<T>& initialCondition) 
+    : ODE(func, bounds, initialCondition, 0)
+    { }
+
     T               _eval(std::vector<T>& input);
     T               getTimeStep();
     timeBound_t<T>  getTimeBound();
@@ -50,9 +58,17 @@ class ODESystem : public DiffEqSystem<T>
 
 private:
     size_t _equations;
+    std::function<void(const std::vector<T>&, std::vector<T>&)> _system;
+    std::function<void(const std::vector<T>&, std::vector<T>&)> _jacobian;
+    std::function<void(const std::vector<T>&, const std::vector<T>&, std::vector<T>&)> _jvp;
+    std::vector<T> _mass;
+    sparsity_t _sparsity;
+    krylov_t<T> _krylov;
+    bool _useKrylov = false;
 
 public:
     std::vector<T> lastValues;
+    std::vector<T> lastCompensation;    // rounding error of lastValues, see algorithms/summation.h
 
     ODESystem() = default;
     ODESystem(iv_t<T>& iValues, std::initializer_list<function_t<T>> funcs, timeBound_t<T>& bounds, T timeStep)
@@ -62,11 +78,49 @@ public:
         lastValues = iValues.vec;
     };
 
+    // adaptive methods choose the first step themselves when none is given
+    ODESystem(iv_t<T>& iValues, std::initializer_list<function_t<T>> funcs, timeBound_t<T>& bounds)
+        : ODESystem(iValues, funcs, bounds, 0)
+    { }
+
+    ODESystem(iv_t<T>& iValues, std::vector<function_t<T>> funcs, timeBound_t<T>& bounds, T timeStep)
+        : DiffEqSystem<T>(iValues, funcs, bounds, timeStep)
+    { 
+        _equations = funcs.size();
+        lastValues = iValues.vec;
+    };
+
+    // one function for the whole system, the number of equations follows from the initial conditions
+    ODESystem(iv_t<T>& iValues, systemFunction_t<T> func, timeBound_t<T>& bounds, T timeStep)
+        : DiffEqSystem<T>(iValues, std::vector<function_t<T>>(), bounds, timeStep)
+        , _system(func._func)
+    { 
+        _equations = iValues.vec.size() - 1;
+        lastValues = iValues.vec;
+    };
+
     std::vector<T>  _eval(std::vector<T>& inputs);  
+    void            _evalJacobian(const std::vector<T>& inputs, std::vector<T>& J);
+    bool            hasJacobian();
+    void            setJacobian(jacobianFunction_t<T> func);
+    void            _evalJVP(const std::vector<T>& inputs, const std::vector<T>& v, std::vector<T>& out);
+    bool            hasJacobianVectorProduct();
+    void            setJacobianVectorProduct(jvpFunction_t<T> func);
+    bool            hasSparsity();
+    void            setSparsity(sparsity_t sparsity);
+    sparsity_t&     getSparsity();
+    bool            hasKrylov();
+    void            setKrylov(krylov_t<T> krylov);
+    krylov_t<T>&    getKrylov();
     iv_t<T>         getInitialConditions();    
     timeBound_t<T>  getTimeBound();
     T               getTimeStep();
     size_t          getNumEquations(); 
+    void            setMassMatrix(std::vector<T> mass);
+    std::vector<T>& getMassMatrix();
+    void            setInitialConditions(iv_t<T> iValues);
+    void            setTimeBound(timeBound_t<T> bounds);
+    void            setTimeStep(T timeStep);
 };
 
 
@@ -75,13 +129,21 @@ template <typename T>   DataFrame<T>  _EULER    (ODE<T>& ode);
 template <typename T>   DataFrame<T>  _RK4      (ODE<T>& ode);
 template <typename T>   DataFrame<T>  _RKF45    (ODE<T>& ode);
 template <typename T>   DataFrame<T>  _RKF45    (ODE<T>& ode, T maxError);
+template <typename T>   DataFrame<T>  _RKF45    (ODE<T>& ode, tolerance_t<T> tol);
+template <typename T>   DataFrame<T>  _RKF45    (ODE<T>& ode, options_t<T> options);
 template <typename T>   DataFrame<T>  _TSIT5    (ODE<T>& ode);
+template <typename T>   DataFrame<T>  _RB23     (ODE<T>& ode);
+template <typename T>   DataFrame<T>  _RB23     (ODE<T>& ode, options_t<T> options);
 
 template <typename T>   DataFrame<T>  _EULER    (ODESystem<T>& ode);
 template <typename T>   DataFrame<T>  _RK4      (ODESystem<T>& ode);
 template <typename T>   DataFrame<T>  _RKF45    (ODESystem<T>& ode);
 template <typename T>   DataFrame<T>  _RKF45    (ODESystem<T>& ode, T maxError);
+template <typename T>   DataFrame<T>  _RKF45    (ODESystem<T>& ode, tolerance_t<T> tol);
+template <typename T>   DataFrame<T>  _RKF45    (ODESystem<T>& ode, options_t<T> options);
 template <typename T>   DataFrame<T>  _TSIT5    (ODESystem<T>& ode);
+template <typename T>   DataFrame<T>  _RB23     (ODESystem<T>& ode);
+template <typename T>   DataFrame<T>  _RB23     (ODESystem<T>& ode, options_t<T> options);
 
 template <typename T>   std::vector<T>  _EULER_i  (ODE<T>& ode);
 template <typename T>   std::vector<T>  _RK4_i    (ODE<T>& ode);
@@ -137,6 +199,13 @@ T ODE<T>::getTimeStep()
 template <typename T>
 std::vector<T> ODESystem<T>::_eval(std::vector<T>& inputs) 
 {
+    if (_system)
+    {
+        std::vector<T> res(_equations);
+        _system(inputs, res);
+        return res;
+    }
+
     std::vector<T> res;
     for (function_t<T> &func : ODESystem<T>::_functions)
         res.push_back(func(inputs));
@@ -145,6 +214,122 @@ std::vector<T> ODESystem<T>::_eval(std::vector<T>& inputs)
 }
 
 
+template <typename T>
+void ODESystem<T>::_evalJacobian(const std::vector<T>& inputs, std::vector<T>& J)
+{
+    J.resize(_equations * _equations);
+    _jacobian(inputs, J);
+}
+
+
+template <typename T>
+bool ODESystem<T>::hasJacobian()
+{
+    return (bool)_jacobian;
+}
+
+
+/**
+ * @brief Give the implicit methods the Jacobian df/dy, instead of approximating
+ * it by finite differences. The time derivative df/dt is still approximated.
+ * 
+ * @tparam T 
+ * @param func 
+ */
+template <typename T>
+void ODESystem<T>::setJacobian(jacobianFunction_t<T> func)
+{
+    _jacobian = func._func;
+}
+
+
+template <typename T>
+void ODESystem<T>::_evalJVP(const std::vector<T>& inputs, const std::vector<T>& v, std::vector<T>& out)
+{
+    out.resize(_equations);
+    _jvp(inputs, v, out);
+}
+
+
+template <typename T>
+bool ODESystem<T>::hasJacobianVectorProduct()
+{
+    return (bool)_jvp;
+}
+
+
+template <typename T>
+void ODESystem<T>::setJacobianVectorProduct(jvpFunction_t<T> func)
+{
+    _jvp = func._func;
+}
+
+
+template <typename T>
+bool ODESystem<T>::hasSparsity()
+{
+    return _sparsity.m > 0;
+}
+
+
+/**
+ * @brief Declare the sparsity pattern of the Jacobian (e.g. from 
+ * detectSparsity), so finite difference Jacobians perturb every color group of
+ * columns at once, which costs one evaluation per color instead of one per 
+ * equation.
+ * 
+ * @tparam T 
+ * @param sparsity 
+ */
+template <typename T>
+void ODESystem<T>::setSparsity(sparsity_t sparsity)
+{
+    if (sparsity.m != _equations)
+        throw std::invalid_argument("Sparsity pattern must be m x m");
+
+    _sparsity = sparsity;
+}
+
+
+template <typename T>
+sparsity_t& ODESystem<T>::getSparsity()
+{
+    return _sparsity;
+}
+
+
+template <typename T>
+bool ODESystem<T>::hasKrylov()
+{
+    return _useKrylov;
+}
+
+
+/**
+ * @brief Solve the linear systems of the implicit methods matrix free with
+ * GMRES, for systems too large to store their Jacobian (see krylov_t).
+ * 
+ * @tparam T 
+ * @param krylov 
+ */
+template <typename T>
+void ODESystem<T>::setKrylov(krylov_t<T> krylov)
+{
+    if (krylov.restart == 0)
+        throw std::invalid_argument("Krylov restart length must be positive");
+
+    _krylov = krylov;
+    _useKrylov = true;
+}
+
+
+template <typename T>
+krylov_t<T>& ODESystem<T>::getKrylov()
+{
+    return _krylov;
+}
+
+
 template <typename T>
 iv_t<T> ODESystem<T>::getInitialConditions() 
 {
@@ -164,6 +349,72 @@ size_t ODESystem<T>::getNumEquations()
 }
 
 
+/**
+ * @brief Set a constant mass matrix M (m x m, row major), so the system becomes
+ * M dy/dt = f(t, y). A singular M turns it into a differential-algebraic system:
+ * a zero row i makes f_i(t, y) = 0 an algebraic constraint, and the components 
+ * with a zero column are its algebraic variables. Only the Rosenbrock method
+ * supports mass matrices, for DAEs of index 1.
+ * 
+ * @tparam T 
+ * @param mass 
+ */
+template <typename T>
+void ODESystem<T>::setMassMatrix(std::vector<T> mass)
+{
+    if (mass.size() != _equations * _equations)
+        throw std::invalid_argument("Mass matrix must be m x m");
+
+    _mass = mass;
+}
+
+
+/**
+ * @brief Get the mass matrix, which is empty for the identity.
+ * 
+ * @tparam T 
+ * @return std::vector<T>& 
+ */
+template <typename T>
+std::vector<T>& ODESystem<T>::getMassMatrix()
+{
+    return _mass;
+}
+
+
+/**
+ * @brief Restart the system from new initial conditions, e.g. to integrate one
+ * time slice of a longer solve. The number of equations must not change.
+ * 
+ * @tparam T 
+ * @param iValues 
+ */
+template <typename T>
+void ODESystem<T>::setInitialConditions(iv_t<T> iValues)
+{
+    if (iValues.vec.size() != _equations + 1)
+        throw std::invalid_argument("Initial conditions must match the number of equations");
+
+    this->_iValues = iValues;
+    lastValues = iValues.vec;
+    lastCompensation.clear();
+}
+
+
+template <typename T>
+void ODESystem<T>::setTimeBound(timeBound_t<T> bounds)
+{
+    this->_timeBound = bounds;
+}
+
+
+template <typename T>
+void ODESystem<T>::setTimeStep(T timeStep)
+{
+    this->_timeStep = timeStep;
+}
+
+
 /**
  * @brief Get the time bounds in an ODESystem object.
  * 
@@ -192,7 +443,9 @@ T ODESystem<T>::getTimeStep()
 
 
 /**
- * @brief Solve an ordinary differential equation numerically.
+ * @brief Solve an ordinary differential equation numerically. Systems with a
+ * mass matrix are only solved by ALGORITHM_RB23; the explicit methods would
+ * ignore it, so they throw instead.
  * 
  * @tparam T 
  * @tparam V 
@@ -208,6 +461,7 @@ DataFrame<T> solve(ODE<T>& eq, algorithm_t alg)
         case ALGORITHM_EULER:   return _EULER(eq);
         case ALGORITHM_RK4:     return _RK4(eq);
         case ALGORITHM_RKF45:   return _RKF45(eq);
+        case ALGORITHM_RB23:    return _RB23(eq);
 
         default:                throw std::runtime_error("Invalid algorithm");
     }
@@ -217,17 +471,60 @@ DataFrame<T> solve(ODE<T>& eq, algorithm_t alg)
 template <typename T>
 DataFrame<T> solve(ODESystem<T>& eq, algorithm_t alg) 
 {
+    if (!eq.getMassMatrix().empty() && alg != ALGORITHM_RB23)
+        throw std::invalid_argument("Only ALGORITHM_RB23 solves systems with a mass matrix");
+
     switch (alg)
     {
         case ALGORITHM_EULER:   return _EULER(eq);
         case ALGORITHM_RK4:     return _RK4(eq);
         case ALGORITHM_RKF45:   return _RKF45(eq);
+        case ALGORITHM_RB23:    return _RB23(eq);
         
         default:                throw std::runtime_error("Invalid algorithm");
     }
 }
 
 
+/**
+ * @brief Solve an ordinary differential equation with an adaptive method, with 
+ * the given tolerances and output times.
+ * 
+ * @tparam T 
+ * @param eq 
+ * @param alg 
+ * @param options 
+ * @return DataFrame<T> 
+ */
+template <typename T>
+DataFrame<T> solve(ODE<T>& eq, algorithm_t alg, options_t<T> options) 
+{
+    switch (alg)
+    {
+        case ALGORITHM_RKF45:   return _RKF45(eq, options);
+        case ALGORITHM_RB23:    return _RB23(eq, options);
+
+        default:                throw std::runtime_error("Invalid algorithm");
+    }
+}
+
+
+template <typename T>
+DataFrame<T> solve(ODESystem<T>& eq, algorithm_t alg, options_t<T> options) 
+{
+    if (!eq.getMassMatrix().empty() && alg != ALGORITHM_RB23)
+        throw std::invalid_argument("Only ALGORITHM_RB23 solves systems with a mass matrix");
+
+    switch (alg)
+    {
+        case ALGORITHM_RKF45:   return _RKF45(eq, options);
+        case ALGORITHM_RB23:    return _RB23(eq, options);
+
+        default:                throw std::runtime_error("Invalid algorithm");
+    }
+}
+
+
 template <typename T>
 std::vector<T> solve_i(ODE<T>& eq, algorithm_t alg) 
 {
@@ -245,6 +542,9 @@ std::vector<T> solve_i(ODE<T>& eq, algorithm_t alg)
 template <typename T>
 std::vector<T> solve_i(ODESystem<T>& eq, algorithm_t alg)
 {
+    if (!eq.getMassMatrix().empty() && alg != ALGORITHM_RB23)
+        throw std::invalid_argument("Only ALGORITHM_RB23 solves systems with a mass matrix");
+
     switch (alg)
     {
         case ALGORITHM_EULER:   return _EULER_i(eq);
@@ -0,0 +1,276 @@
+#ifndef DIFFEQ_PARAMETRIC_H
+#define DIFFEQ_PARAMETRIC_H
+
+#include <functional>
+#include <stdexcept>
+#include <vector>
+
+#include "ode.h"
+
+
+namespace DES
+{
+
+/**
+ * @brief std::function wrapper for the right hand side of a system that depends
+ * on parameters. It receives the arguments (t, y_1, ..., y_m) and the parameters
+ * p_1, ..., p_P, and writes all m derivatives to out, which is already sized.
+ *
+ * @tparam T
+ */
+template <typename T>
+struct parametricFunction_t
+{
+    std::function<void(const std::vector<T>&, const std::vector<T>&, std::vector<T>&)> _func;
+
+    parametricFunction_t(std::function<void(const std::vector<T>&, const std::vector<T>&, std::vector<T>&)> func) {
+        _func = func;
+    }
+
+    void operator()(const std::vector<T>& args, const std::vector<T>& params, std::vector<T>& out)
+    {
+        _func(args, params, out);
+    }
+};
+
+
+/**
+ * @brief std::function wrapper for a directional derivative of a parametric
+ * right hand side, out = (df/dy) dy + (df/dp) dp, evaluated at (args, params).
+ * dy has one entry per equation. Supplying one (e.g. from automatic
+ * differentiation) replaces the finite differences of the sensitivity methods.
+ *
+ * @tparam T
+ */
+template <typename T>
+struct directionalFunction_t
+{
+    std::function<void(const std::vector<T>&, const std::vector<T>&, const std::vector<T>&, const std::vector<T>&, std::vector<T>&)> _func;
+
+    directionalFunction_t(std::function<void(const std::vector<T>&, const std::vector<T>&, const std::vector<T>&, const std::vector<T>&, std::vector<T>&)> func) {
+        _func = func;
+    }
+
+    void operator()(const std::vector<T>& args, const std::vector<T>& params, const std::vector<T>& dy, const std::vector<T>& dp, std::vector<T>& out)
+    {
+        _func(args, params, dy, dp, out);
+    }
+};
+
+
+/**
+ * @brief std::function wrapper for a vector-Jacobian product of a parametric
+ * right hand side at (args, params): outY = w^T df/dy (m entries) and
+ * outP = w^T df/dp (P entries). Supplying one (e.g. from reverse mode automatic
+ * differentiation) makes the cost of the adjoint method independent of the
+ * number of parameters.
+ *
+ * @tparam T
+ */
+template <typename T>
+struct vjpFunction_t
+{
+    std::function<void(const std::vector<T>&, const std::vector<T>&, const std::vector<T>&, std::vector<T>&, std::vector<T>&)> _func;
+
+    vjpFunction_t(std::function<void(const std::vector<T>&, const std::vector<T>&, const std::vector<T>&, std::vector<T>&, std::vector<T>&)> func) {
+        _func = func;
+    }
+
+    void operator()(const std::vector<T>& args, const std::vector<T>& params, const std::vector<T>& w, std::vector<T>& outY, std::vector<T>& outP)
+    {
+        _func(args, params, w, outY, outP);
+    }
+};
+
+
+/**
+ * @brief A system of first order ordinary differential equations,
+ * dy_j/dt = f_j(t, y_1, ..., y_m; p_1, ..., p_P), whose parameters can be changed
+ * between solves and differentiated against, see algorithms/sensitivity.h.
+ *
+ * @tparam T
+ */
+template <typename T>
+class ParametricODESystem
+{
+
+private:
+    std::function<void(const std::vector<T>&, const std::vector<T>&, std::vector<T>&)> _func;
+    std::function<void(const std::vector<T>&, const std::vector<T>&, const std::vector<T>&, const std::vector<T>&, std::vector<T>&)> _directional;
+    std::function<void(const std::vector<T>&, const std::vector<T>&, const std::vector<T>&, std::vector<T>&, std::vector<T>&)> _vjp;
+    std::vector<T> _params;
+    timeBound_t<T> _timeBound;
+    iv_t<T> _iValues;
+    T _timeStep;
+
+public:
+    ParametricODESystem() = default;
+    ParametricODESystem(iv_t<T>& iValues, parametricFunction_t<T> func, std::vector<T> params, timeBound_t<T>& bounds, T timeStep)
+        : _func(func._func)
+        , _params(params)
+        , _timeBound(bounds)
+        , _iValues(iValues)
+        , _timeStep(timeStep)
+    { }
+
+    void            _eval(const std::vector<T>& inputs, const std::vector<T>& params, std::vector<T>& out);
+    void            _evalDirectional(const std::vector<T>& inputs, const std::vector<T>& params, const std::vector<T>& dy, const std::vector<T>& dp, std::vector<T>& out);
+    bool            hasDirectionalDerivative();
+    void            setDirectionalDerivative(directionalFunction_t<T> func);
+    void            _evalVJP(const std::vector<T>& inputs, const std::vector<T>& params, const std::vector<T>& w, std::vector<T>& outY, std::vector<T>& outP);
+    bool            hasVectorJacobianProduct();
+    void            setVectorJacobianProduct(vjpFunction_t<T> func);
+    void            setParameters(std::vector<T> params);
+    std::vector<T>  getParameters();
+    ODESystem<T>    _getODESystem();
+    iv_t<T>         getInitialConditions();
+    timeBound_t<T>  getTimeBound();
+    T               getTimeStep();
+    size_t          getNumEquations();
+    size_t          getNumParameters();
+};
+
+
+
+template <typename T>
+void ParametricODESystem<T>::_eval(const std::vector<T>& inputs, const std::vector<T>& params, std::vector<T>& out)
+{
+    _func(inputs, params, out);
+}
+
+
+template <typename T>
+void ParametricODESystem<T>::_evalDirectional(const std::vector<T>& inputs, const std::vector<T>& params, const std::vector<T>& dy, const std::vector<T>& dp, std::vector<T>& out)
+{
+    _directional(inputs, params, dy, dp, out);
+}
+
+
+template <typename T>
+bool ParametricODESystem<T>::hasDirectionalDerivative()
+{
+    return (bool)_directional;
+}
+
+
+template <typename T>
+void ParametricODESystem<T>::setDirectionalDerivative(directionalFunction_t<T> func)
+{
+    _directional = func._func;
+}
+
+
+template <typename T>
+void ParametricODESystem<T>::_evalVJP(const std::vector<T>& inputs, const std::vector<T>& params, const std::vector<T>& w, std::vector<T>& outY, std::vector<T>& outP)
+{
+    _vjp(inputs, params, w, outY, outP);
+}
+
+
+template <typename T>
+bool ParametricODESystem<T>::hasVectorJacobianProduct()
+{
+    return (bool)_vjp;
+}
+
+
+template <typename T>
+void ParametricODESystem<T>::setVectorJacobianProduct(vjpFunction_t<T> func)
+{
+    _vjp = func._func;
+}
+
+
+template <typename T>
+void ParametricODESystem<T>::setParameters(std::vector<T> params)
+{
+    if (params.size() != _params.size())
+        throw std::invalid_argument("Number of parameters must not change");
+
+    _params = params;
+}
+
+
+template <typename T>
+std::vector<T> ParametricODESystem<T>::getParameters()
+{
+    return _params;
+}
+
+
+/**
+ * @brief View the system with its current parameters as an ODESystem, so it can
+ * be solved with any of the ODE methods. The parameters are copied.
+ *
+ * @tparam T
+ * @return ODESystem<T>
+ */
+template <typename T>
+ODESystem<T> ParametricODESystem<T>::_getODESystem()
+{
+    std::function<void(const std::vector<T>&, const std::vector<T>&, std::vector<T>&)> func = _func;
+    std::vector<T> params = _params;
+
+    systemFunction_t<T> system([func, params](const std::vector<T>& args, std::vector<T>& out) {
+        func(args, params, out);
+    });
+
+    return ODESystem<T>(_iValues, system, _timeBound, _timeStep);
+}
+
+
+template <typename T>
+iv_t<T> ParametricODESystem<T>::getInitialConditions()
+{
+    return _iValues;
+}
+
+
+template <typename T>
+timeBound_t<T> ParametricODESystem<T>::getTimeBound()
+{
+    return _timeBound;
+}
+
+
+template <typename T>
+T ParametricODESystem<T>::getTimeStep()
+{
+    return _timeStep;
+}
+
+
+template <typename T>
+size_t ParametricODESystem<T>::getNumEquations()
+{
+    return _iValues.vec.size() - 1;
+}
+
+
+template <typename T>
+size_t ParametricODESystem<T>::getNumParameters()
+{
+    return _params.size();
+}
+
+
+template <typename T>
+DataFrame<T> solve(ParametricODESystem<T>& eq, algorithm_t alg)
+{
+    ODESystem<T> ode = eq._getODESystem();
+    return solve(ode, alg);
+}
+
+
+template <typename T>
+DataFrame<T> solve(ParametricODESystem<T>& eq, algorithm_t alg, options_t<T> options)
+{
+    ODESystem<T> ode = eq._getODESystem();
+    return solve(ode, alg, options);
+}
+
+
+} // namespace DES
+
+
+#endif
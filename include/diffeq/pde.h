@@ -0,0 +1,378 @@
+#ifndef DIFFEQ_PDE_H
+#define DIFFEQ_PDE_H
+
+#include <functional>
+#include <stdexcept>
+#include <vector>
+
+#include "ode.h"
+#include "restrict.h"
+
+
+// the stencil loops only read u and only write out, so they may be vectorized
+#if defined(__clang__)
+    #define  _PDE_SIMD                  _Pragma("clang loop vectorize(enable) interleave(enable)")
+#elif defined(__GNUC__)
+    #define  _PDE_SIMD                  _Pragma("GCC ivdep")
+#elif defined(_MSC_VER)
+    #define  _PDE_SIMD                  __pragma(loop(ivdep))
+#else
+    #define  _PDE_SIMD
+#endif
+
+
+namespace DES
+{
+
+/**
+ * @brief Boundary condition on one side of a grid axis.
+ *
+ * - BOUNDARY_PERIODIC: the axis wraps around, value is unused. Both sides of the
+ *   axis must be periodic.
+ * - BOUNDARY_DIRICHLET: u = value on a node one spacing outside the grid, so
+ *   every grid point is an unknown.
+ * - BOUNDARY_NEUMANN: du/dx = value on the first (or last) grid point, imposed
+ *   with a reflected ghost point.
+ *
+ * @tparam T
+ */
+template <typename T>
+struct boundary_t
+{
+    int type;
+    T value;
+
+    boundary_t()                    : type(BOUNDARY_PERIODIC), value(0) { }
+    boundary_t(int bc, T val = 0)   : type(bc), value(val) { }
+};
+
+
+/**
+ * @brief Uniform 1D, 2D or 3D grid for the method of lines. Points are stored in
+ * row major order with x varying fastest, index (k * ny + j) * nx + i, and unused
+ * axes have size 1. The stencil operators apply to contiguous arrays of this
+ * layout without copying; along every axis the interior points form contiguous
+ * runs with a constant offset, so the inner loops vectorize.
+ *
+ * @tparam T
+ */
+template <typename T>
+class Grid
+{
+
+private:
+    size_t _n[3];
+    size_t _stride[3];
+    T _h[3];
+    boundary_t<T> _lower[3];
+    boundary_t<T> _upper[3];
+
+    void _init(size_t nx, size_t ny, size_t nz, T dx, T dy, T dz, boundary_t<T> bc);
+    void _axis(const T* _DIFFEQ_RESTRICT u, T* _DIFFEQ_RESTRICT out, size_t axis, T cm, T c0, T cp, bool accumulate);
+
+public:
+    Grid() = default;
+    Grid(size_t nx, T dx, boundary_t<T> bc = boundary_t<T>())
+    {
+        _init(nx, 1, 1, dx, 1, 1, bc);
+    }
+
+    Grid(size_t nx, size_t ny, T dx, T dy, boundary_t<T> bc = boundary_t<T>())
+    {
+        _init(nx, ny, 1, dx, dy, 1, bc);
+    }
+
+    Grid(size_t nx, size_t ny, size_t nz, T dx, T dy, T dz, boundary_t<T> bc = boundary_t<T>())
+    {
+        _init(nx, ny, nz, dx, dy, dz, bc);
+    }
+
+    void            setBoundary (size_t axis, boundary_t<T> lower, boundary_t<T> upper);
+    void            laplacian   (const T* u, T* out, bool accumulate = false);
+    void            derivative  (const T* u, T* out, size_t axis, bool accumulate = false);
+    void            stencil     (const T* u, T* out, size_t axis, T cm, T c0, T cp, bool accumulate = false);
+    size_t          index       (size_t i, size_t j = 0, size_t k = 0);
+    size_t          size        ();
+    size_t          getSize     (size_t axis);
+    T               getSpacing  (size_t axis);
+    size_t          getDimension();
+};
+
+
+/**
+ * @brief std::function wrapper for the right hand side of a discretized PDE. It
+ * receives the time and every field on the grid, u[f * N + p] for field f at
+ * point p (N = grid.size()), and writes du/dt in the same layout.
+ *
+ * @tparam T
+ */
+template <typename T>
+struct pdeFunction_t
+{
+    std::function<void(T, const T*, T*)> _func;
+
+    pdeFunction_t(std::function<void(T, const T*, T*)> func) {
+        _func = func;
+    }
+
+    void operator()(T t, const T* u, T* dudt)
+    {
+        _func(t, u, dudt);
+    }
+};
+
+
+
+template <typename T>
+void Grid<T>::_init(size_t nx, size_t ny, size_t nz, T dx, T dy, T dz, boundary_t<T> bc)
+{
+    if (nx == 0 || ny == 0 || nz == 0)
+        throw std::invalid_argument("Grid must have at least one point along every axis");
+
+    _n[0] = nx;     _n[1] = ny;     _n[2] = nz;
+    _h[0] = dx;     _h[1] = dy;     _h[2] = dz;
+
+    _stride[0] = 1;
+    _stride[1] = nx;
+    _stride[2] = nx * ny;
+
+    for (size_t a = 0; a < 3; a++)
+    {
+        _lower[a] = bc;
+        _upper[a] = bc;
+    }
+}
+
+
+/**
+ * @brief Set the boundary conditions at the start and end of an axis (0, 1 or 2
+ * for x, y and z).
+ *
+ * @tparam T
+ * @param axis
+ * @param lower
+ * @param upper
+ */
+template <typename T>
+void Grid<T>::setBoundary(size_t axis, boundary_t<T> lower, boundary_t<T> upper)
+{
+    if ((lower.type == BOUNDARY_PERIODIC) != (upper.type == BOUNDARY_PERIODIC))
+        throw std::invalid_argument("Periodic boundaries must be set on both sides of an axis");
+
+    _lower[axis] = lower;
+    _upper[axis] = upper;
+}
+
+
+/**
+ * @brief Apply the three point stencil cm u[i-1] + c0 u[i] + cp u[i+1] along one
+ * axis. The interior of the axis is one contiguous run per outer index, and the
+ * first and last planes take their missing neighbour from the boundary condition.
+ *
+ * @tparam T
+ * @param u
+ * @param out Must not overlap u.
+ * @param axis
+ * @param cm
+ * @param c0
+ * @param cp
+ * @param accumulate Add to out instead of overwriting it.
+ */
+template <typename T>
+void Grid<T>::_axis(const T* _DIFFEQ_RESTRICT u, T* _DIFFEQ_RESTRICT out, size_t axis, T cm, T c0, T cp, bool accumulate)
+{
+    size_t n = _n[axis];
+    size_t s = _stride[axis];
+    size_t plane = s * n;               // points of one run of the axis and everything faster
+    size_t outer = size() / plane;
+    for (size_t o = 0; o < outer; o++)
+    {
+        const T* _DIFFEQ_RESTRICT v = u + o * plane;
+        T* _DIFFEQ_RESTRICT w = out + o * plane;
+
+        // interior, neighbours at -s and +s
+        if (n > 2 && accumulate)
+        {
+            _PDE_SIMD
+            for (size_t p = s; p < plane - s; p++)
+                w[p] += cm * v[p - s] + c0 * v[p] + cp * v[p + s];
+        }
+        else if (n > 2)
+        {
+            _PDE_SIMD
+            for (size_t p = s; p < plane - s; p++)
+                w[p] = cm * v[p - s] + c0 * v[p] + cp * v[p + s];
+        }
+
+        // first and last plane of the axis, p runs over the faster axes
+        for (size_t p = 0; p < s; p++)
+        {
+            size_t first = p, last = p + (n - 1) * s;
+            T next = n > 1 ? v[first + s] : v[first];
+            T prev = n > 1 ? v[last - s] : v[last];
+            T ghostLower, ghostUpper;
+
+            switch (_lower[axis].type)
+            {
+                case BOUNDARY_PERIODIC:     ghostLower = v[last];                               break;
+                case BOUNDARY_DIRICHLET:    ghostLower = _lower[axis].value;                    break;
+                case BOUNDARY_NEUMANN:      ghostLower = next - 2 * _h[axis] * _lower[axis].value;  break;
+                default:                    throw std::runtime_error("Invalid boundary");
+            }
+
+            switch (_upper[axis].type)
+            {
+                case BOUNDARY_PERIODIC:     ghostUpper = v[first];                              break;
+                case BOUNDARY_DIRICHLET:    ghostUpper = _upper[axis].value;                    break;
+                case BOUNDARY_NEUMANN:      ghostUpper = prev + 2 * _h[axis] * _upper[axis].value;  break;
+                default:                    throw std::runtime_error("Invalid boundary");
+            }
+
+            if (n == 1)
+            {
+                w[first] = (accumulate ? w[first] : 0) + cm * ghostLower + c0 * v[first] + cp * ghostUpper;
+                continue;
+            }
+
+            w[first] = (accumulate ? w[first] : 0) + cm * ghostLower + c0 * v[first] + cp * next;
+            w[last] = (accumulate ? w[last] : 0) + cm * prev + c0 * v[last] + cp * ghostUpper;
+        }
+    }
+}
+
+
+/**
+ * @brief Second order accurate Laplacian of one field, summed over the axes
+ * with more than one point.
+ *
+ * @tparam T
+ * @param u Field values, grid.size() of them.
+ * @param out Result, must not overlap u.
+ * @param accumulate Add to out instead of overwriting it.
+ */
+template <typename T>
+void Grid<T>::laplacian(const T* u, T* out, bool accumulate)
+{
+    bool first = true;
+    for (size_t a = 0; a < 3; a++)
+    {
+        if (_n[a] == 1 && a > 0)
+            continue;
+
+        T c = 1 / (_h[a] * _h[a]);
+        _axis(u, out, a, c, -2 * c, c, accumulate || !first);
+        first = false;
+    }
+}
+
+
+/**
+ * @brief Second order accurate central first derivative of one field along an
+ * axis.
+ *
+ * @tparam T
+ * @param u
+ * @param out Must not overlap u.
+ * @param axis
+ * @param accumulate
+ */
+template <typename T>
+void Grid<T>::derivative(const T* u, T* out, size_t axis, bool accumulate)
+{
+    T c = 1 / (2 * _h[axis]);
+    _axis(u, out, axis, -c, 0, c, accumulate);
+}
+
+
+/**
+ * @brief Apply a general three point stencil along an axis, e.g. a one sided
+ * upwind difference.
+ *
+ * @tparam T
+ * @param u
+ * @param out Must not overlap u.
+ * @param axis
+ * @param cm Weight of the previous point.
+ * @param c0 Weight of the point itself.
+ * @param cp Weight of the next point.
+ * @param accumulate
+ */
+template <typename T>
+void Grid<T>::stencil(const T* u, T* out, size_t axis, T cm, T c0, T cp, bool accumulate)
+{
+    _axis(u, out, axis, cm, c0, cp, accumulate);
+}
+
+
+template <typename T>
+size_t Grid<T>::index(size_t i, size_t j, size_t k)
+{
+    return (k * _n[1] + j) * _n[0] + i;
+}
+
+
+template <typename T>
+size_t Grid<T>::size()
+{
+    return _n[0] * _n[1] * _n[2];
+}
+
+
+template <typename T>
+size_t Grid<T>::getSize(size_t axis)
+{
+    return _n[axis];
+}
+
+
+template <typename T>
+T Grid<T>::getSpacing(size_t axis)
+{
+    return _h[axis];
+}
+
+
+template <typename T>
+size_t Grid<T>::getDimension()
+{
+    return _n[2] > 1 ? 3 : (_n[1] > 1 ? 2 : 1);
+}
+
+
+
+/**
+ * @brief Discretize a PDE in space by the method of lines. The result is an
+ * ODESystem with fields * grid.size() equations, evaluated with a single call
+ * of rhs per evaluation, which any of the ODE methods can integrate.
+ *
+ * @tparam T
+ * @param grid
+ * @param fields Number of fields (unknown functions) on the grid.
+ * @param rhs Right hand side, usually built from the grid's stencil operators.
+ * @param initial Initial values of every field, in the layout of pdeFunction_t.
+ * @param bounds
+ * @param timeStep
+ * @return ODESystem<T>
+ */
+template <typename T>
+ODESystem<T> discretize(Grid<T>& grid, size_t fields, pdeFunction_t<T> rhs, std::vector<T> initial, timeBound_t<T>& bounds, T timeStep)
+{
+    if (initial.size() != fields * grid.size())
+        throw std::invalid_argument("Initial values must cover every field on the grid");
+
+    std::vector<T> values(1, bounds.first);
+    values.insert(values.end(), initial.begin(), initial.end());
+    iv_t<T> iValues(values);
+
+    systemFunction_t<T> func([rhs](const std::vector<T>& args, std::vector<T>& out) mutable {
+        rhs(args[0], args.data() + 1, out.data());
+    });
+
+    return ODESystem<T>(iValues, func, bounds, timeStep);
+}
+
+
+} // namespace DES
+
+
+#endif
@@ -0,0 +1,144 @@
+#ifndef DIFFEQ_RANDOM_H
+#define DIFFEQ_RANDOM_H
+
+#include <cmath>
+#include <cstdint>
+
+
+namespace DES
+{
+
+/**
+ * @brief Philox4x32-10 counter-based random number generator (Salmon et al.,
+ * "Parallel random numbers: as easy as 1, 2, 3", SC11). The output is a pure
+ * function of (key, counter), so any draw of any stream can be reproduced
+ * without generating the ones before it, and streams that are handed out to
+ * different threads never share state.
+ */
+class philox_t
+{
+
+private:
+    uint32_t _key[2];
+
+    static void _mulhilo(uint32_t a, uint32_t b, uint32_t& hi, uint32_t& lo)
+    {
+        uint64_t p = (uint64_t)a * (uint64_t)b;
+        hi = (uint32_t)(p >> 32);
+        lo = (uint32_t)p;
+    }
+
+public:
+    philox_t(uint64_t seed = 0)
+    {
+        _key[0] = (uint32_t)seed;
+        _key[1] = (uint32_t)(seed >> 32);
+    }
+
+
+    /**
+     * @brief Generate the block of four 32-bit words for a 128-bit counter.
+     *
+     * @param ctr Counter, overwritten with the random output.
+     */
+    void operator()(uint32_t ctr[4]) const
+    {
+        uint32_t k0 = _key[0], k1 = _key[1];
+
+        for (int round = 0; round < 10; round++)
+        {
+            uint32_t hi0, lo0, hi1, lo1;
+            _mulhilo(0xD2511F53u, ctr[0], hi0, lo0);
+            _mulhilo(0xCD9E8D57u, ctr[2], hi1, lo1);
+
+            uint32_t c0 = hi1 ^ ctr[1] ^ k0;
+            uint32_t c2 = hi0 ^ ctr[3] ^ k1;
+            ctr[0] = c0;
+            ctr[1] = lo1;
+            ctr[2] = c2;
+            ctr[3] = lo0;
+
+            k0 += 0x9E3779B9u;
+            k1 += 0xBB67AE85u;
+        }
+    }
+};
+
+
+/**
+ * @brief Stream of standard normal numbers for one sample path. Draw n of path
+ * p is generated from the counter (n / 2, p), so the stream of a path does not
+ * depend on which thread integrates it or on how many other paths exist.
+ *
+ * @tparam T
+ */
+template <typename T>
+class normalStream_t
+{
+
+private:
+    philox_t _rng;
+    uint64_t _path;
+    uint64_t _counter;
+    T _cached;
+    bool _hasCached;
+
+public:
+    normalStream_t(uint64_t seed = 0, uint64_t path = 0)
+        : _rng(seed)
+        , _path(path)
+        , _counter(0)
+        , _hasCached(false)
+    { }
+
+
+    /**
+     * @brief Restart the stream from its first draw.
+     */
+    void reset()
+    {
+        _counter = 0;
+        _hasCached = false;
+    }
+
+
+    /**
+     * @brief Next standard normal number, by the Box-Muller transform of two
+     * 53-bit uniforms (computed in double precision for every T).
+     *
+     * @return T
+     */
+    T next()
+    {
+        if (_hasCached)
+        {
+            _hasCached = false;
+            return _cached;
+        }
+
+        uint32_t block[4] = {
+            (uint32_t)_counter, (uint32_t)(_counter >> 32),
+            (uint32_t)_path,    (uint32_t)(_path >> 32)
+        };
+        _counter++;
+        _rng(block);
+
+        // (0, 1] so the logarithm is finite
+        const double scale = 1.0 / 9007199254740992.0;  // 2^-53
+        double u1 = ((((uint64_t)block[0] << 32) | block[1]) >> 11) * scale + scale;
+        double u2 = ((((uint64_t)block[2] << 32) | block[3]) >> 11) * scale;
+
+        double r = std::sqrt(-2.0 * std::log(u1));
+        double theta = 6.283185307179586476925 * u2;
+
+        _cached = (T)(r * std::sin(theta));
+        _hasCached = true;
+        return (T)(r * std::cos(theta));
+    }
+};
+
+
+} // namespace DES
+
+
+#endif
@@ -0,0 +1,14 @@
+#ifndef DIFFEQ_RESTRICT_H
+#define DIFFEQ_RESTRICT_H
+
+
+// pointers that are the only way their data is reached within a loop, so the
+// compiler may keep values in registers and vectorize across them
+#if defined(__GNUC__) || defined(__clang__) || defined(_MSC_VER)
+    #define  _DIFFEQ_RESTRICT           __restrict
+#else
+    #define  _DIFFEQ_RESTRICT
+#endif
+
+
+#endif
@@ -0,0 +1,214 @@
+#ifndef DIFFEQ_SDE_H
+#define DIFFEQ_SDE_H
+
+#include <cstdint>
+#include <functional>
+#include <stdexcept>
+#include <vector>
+
+#include "ode.h"
+#include "solver.h"
+#include "random.h"
+
+
+namespace DES
+{
+
+/**
+ * @brief A system of Ito stochastic differential equations with diagonal noise,
+ * dy_j = f_j(t, y_1, ...) dt + g_j(t, y_1, ...) dW_j, where each component is
+ * driven by its own Wiener process. The noise of a sample path is fixed by
+ * (seed, path), so an ensemble can be split over threads in any way and every
+ * path is still reproduced bit for bit.
+ *
+ * @tparam T
+ */
+template <typename T>
+class SDESystem
+{
+
+private:
+    std::vector<function_t<T>> _drift;
+    std::vector<function_t<T>> _diffusion;
+    timeBound_t<T> _timeBound;
+    iv_t<T> _iValues;
+    T _timeStep;
+    uint64_t _seed;
+    uint64_t _path;
+
+public:
+    std::vector<T> lastValues;
+    normalStream_t<T> noise;
+
+    SDESystem() = default;
+    SDESystem(iv_t<T>& iValues, std::initializer_list<function_t<T>> drift, std::initializer_list<function_t<T>> diffusion,
+        timeBound_t<T>& bounds, T timeStep, uint64_t seed, uint64_t path = 0)
+        : _drift(drift)
+        , _diffusion(diffusion)
+        , _timeBound(bounds)
+        , _iValues(iValues)
+        , _timeStep(timeStep)
+        , _seed(seed)
+        , _path(path)
+        , noise(seed, path)
+    {
+        if (_drift.size() != _diffusion.size())
+            throw std::runtime_error("Each equation needs a drift and a diffusion function");
+
+        lastValues = iValues.vec;
+    }
+
+    std::vector<T>  _evalDrift      (std::vector<T>& inputs);
+    std::vector<T>  _evalDiffusion  (std::vector<T>& inputs);
+    ODESystem<T>    _getODESystem   ();
+    void            setPath         (uint64_t path);
+    uint64_t        getPath         ();
+    iv_t<T>         getInitialConditions();
+    timeBound_t<T>  getTimeBound    ();
+    T               getTimeStep     ();
+    size_t          getNumEquations ();
+};
+
+
+
+template <typename T>   DataFrame<T>    _EM         (SDESystem<T>& sde);
+template <typename T>   DataFrame<T>    _MILSTEIN   (SDESystem<T>& sde);
+template <typename T>   DataFrame<T>    _SRA1       (SDESystem<T>& sde);
+template <typename T>   DataFrame<T>    _SRA1       (SDESystem<T>& sde, options_t<T> options);
+
+template <typename T>   std::vector<T>  _EM_i       (SDESystem<T>& sde);
+template <typename T>   std::vector<T>  _MILSTEIN_i (SDESystem<T>& sde);
+
+
+
+template <typename T>
+std::vector<T> SDESystem<T>::_evalDrift(std::vector<T>& inputs)
+{
+    std::vector<T> res;
+    for (function_t<T>& func : _drift)
+        res.push_back(func(inputs));
+
+    return res;
+}
+
+
+template <typename T>
+std::vector<T> SDESystem<T>::_evalDiffusion(std::vector<T>& inputs)
+{
+    std::vector<T> res;
+    for (function_t<T>& func : _diffusion)
+        res.push_back(func(inputs));
+
+    return res;
+}
+
+
+/**
+ * @brief The deterministic part dy = f(t, y) dt as an ODE system, for the
+ * starting step size of the adaptive methods.
+ *
+ * @tparam T
+ * @return ODESystem<T>
+ */
+template <typename T>
+ODESystem<T> SDESystem<T>::_getODESystem()
+{
+    return ODESystem<T>(_iValues, _drift, _timeBound, _timeStep);
+}
+
+
+/**
+ * @brief Select the sample path, which restarts the noise from its first draw
+ * and the stepping from the initial conditions. Paths with the same seed and
+ * index are identical.
+ *
+ * @tparam T
+ * @param path
+ */
+template <typename T>
+void SDESystem<T>::setPath(uint64_t path)
+{
+    _path = path;
+    noise = normalStream_t<T>(_seed, path);
+    lastValues = _iValues.vec;
+}
+
+
+template <typename T>
+uint64_t SDESystem<T>::getPath()
+{
+    return _path;
+}
+
+
+template <typename T>
+iv_t<T> SDESystem<T>::getInitialConditions()
+{
+    return _iValues;
+}
+
+
+template <typename T>
+timeBound_t<T> SDESystem<T>::getTimeBound()
+{
+    return _timeBound;
+}
+
+
+template <typename T>
+T SDESystem<T>::getTimeStep()
+{
+    return _timeStep;
+}
+
+
+template <typename T>
+size_t SDESystem<T>::getNumEquations()
+{
+    return _drift.size();
+}
+
+
+template <typename T>
+DataFrame<T> solve(SDESystem<T>& eq, algorithm_t alg)
+{
+    switch (alg)
+    {
+        case ALGORITHM_EM:          return _EM(eq);
+        case ALGORITHM_MILSTEIN:    return _MILSTEIN(eq);
+        case ALGORITHM_SRA1:        return _SRA1(eq);
+
+        default:                    throw std::runtime_error("Invalid algorithm");
+    }
+}
+
+
+template <typename T>
+DataFrame<T> solve(SDESystem<T>& eq, algorithm_t alg, options_t<T> options)
+{
+    switch (alg)
+    {
+        case ALGORITHM_SRA1:        return _SRA1(eq, options);
+
+        default:                    throw std::runtime_error("Invalid algorithm");
+    }
+}
+
+
+template <typename T>
+std::vector<T> solve_i(SDESystem<T>& eq, algorithm_t alg)
+{
+    switch (alg)
+    {
+        case ALGORITHM_EM:          return _EM_i(eq);
+        case ALGORITHM_MILSTEIN:    return _MILSTEIN_i(eq);
+
+        default:                    throw std::runtime_error("Invalid algorithm");
+    }
+}
+
+
+} // namespace DES
+
+
+#endif
@@ -43,8 +43,6 @@ struct iv_t
 };
 
 
-
-
 /**
  * @brief std::function wrapper. Enforces a vector of inputs.
  * 
@@ -68,6 +66,213 @@ struct function_t
 };
 
 
+/**
+ * @brief std::function wrapper for a whole system at once. It receives the 
+ * arguments (t, y_1, ..., y_m) and writes all m derivatives to out, which is 
+ * already sized. Large systems (e.g. discretized PDEs) use this instead of one 
+ * function_t per equation, so shared work is done once per evaluation.
+ * 
+ * @tparam T 
+ */
+template <typename T>
+struct systemFunction_t
+{
+    std::function<void(const std::vector<T>&, std::vector<T>&)> _func;
+
+    systemFunction_t(std::function<void(const std::vector<T>&, std::vector<T>&)> func) {
+        _func = func;
+    }
+
+    void operator()(const std::vector<T>& args, std::vector<T>& out) 
+    {
+        _func(args, out);
+    }
+};
+
+
+/**
+ * @brief std::function wrapper for the Jacobian df/dy of a system. It receives 
+ * the arguments (t, y_1, ..., y_m) and writes the m x m Jacobian to J, row 
+ * major, J[i * m + j] = df_(i+1)/dy_(j+1). Supplying one (analytic, or from 
+ * automatic differentiation, see dual.h) replaces the finite differences of 
+ * the implicit methods.
+ * 
+ * @tparam T 
+ */
+template <typename T>
+struct jacobianFunction_t
+{
+    std::function<void(const std::vector<T>&, std::vector<T>&)> _func;
+
+    jacobianFunction_t(std::function<void(const std::vector<T>&, std::vector<T>&)> func) {
+        _func = func;
+    }
+
+    void operator()(const std::vector<T>& args, std::vector<T>& J) 
+    {
+        _func(args, J);
+    }
+};
+
+
+/**
+ * @brief std::function wrapper for a Jacobian-vector product of a system, 
+ * out = (df/dy) v at the arguments (t, y_1, ..., y_m). v and out have one 
+ * entry per equation.
+ * 
+ * @tparam T 
+ */
+template <typename T>
+struct jvpFunction_t
+{
+    std::function<void(const std::vector<T>&, const std::vector<T>&, std::vector<T>&)> _func;
+
+    jvpFunction_t(std::function<void(const std::vector<T>&, const std::vector<T>&, std::vector<T>&)> func) {
+        _func = func;
+    }
+
+    void operator()(const std::vector<T>& args, const std::vector<T>& v, std::vector<T>& out) 
+    {
+        _func(args, v, out);
+    }
+};
+
+
+/**
+ * @brief std::function wrapper for a system evaluated on a batch of n states at
+ * once, stored by component: args[i * n + l] is argument i (t, y_1, ..., y_m)
+ * of state l, and out[i * n + l] is dy_(i+1)/dt of state l. Used by
+ * EnsembleSystem, so one call covers many trajectories.
+ *
+ * @tparam T
+ */
+template <typename T>
+struct batchFunction_t
+{
+    std::function<void(const T*, T*, size_t)> _func;
+
+    batchFunction_t(std::function<void(const T*, T*, size_t)> func) {
+        _func = func;
+    }
+
+    void operator()(const T* args, T* out, size_t n)
+    {
+        _func(args, out, n);
+    }
+};
+
+
+/**
+ * @brief Settings of the Jacobian-free Newton-Krylov mode of the implicit
+ * methods, which solve their linear systems with (M - h d J) by GMRES(restart)
+ * from Jacobian-vector products instead of factoring a matrix. The products come
+ * from the system's jvpFunction_t if it has one (e.g. autodiffJVP), else from
+ * finite differences, so no m x m matrix is ever stored.
+ *
+ * A solve stops once h times its residual is below tolerance in the norm of the
+ * error test, i.e. well below the local error allowed per step. The optional
+ * preconditioner receives the arguments (t, y_1, ..., y_m), hd and a vector v,
+ * and replaces v by an approximation of (M - hd J)^-1 v.
+ *
+ * @tparam T
+ */
+template <typename T>
+struct krylov_t
+{
+    size_t restart = 30;
+    size_t maxIterations = 300;
+    T tolerance = (T)0.05;
+    std::function<void(const std::vector<T>&, T, std::vector<T>&)> preconditioner;
+
+    krylov_t() = default;
+    krylov_t(size_t k) : restart(k) { }
+};
+
+
+/**
+ * @brief Absolute and relative error tolerances used by the adaptive methods.
+ * Either may be a single value shared by every component, or one value per
+ * equation (in the same order as the initial conditions, without time). A step
+ * is accepted when the weighted RMS norm of the local error estimate, with
+ * weights atol_i + rtol_i * |y_i|, is at most 1.
+ *
+ * @tparam T
+ */
+template <typename T>
+struct tolerance_t
+{
+    std::vector<T> atol, rtol;
+
+    tolerance_t()                                           : atol{ (T)DEFAULT_MAX_ERROR }, rtol{ (T)DEFAULT_MAX_ERROR } { }
+    tolerance_t(T tol)                                      : atol{ tol }, rtol{ tol } { }
+    tolerance_t(T abs, T rel)                               : atol{ abs }, rtol{ rel } { }
+    tolerance_t(std::vector<T> abs, std::vector<T> rel)     : atol(abs), rtol(rel) { }
+
+    T absolute(size_t i) const { return atol.size() == 1 ? atol[0] : atol.at(i); }
+    T relative(size_t i) const { return rtol.size() == 1 ? rtol[0] : rtol.at(i); }
+};
+
+
+/**
+ * @brief An event is triggered when condition(t, y_1, ..., y_m) crosses zero in 
+ * the given direction (DIRECTION_RISING, DIRECTION_FALLING or DIRECTION_ANY). 
+ * The crossing is located on the interpolant of the step, so it costs no extra
+ * right hand side evaluations. At each crossing the action (if any) is called 
+ * with the state at the event, which it may modify, e.g. to reflect a velocity 
+ * in a collision. A terminal event stops the integration at the crossing. Every
+ * crossing adds the state there (before the action) to the output, so an event
+ * without an action records crossings, e.g. of a Poincare section.
+ * 
+ * @tparam T 
+ */
+template <typename T>
+struct event_t
+{
+    function_t<T> condition;
+    int direction;
+    bool terminal;
+    std::function<void(std::vector<T>&)> action;
+
+    event_t(function_t<T> cond, int dir = DIRECTION_ANY, bool term = false, std::function<void(std::vector<T>&)> act = nullptr)
+        : condition(cond)
+        , direction(dir)
+        , terminal(term)
+        , action(act)
+    { }
+};
+
+
+/**
+ * @brief Options for the adaptive methods. When saveat is empty, every accepted
+ * step is stored. Otherwise only the given (increasing) times are stored, and 
+ * they are produced by interpolating within the accepted steps, so the step 
+ * size is not limited by the output grid. In both cases the rows of events are
+ * added in time order.
+ * 
+ * Events are only detected when their function changes sign over a step, so 
+ * two crossings within one step cancel out. If that is possible, limit the step 
+ * with maxStep (0 means no limit).
+ * 
+ * @tparam T 
+ */
+template <typename T>
+struct options_t
+{
+    tolerance_t<T> tolerance;
+    std::vector<T> saveat;
+    std::vector<event_t<T>> events;
+    T maxStep = 0;
+
+    options_t() = default;
+    options_t(tolerance_t<T> tol)                           : tolerance(tol) { }
+    options_t(tolerance_t<T> tol, std::vector<T> times)     : tolerance(tol), saveat(times) { }
+};
+
+
+
+
+
+
 
 /**
  * @brief Base class for a differential equation. The ODE and PDE 
@@ -121,8 +326,15 @@ public:
     DiffEqSystem() = default;
     DiffEqSystem(iv_t<T>& iValues, std::initializer_list<function_t<T>> funcs, timeBound_t<T>& bounds, T timeStep) 
         : _functions(funcs)
+        , _timeBound(bounds)
         , _iValues(iValues)
+        , _timeStep(timeStep)
+    { } 
+
+    DiffEqSystem(iv_t<T>& iValues, std::vector<function_t<T>> funcs, timeBound_t<T>& bounds, T timeStep) 
+        : _functions(funcs)
         , _timeBound(bounds)
+        , _iValues(iValues)
         , _timeStep(timeStep)
     { } 
 
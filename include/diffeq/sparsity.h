@@ -0,0 +1,344 @@
+#ifndef DIFFEQ_SPARSITY_H
+#define DIFFEQ_SPARSITY_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <iterator>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+
+// Sparsity of the Jacobian df/dy. Columns that have no nonzero row in common
+// can be perturbed together: one evaluation of f along the sum of their unit
+// vectors gives all of them, because every row only sees one of the columns.
+// Grouping the columns this way is a distance-2 coloring of the bipartite
+// row/column graph (Coleman and More, 1983), and the Jacobian costs one
+// evaluation per color instead of one per column; for a banded Jacobian of
+// bandwidth b that is b evaluations, whatever m is. The bandwidth of the pattern
+// also lets the implicit solvers factor their iteration matrix as a band matrix.
+
+
+namespace DES
+{
+
+/**
+ * @brief Nonzero pattern of an m x m Jacobian together with a coloring of its
+ * columns. Column j has color colors[j], and groups[c] lists the columns of
+ * color c, which can be evaluated together.
+ *
+ */
+struct sparsity_t
+{
+    size_t m = 0;
+    std::vector<std::vector<size_t>> columns;   // rows with a nonzero, per column
+    std::vector<size_t> colors;
+    std::vector<std::vector<size_t>> groups;
+    size_t blockSize = 0;                       // of a block tridiagonal pattern, 0 if not declared
+
+    sparsity_t() = default;
+
+
+    /**
+     * @brief Pattern from the rows of every column; the columns are colored
+     * greedily, largest column first.
+     *
+     * @param n Number of equations.
+     * @param cols cols[j] lists the rows i with df_i/dy_j != 0.
+     */
+    sparsity_t(size_t n, std::vector<std::vector<size_t>> cols)
+        : m(n)
+        , columns(cols)
+    {
+        if (columns.size() != m)
+            throw std::invalid_argument("Sparsity pattern must have one entry per column");
+
+        std::vector<std::vector<size_t>> rows(m);
+        for (size_t j = 0; j < m; j++)
+        {
+            std::sort(columns[j].begin(), columns[j].end());
+            columns[j].erase(std::unique(columns[j].begin(), columns[j].end()), columns[j].end());
+
+            for (size_t i : columns[j])
+            {
+                if (i >= m)
+                    throw std::invalid_argument("Sparsity pattern row out of range");
+                rows[i].push_back(j);
+            }
+        }
+
+        std::vector<size_t> order(m);
+        for (size_t j = 0; j < m; j++)
+            order[j] = j;
+        std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+            return columns[a].size() > columns[b].size();
+        });
+
+        // a color is forbidden for j if a column sharing a row with j has it
+        const size_t none = (size_t)-1;
+        std::vector<size_t> forbidden;
+        colors.assign(m, none);
+
+        for (size_t j : order)
+        {
+            for (size_t i : columns[j])
+                for (size_t k : rows[i])
+                    if (colors[k] != none)
+                    {
+                        if (forbidden.size() <= colors[k])
+                            forbidden.resize(colors[k] + 1, none);
+                        forbidden[colors[k]] = j;
+                    }
+
+            size_t c = 0;
+            while (c < forbidden.size() && forbidden[c] == j)
+                c++;
+
+            colors[j] = c;
+            if (groups.size() <= c)
+                groups.resize(c + 1);
+            groups[c].push_back(j);
+        }
+    }
+
+
+    size_t getNumColors() const
+    {
+        return groups.size();
+    }
+
+
+    /**
+     * @brief Number of subdiagonals holding a nonzero.
+     *
+     * @return size_t
+     */
+    size_t getLowerBandwidth() const
+    {
+        size_t kl = 0;
+        for (size_t j = 0; j < m; j++)
+            if (!columns[j].empty() && columns[j].back() > j)
+                kl = std::max(kl, columns[j].back() - j);
+
+        return kl;
+    }
+
+
+    /**
+     * @brief Number of superdiagonals holding a nonzero.
+     *
+     * @return size_t
+     */
+    size_t getUpperBandwidth() const
+    {
+        size_t ku = 0;
+        for (size_t j = 0; j < m; j++)
+            if (!columns[j].empty() && columns[j].front() < j)
+                ku = std::max(ku, j - columns[j].front());
+
+        return ku;
+    }
+};
+
+
+/**
+ * @brief Pattern of a band matrix, for declaring the bandwidth of a Jacobian
+ * without detecting it.
+ *
+ * @param m Number of equations.
+ * @param kl Number of subdiagonals.
+ * @param ku Number of superdiagonals.
+ * @return sparsity_t
+ */
+inline sparsity_t bandedSparsity(size_t m, size_t kl, size_t ku)
+{
+    std::vector<std::vector<size_t>> cols(m);
+    for (size_t j = 0; j < m; j++)
+        for (size_t i = j > ku ? j - ku : 0; i <= j + kl && i < m; i++)
+            cols[j].push_back(i);
+
+    return sparsity_t(m, cols);
+}
+
+
+/**
+ * @brief Pattern of a block tridiagonal matrix, with N diagonal blocks of size
+ * bs and full blocks beside them, as from a one dimensional discretization
+ * with bs components per cell. ALGORITHM_RB23 factors its iteration matrix by
+ * blocks (linalg/banded.h) instead of as a band, for blocks of 4 or more.
+ *
+ * @param N Number of diagonal blocks.
+ * @param bs Size of a block.
+ * @return sparsity_t
+ */
+inline sparsity_t blockTridiagonalSparsity(size_t N, size_t bs)
+{
+    std::vector<std::vector<size_t>> cols(N * bs);
+    for (size_t j = 0; j < N * bs; j++)
+        for (size_t i = j / bs > 0 ? (j / bs - 1) * bs : 0; i < (j / bs + 2) * bs && i < N * bs; i++)
+            cols[j].push_back(i);
+
+    sparsity_t pattern(N * bs, cols);
+    pattern.blockSize = bs;
+    return pattern;
+}
+
+
+/**
+ * @brief Scalar that records which state components a value depends on, for
+ * detecting the sparsity of a right hand side by evaluating it once. It also
+ * carries the value, so branches take the path of the point of evaluation;
+ * dependencies that only appear on other paths are not seen.
+ *
+ * @tparam T
+ */
+template <typename T>
+struct tracer_t
+{
+    typedef T value_type;
+
+    T value;
+    std::vector<size_t> deps;       // sorted
+
+    tracer_t() : value(0) { }
+    tracer_t(const T& v) : value(v) { }
+
+    template <typename S, typename std::enable_if<std::is_arithmetic<S>::value && !std::is_same<S, T>::value, int>::type = 0>
+    tracer_t(S v) : value(T(v))
+    { }
+
+    tracer_t& operator+=(const tracer_t& b) { return *this = *this + b; }
+    tracer_t& operator-=(const tracer_t& b) { return *this = *this - b; }
+    tracer_t& operator*=(const tracer_t& b) { return *this = *this * b; }
+    tracer_t& operator/=(const tracer_t& b) { return *this = *this / b; }
+};
+
+
+template <typename T>
+inline tracer_t<T> _traceMerge(const tracer_t<T>& a, const tracer_t<T>& b, const T& value)
+{
+    tracer_t<T> res(value);
+    std::set_union(a.deps.begin(), a.deps.end(), b.deps.begin(), b.deps.end(), std::back_inserter(res.deps));
+    return res;
+}
+
+
+template <typename T>
+inline tracer_t<T> _traceKeep(const tracer_t<T>& a, const T& value)
+{
+    tracer_t<T> res(value);
+    res.deps = a.deps;
+    return res;
+}
+
+
+template <typename T> inline tracer_t<T> operator-(const tracer_t<T>& a)                         { return _traceKeep(a, T(-a.value)); }
+template <typename T> inline tracer_t<T> operator+(const tracer_t<T>& a, const tracer_t<T>& b)   { return _traceMerge(a, b, T(a.value + b.value)); }
+template <typename T> inline tracer_t<T> operator-(const tracer_t<T>& a, const tracer_t<T>& b)   { return _traceMerge(a, b, T(a.value - b.value)); }
+template <typename T> inline tracer_t<T> operator*(const tracer_t<T>& a, const tracer_t<T>& b)   { return _traceMerge(a, b, T(a.value * b.value)); }
+template <typename T> inline tracer_t<T> operator/(const tracer_t<T>& a, const tracer_t<T>& b)   { return _traceMerge(a, b, T(a.value / b.value)); }
+
+template <typename T> inline tracer_t<T> operator+(const tracer_t<T>& a, const typename tracer_t<T>::value_type& b)   { return _traceKeep(a, T(a.value + b)); }
+template <typename T> inline tracer_t<T> operator+(const typename tracer_t<T>::value_type& a, const tracer_t<T>& b)   { return _traceKeep(b, T(a + b.value)); }
+template <typename T> inline tracer_t<T> operator-(const tracer_t<T>& a, const typename tracer_t<T>::value_type& b)   { return _traceKeep(a, T(a.value - b)); }
+template <typename T> inline tracer_t<T> operator-(const typename tracer_t<T>::value_type& a, const tracer_t<T>& b)   { return _traceKeep(b, T(a - b.value)); }
+template <typename T> inline tracer_t<T> operator*(const tracer_t<T>& a, const typename tracer_t<T>::value_type& b)   { return _traceKeep(a, T(a.value * b)); }
+template <typename T> inline tracer_t<T> operator*(const typename tracer_t<T>::value_type& a, const tracer_t<T>& b)   { return _traceKeep(b, T(a * b.value)); }
+template <typename T> inline tracer_t<T> operator/(const tracer_t<T>& a, const typename tracer_t<T>::value_type& b)   { return _traceKeep(a, T(a.value / b)); }
+template <typename T> inline tracer_t<T> operator/(const typename tracer_t<T>::value_type& a, const tracer_t<T>& b)   { return _traceKeep(b, T(a / b.value)); }
+
+
+#define  _TRACER_COMPARE(op)                                                                                                        \
+    template <typename T> inline bool operator op(const tracer_t<T>& a, const tracer_t<T>& b)                    { return a.value op b.value; } \
+    template <typename T> inline bool operator op(const tracer_t<T>& a, const typename tracer_t<T>::value_type& b) { return a.value op b; }     \
+    template <typename T> inline bool operator op(const typename tracer_t<T>::value_type& a, const tracer_t<T>& b) { return a op b.value; }
+
+_TRACER_COMPARE(==)
+_TRACER_COMPARE(!=)
+_TRACER_COMPARE(<)
+_TRACER_COMPARE(>)
+_TRACER_COMPARE(<=)
+_TRACER_COMPARE(>=)
+
+#undef _TRACER_COMPARE
+
+
+using std::abs;
+using std::fabs;
+using std::sqrt;
+using std::exp;
+using std::log;
+using std::pow;
+using std::sin;
+using std::cos;
+using std::tan;
+using std::tanh;
+
+
+#define  _TRACER_UNARY(name)                                                                        \
+    template <typename T> inline tracer_t<T> name(const tracer_t<T>& a) { return _traceKeep(a, T(name(a.value))); }
+
+_TRACER_UNARY(abs)
+_TRACER_UNARY(fabs)
+_TRACER_UNARY(sqrt)
+_TRACER_UNARY(exp)
+_TRACER_UNARY(log)
+_TRACER_UNARY(sin)
+_TRACER_UNARY(cos)
+_TRACER_UNARY(tan)
+_TRACER_UNARY(tanh)
+
+#undef _TRACER_UNARY
+
+
+template <typename T>
+inline tracer_t<T> pow(const tracer_t<T>& a, const typename tracer_t<T>::value_type& p)
+{
+    return _traceKeep(a, T(pow(a.value, p)));
+}
+
+
+template <typename T>
+inline tracer_t<T> pow(const tracer_t<T>& a, const tracer_t<T>& p)
+{
+    return _traceMerge(a, p, T(pow(a.value, p.value)));
+}
+
+
+/**
+ * @brief Detect the Jacobian sparsity of a right hand side by evaluating it once
+ * on tracers at the given point. func is written generically in its scalar
+ * type, as for autodiffJacobian (see dual.h).
+ *
+ * @tparam T
+ * @tparam F
+ * @param func
+ * @param args Point of evaluation (t, y_1, ..., y_m), e.g. the initial
+ * conditions.
+ * @return sparsity_t
+ */
+template <typename T, typename F>
+sparsity_t detectSparsity(F func, const std::vector<T>& args)
+{
+    size_t m = args.size() - 1;
+
+    std::vector<tracer_t<T>> x(args.begin(), args.end()), out(m);
+    for (size_t j = 0; j < m; j++)
+        x[j + 1].deps.push_back(j);
+
+    func(x, out);
+
+    std::vector<std::vector<size_t>> cols(m);
+    for (size_t i = 0; i < m; i++)
+        for (size_t j : out[i].deps)
+            cols[j].push_back(i);
+
+    return sparsity_t(m, cols);
+}
+
+
+} // namespace DES
+
+
+#endif
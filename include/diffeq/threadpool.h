@@ -0,0 +1,137 @@
+#ifndef DIFFEQ_THREADPOOL_H
+#define DIFFEQ_THREADPOOL_H
+
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+
+namespace DES
+{
+
+/**
+ * @brief Fixed set of worker threads for the parallel drivers. Work is handed
+ * out with parallelFor, which blocks until every index has been processed, so
+ * the pool can be reused by one solve after another.
+ */
+class ThreadPool
+{
+
+private:
+    std::vector<std::thread> _workers;
+    std::queue<std::function<void()>> _tasks;
+    std::mutex _mutex;
+    std::condition_variable _available;
+    bool _stop = false;
+
+    void _run()
+    {
+        while (true)
+        {
+            std::function<void()> task;
+            {
+                std::unique_lock<std::mutex> lock(_mutex);
+                _available.wait(lock, [this] { return _stop || !_tasks.empty(); });
+
+                if (_stop && _tasks.empty())
+                    return;
+
+                task = std::move(_tasks.front());
+                _tasks.pop();
+            }
+
+            task();
+        }
+    }
+
+public:
+    ThreadPool(size_t threads = 0)
+    {
+        if (threads == 0)
+            threads = std::thread::hardware_concurrency() > 0 ? std::thread::hardware_concurrency() : 1;
+
+        for (size_t i = 0; i < threads; i++)
+            _workers.emplace_back([this] { _run(); });
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    ~ThreadPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _stop = true;
+        }
+
+        _available.notify_all();
+        for (std::thread& worker : _workers)
+            worker.join();
+    }
+
+
+    size_t size() const
+    {
+        return _workers.size();
+    }
+
+
+    /**
+     * @brief Call func(i) for every i in [begin, end) on the workers and wait for
+     * all of them. If any call throws, the first exception is rethrown here
+     * after the others have finished.
+     *
+     * @param begin
+     * @param end
+     * @param func
+     */
+    void parallelFor(size_t begin, size_t end, std::function<void(size_t)> func)
+    {
+        if (begin >= end)
+            return;
+
+        std::mutex doneMutex;
+        std::condition_variable done;
+        size_t remaining = end - begin;
+        std::exception_ptr error;
+
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            for (size_t i = begin; i < end; i++)
+                _tasks.push([&, i] {
+                    try 
+                    {
+                        func(i);
+                    }
+                    catch (...)
+                    {
+                        std::lock_guard<std::mutex> errorLock(doneMutex);
+                        if (!error)
+                            error = std::current_exception();
+                    }
+
+                    std::lock_guard<std::mutex> doneLock(doneMutex);
+                    if (--remaining == 0)
+                        done.notify_one();
+                });
+        }
+
+        _available.notify_all();
+
+        std::unique_lock<std::mutex> lock(doneMutex);
+        done.wait(lock, [&] { return remaining == 0; });
+
+        if (error)
+            std::rethrow_exception(error);
+    }
+};
+
+
+} // namespace DES
+
+
+#endif
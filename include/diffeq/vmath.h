@@ -0,0 +1,1063 @@
+#ifndef DIFFEQ_VMATH_H
+#define DIFFEQ_VMATH_H
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+
+
+// Elementary functions over arrays, for right hand sides that work on batches
+// of states (see batchFunction_t): vsin, vcos, vsincos, vexp, vlog, vpow and
+// vtanh. For float and double they evaluate a whole SIMD register of arguments
+// at once, with AVX-512 (-mavx512f), AVX2 (-mavx2 -mfma) or NEON (AArch64),
+// whichever the compiler targets; otherwise, for other types, or with
+// DIFFEQ_VMATH_SCALAR defined, they call the scalar functions of <cmath>.
+//
+// The SIMD kernels reduce the argument and evaluate a polynomial: exp by
+// x = n ln2 + r with 2^n built in the exponent bits, log from the mantissa with
+// the atanh series of fdlibm, sin and cos by a three part Cody-Waite reduction
+// modulo pi/2 with fused multiply-adds and the fdlibm (double) or Cephes
+// (float) kernels, tanh by its Taylor series below 0.55 and 1 - 2/(e^2x + 1)
+// above. pow(x, y) is exp(y log x) with log x carried in double-double, and in
+// double for float arguments. Measured maximum errors, in units in the last
+// place, against long double references on a few million random arguments:
+//
+//            float     double
+//  sin/cos   1.53      1.52        |x| <= 1e5 (float), 1e8 (double), libm beyond
+//  exp       1.0       1.0
+//  log       1.0       1.0
+//  pow       0.6       1.5
+//  tanh      1.6       1.6
+//
+// Special values (0, infinities, NaN, subnormals, negative bases of pow)
+// follow C99 Annex F.
+
+
+#if !defined(DIFFEQ_VMATH_SCALAR) && defined(__AVX512F__)
+    #define _VMATH_AVX512
+    #include <immintrin.h>
+#elif !defined(DIFFEQ_VMATH_SCALAR) && defined(__AVX2__) && defined(__FMA__)
+    #define _VMATH_AVX2
+    #include <immintrin.h>
+#elif !defined(DIFFEQ_VMATH_SCALAR) && defined(__ARM_NEON) && defined(__aarch64__)
+    #define _VMATH_NEON
+    #include <arm_neon.h>
+#endif
+
+#if defined(_VMATH_AVX512) || defined(_VMATH_AVX2) || defined(_VMATH_NEON)
+    #define _VMATH_SIMD
+#endif
+
+
+namespace DES
+{
+
+/**
+ * @brief One SIMD register of T: vector V, integer lanes of the same width I
+ * and lane mask M, with the operations the kernels below need. Specialized for
+ * float and double on the targeted instruction set.
+ *
+ * @tparam T
+ */
+template <typename T>
+struct _simd;
+
+
+#if defined(_VMATH_AVX512)
+
+template <>
+struct _simd<double>
+{
+    typedef __m512d V;
+    typedef __m512i I;
+    typedef __mmask8 M;
+    static constexpr size_t width = 8;
+
+    static V load(const double* p)      { return _mm512_loadu_pd(p); }
+    static void store(double* p, V a)   { _mm512_storeu_pd(p, a); }
+    static V set(double a)              { return _mm512_set1_pd(a); }
+    static V add(V a, V b)              { return _mm512_add_pd(a, b); }
+    static V sub(V a, V b)              { return _mm512_sub_pd(a, b); }
+    static V mul(V a, V b)              { return _mm512_mul_pd(a, b); }
+    static V div(V a, V b)              { return _mm512_div_pd(a, b); }
+    static V fma(V a, V b, V c)         { return _mm512_fmadd_pd(a, b, c); }
+    static V round(V a)                 { return _mm512_maskz_roundscale_pd((M)-1, a, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC); }
+    static V abs(V a)                   { return _mm512_abs_pd(a); }
+    static M lt(V a, V b)               { return _mm512_cmp_pd_mask(a, b, _CMP_LT_OQ); }
+    static M eq(V a, V b)               { return _mm512_cmp_pd_mask(a, b, _CMP_EQ_OQ); }
+    static M unord(V a)                 { return _mm512_cmp_pd_mask(a, a, _CMP_UNORD_Q); }
+    static M lor(M a, M b)              { return (M)(a | b); }
+    static M land(M a, M b)             { return (M)(a & b); }
+    static V select(M m, V a, V b)      { return _mm512_mask_blend_pd(m, b, a); }
+    static bool any(M m)                { return m != 0; }
+    static I bits(V a)                  { return _mm512_castpd_si512(a); }
+    static V fromBits(I a)              { return _mm512_castsi512_pd(a); }
+    static I iset(int64_t a)            { return _mm512_set1_epi64(a); }
+    static I iadd(I a, I b)             { return _mm512_add_epi64(a, b); }
+    static I isub(I a, I b)             { return _mm512_sub_epi64(a, b); }
+    static I iand(I a, I b)             { return _mm512_and_si512(a, b); }
+    static I ior(I a, I b)              { return _mm512_or_si512(a, b); }
+    static I ixor(I a, I b)             { return _mm512_xor_si512(a, b); }
+    static I shl(I a, int n)            { return _mm512_maskz_sll_epi64((M)-1, a, _mm_cvtsi32_si128(n)); }
+    static I shr(I a, int n)            { return _mm512_maskz_srl_epi64((M)-1, a, _mm_cvtsi32_si128(n)); }
+    static M inz(I a)                   { return _mm512_test_epi64_mask(a, a); }
+};
+
+
+template <>
+struct _simd<float>
+{
+    typedef __m512 V;
+    typedef __m512i I;
+    typedef __mmask16 M;
+    static constexpr size_t width = 16;
+
+    static V load(const float* p)       { return _mm512_loadu_ps(p); }
+    static void store(float* p, V a)    { _mm512_storeu_ps(p, a); }
+    static V set(float a)               { return _mm512_set1_ps(a); }
+    static V add(V a, V b)              { return _mm512_add_ps(a, b); }
+    static V sub(V a, V b)              { return _mm512_sub_ps(a, b); }
+    static V mul(V a, V b)              { return _mm512_mul_ps(a, b); }
+    static V div(V a, V b)              { return _mm512_div_ps(a, b); }
+    static V fma(V a, V b, V c)         { return _mm512_fmadd_ps(a, b, c); }
+    static V round(V a)                 { return _mm512_maskz_roundscale_ps((M)-1, a, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC); }
+    static V abs(V a)                   { return _mm512_abs_ps(a); }
+    static M lt(V a, V b)               { return _mm512_cmp_ps_mask(a, b, _CMP_LT_OQ); }
+    static M eq(V a, V b)               { return _mm512_cmp_ps_mask(a, b, _CMP_EQ_OQ); }
+    static M unord(V a)                 { return _mm512_cmp_ps_mask(a, a, _CMP_UNORD_Q); }
+    static M lor(M a, M b)              { return (M)(a | b); }
+    static M land(M a, M b)             { return (M)(a & b); }
+    static V select(M m, V a, V b)      { return _mm512_mask_blend_ps(m, b, a); }
+    static bool any(M m)                { return m != 0; }
+    static I bits(V a)                  { return _mm512_castps_si512(a); }
+    static V fromBits(I a)              { return _mm512_castsi512_ps(a); }
+    static I iset(int32_t a)            { return _mm512_set1_epi32(a); }
+    static I iadd(I a, I b)             { return _mm512_add_epi32(a, b); }
+    static I isub(I a, I b)             { return _mm512_sub_epi32(a, b); }
+    static I iand(I a, I b)             { return _mm512_and_si512(a, b); }
+    static I ior(I a, I b)              { return _mm512_or_si512(a, b); }
+    static I ixor(I a, I b)             { return _mm512_xor_si512(a, b); }
+    static I shl(I a, int n)            { return _mm512_maskz_sll_epi32((M)-1, a, _mm_cvtsi32_si128(n)); }
+    static I shr(I a, int n)            { return _mm512_maskz_srl_epi32((M)-1, a, _mm_cvtsi32_si128(n)); }
+    static M inz(I a)                   { return _mm512_test_epi32_mask(a, a); }
+};
+
+#elif defined(_VMATH_AVX2)
+
+template <>
+struct _simd<double>
+{
+    typedef __m256d V;
+    typedef __m256i I;
+    typedef __m256d M;
+    static constexpr size_t width = 4;
+
+    static V load(const double* p)      { return _mm256_loadu_pd(p); }
+    static void store(double* p, V a)   { _mm256_storeu_pd(p, a); }
+    static V set(double a)              { return _mm256_set1_pd(a); }
+    static V add(V a, V b)              { return _mm256_add_pd(a, b); }
+    static V sub(V a, V b)              { return _mm256_sub_pd(a, b); }
+    static V mul(V a, V b)              { return _mm256_mul_pd(a, b); }
+    static V div(V a, V b)              { return _mm256_div_pd(a, b); }
+    static V fma(V a, V b, V c)         { return _mm256_fmadd_pd(a, b, c); }
+    static V round(V a)                 { return _mm256_round_pd(a, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC); }
+    static V abs(V a)                   { return _mm256_andnot_pd(_mm256_set1_pd(-0.0), a); }
+    static M lt(V a, V b)               { return _mm256_cmp_pd(a, b, _CMP_LT_OQ); }
+    static M eq(V a, V b)               { return _mm256_cmp_pd(a, b, _CMP_EQ_OQ); }
+    static M unord(V a)                 { return _mm256_cmp_pd(a, a, _CMP_UNORD_Q); }
+    static M lor(M a, M b)              { return _mm256_or_pd(a, b); }
+    static M land(M a, M b)             { return _mm256_and_pd(a, b); }
+    static V select(M m, V a, V b)      { return _mm256_blendv_pd(b, a, m); }
+    static bool any(M m)                { return _mm256_movemask_pd(m) != 0; }
+    static I bits(V a)                  { return _mm256_castpd_si256(a); }
+    static V fromBits(I a)              { return _mm256_castsi256_pd(a); }
+    static I iset(int64_t a)            { return _mm256_set1_epi64x(a); }
+    static I iadd(I a, I b)             { return _mm256_add_epi64(a, b); }
+    static I isub(I a, I b)             { return _mm256_sub_epi64(a, b); }
+    static I iand(I a, I b)             { return _mm256_and_si256(a, b); }
+    static I ior(I a, I b)              { return _mm256_or_si256(a, b); }
+    static I ixor(I a, I b)             { return _mm256_xor_si256(a, b); }
+    static I shl(I a, int n)            { return _mm256_sll_epi64(a, _mm_cvtsi32_si128(n)); }
+    static I shr(I a, int n)            { return _mm256_srl_epi64(a, _mm_cvtsi32_si128(n)); }
+    static M inz(I a)
+    {
+        return _mm256_castsi256_pd(_mm256_xor_si256(_mm256_cmpeq_epi64(a, _mm256_setzero_si256()), _mm256_set1_epi64x(-1)));
+    }
+};
+
+
+template <>
+struct _simd<float>
+{
+    typedef __m256 V;
+    typedef __m256i I;
+    typedef __m256 M;
+    static constexpr size_t width = 8;
+
+    static V load(const float* p)       { return _mm256_loadu_ps(p); }
+    static void store(float* p, V a)    { _mm256_storeu_ps(p, a); }
+    static V set(float a)               { return _mm256_set1_ps(a); }
+    static V add(V a, V b)              { return _mm256_add_ps(a, b); }
+    static V sub(V a, V b)              { return _mm256_sub_ps(a, b); }
+    static V mul(V a, V b)              { return _mm256_mul_ps(a, b); }
+    static V div(V a, V b)              { return _mm256_div_ps(a, b); }
+    static V fma(V a, V b, V c)         { return _mm256_fmadd_ps(a, b, c); }
+    static V round(V a)                 { return _mm256_round_ps(a, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC); }
+    static V abs(V a)                   { return _mm256_andnot_ps(_mm256_set1_ps(-0.0f), a); }
+    static M lt(V a, V b)               { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+    static M eq(V a, V b)               { return _mm256_cmp_ps(a, b, _CMP_EQ_OQ); }
+    static M unord(V a)                 { return _mm256_cmp_ps(a, a, _CMP_UNORD_Q); }
+    static M lor(M a, M b)              { return _mm256_or_ps(a, b); }
+    static M land(M a, M b)             { return _mm256_and_ps(a, b); }
+    static V select(M m, V a, V b)      { return _mm256_blendv_ps(b, a, m); }
+    static bool any(M m)                { return _mm256_movemask_ps(m) != 0; }
+    static I bits(V a)                  { return _mm256_castps_si256(a); }
+    static V fromBits(I a)              { return _mm256_castsi256_ps(a); }
+    static I iset(int32_t a)            { return _mm256_set1_epi32(a); }
+    static I iadd(I a, I b)             { return _mm256_add_epi32(a, b); }
+    static I isub(I a, I b)             { return _mm256_sub_epi32(a, b); }
+    static I iand(I a, I b)             { return _mm256_and_si256(a, b); }
+    static I ior(I a, I b)              { return _mm256_or_si256(a, b); }
+    static I ixor(I a, I b)             { return _mm256_xor_si256(a, b); }
+    static I shl(I a, int n)            { return _mm256_sll_epi32(a, _mm_cvtsi32_si128(n)); }
+    static I shr(I a, int n)            { return _mm256_srl_epi32(a, _mm_cvtsi32_si128(n)); }
+    static M inz(I a)
+    {
+        return _mm256_castsi256_ps(_mm256_xor_si256(_mm256_cmpeq_epi32(a, _mm256_setzero_si256()), _mm256_set1_epi32(-1)));
+    }
+};
+
+#elif defined(_VMATH_NEON)
+
+template <>
+struct _simd<double>
+{
+    typedef float64x2_t V;
+    typedef int64x2_t I;
+    typedef uint64x2_t M;
+    static constexpr size_t width = 2;
+
+    static V load(const double* p)      { return vld1q_f64(p); }
+    static void store(double* p, V a)   { vst1q_f64(p, a); }
+    static V set(double a)              { return vdupq_n_f64(a); }
+    static V add(V a, V b)              { return vaddq_f64(a, b); }
+    static V sub(V a, V b)              { return vsubq_f64(a, b); }
+    static V mul(V a, V b)              { return vmulq_f64(a, b); }
+    static V div(V a, V b)              { return vdivq_f64(a, b); }
+    static V fma(V a, V b, V c)         { return vfmaq_f64(c, a, b); }
+    static V round(V a)                 { return vrndnq_f64(a); }
+    static V abs(V a)                   { return vabsq_f64(a); }
+    static M lt(V a, V b)               { return vcltq_f64(a, b); }
+    static M eq(V a, V b)               { return vceqq_f64(a, b); }
+    static M unord(V a)                 { return veorq_u64(vceqq_f64(a, a), vdupq_n_u64(~0ull)); }
+    static M lor(M a, M b)              { return vorrq_u64(a, b); }
+    static M land(M a, M b)             { return vandq_u64(a, b); }
+    static V select(M m, V a, V b)      { return vbslq_f64(m, a, b); }
+    static bool any(M m)                { return vmaxvq_u32(vreinterpretq_u32_u64(m)) != 0; }
+    static I bits(V a)                  { return vreinterpretq_s64_f64(a); }
+    static V fromBits(I a)              { return vreinterpretq_f64_s64(a); }
+    static I iset(int64_t a)            { return vdupq_n_s64(a); }
+    static I iadd(I a, I b)             { return vaddq_s64(a, b); }
+    static I isub(I a, I b)             { return vsubq_s64(a, b); }
+    static I iand(I a, I b)             { return vandq_s64(a, b); }
+    static I ior(I a, I b)              { return vorrq_s64(a, b); }
+    static I ixor(I a, I b)             { return veorq_s64(a, b); }
+    static I shl(I a, int n)            { return vshlq_s64(a, vdupq_n_s64(n)); }
+    static I shr(I a, int n)            { return vreinterpretq_s64_u64(vshlq_u64(vreinterpretq_u64_s64(a), vdupq_n_s64(-n))); }
+    static M inz(I a)                   { return veorq_u64(vceqq_s64(a, vdupq_n_s64(0)), vdupq_n_u64(~0ull)); }
+};
+
+
+template <>
+struct _simd<float>
+{
+    typedef float32x4_t V;
+    typedef int32x4_t I;
+    typedef uint32x4_t M;
+    static constexpr size_t width = 4;
+
+    static V load(const float* p)       { return vld1q_f32(p); }
+    static void store(float* p, V a)    { vst1q_f32(p, a); }
+    static V set(float a)               { return vdupq_n_f32(a); }
+    static V add(V a, V b)              { return vaddq_f32(a, b); }
+    static V sub(V a, V b)              { return vsubq_f32(a, b); }
+    static V mul(V a, V b)              { return vmulq_f32(a, b); }
+    static V div(V a, V b)              { return vdivq_f32(a, b); }
+    static V fma(V a, V b, V c)         { return vfmaq_f32(c, a, b); }
+    static V round(V a)                 { return vrndnq_f32(a); }
+    static V abs(V a)                   { return vabsq_f32(a); }
+    static M lt(V a, V b)               { return vcltq_f32(a, b); }
+    static M eq(V a, V b)               { return vceqq_f32(a, b); }
+    static M unord(V a)                 { return vmvnq_u32(vceqq_f32(a, a)); }
+    static M lor(M a, M b)              { return vorrq_u32(a, b); }
+    static M land(M a, M b)             { return vandq_u32(a, b); }
+    static V select(M m, V a, V b)      { return vbslq_f32(m, a, b); }
+    static bool any(M m)                { return vmaxvq_u32(m) != 0; }
+    static I bits(V a)                  { return vreinterpretq_s32_f32(a); }
+    static V fromBits(I a)              { return vreinterpretq_f32_s32(a); }
+    static I iset(int32_t a)            { return vdupq_n_s32(a); }
+    static I iadd(I a, I b)             { return vaddq_s32(a, b); }
+    static I isub(I a, I b)             { return vsubq_s32(a, b); }
+    static I iand(I a, I b)             { return vandq_s32(a, b); }
+    static I ior(I a, I b)              { return vorrq_s32(a, b); }
+    static I ixor(I a, I b)             { return veorq_s32(a, b); }
+    static I shl(I a, int n)            { return vshlq_s32(a, vdupq_n_s32(n)); }
+    static I shr(I a, int n)            { return vreinterpretq_s32_u32(vshlq_u32(vreinterpretq_u32_s32(a), vdupq_n_s32(-n))); }
+    static M inz(I a)                   { return vtstq_s32(a, a); }
+};
+
+#endif
+
+
+/**
+ * @brief Constants of the kernels: the floating point format, reduction
+ * constants and polynomial coefficients, lowest degree first.
+ *
+ * @tparam T
+ */
+template <typename T>
+struct _vmathConst;
+
+
+template <>
+struct _vmathConst<double>
+{
+    static constexpr int mantissa = 52;
+    static constexpr int64_t bias = 1023;
+    static constexpr double magic = 6755399441055744.0;             // 1.5 * 2^52, rounds to integers
+    static constexpr double minNormal = 2.2250738585072014e-308;
+    static constexpr double subnormalScale = 18014398509481984.0;   // 2^54
+    static constexpr double subnormalShift = 54;
+    static constexpr double sqrt2 = 1.4142135623730951;
+
+    static constexpr double expMax = 709.782712893384;
+    static constexpr double expMin = -745.1332191019412;
+    static constexpr double log2e = 1.4426950408889634;
+    static constexpr double ln2Hi = 6.93147180369123816490e-01;    // 32 trailing zero bits
+    static constexpr double ln2Lo = 1.90821492927058770002e-10;
+
+    // e^r = sum r^k / k! on |r| <= ln2 / 2
+    static constexpr double expPoly[] = {
+        1.0, 1.0, 1.0 / 2, 1.0 / 6, 1.0 / 24, 1.0 / 120, 1.0 / 720, 1.0 / 5040, 1.0 / 40320, 1.0 / 362880,
+        1.0 / 3628800, 1.0 / 39916800, 1.0 / 479001600, 1.0 / 6227020800.0
+    };
+
+    // log(1 + f) = f - f^2 / 2 + s (f^2 / 2 + z P(z)), s = f / (2 + f), z = s^2
+    static constexpr double logPoly[] = {
+        6.666666666666735130e-01, 3.999999999940941908e-01, 2.857142874366239149e-01, 2.222219843214978396e-01,
+        1.818357216161805012e-01, 1.531383769920937332e-01, 1.479819860511658591e-01
+    };
+
+    // for pow: 2/3 in double-double and the atanh series from s^5 on
+    static constexpr double twoThirds[] = { 0.6666666666666666, 3.700743415417188e-17 };
+    static constexpr double logSeries[] = {
+        2.0 / 5, 2.0 / 7, 2.0 / 9, 2.0 / 11, 2.0 / 13, 2.0 / 15, 2.0 / 17, 2.0 / 19, 2.0 / 21, 2.0 / 23, 2.0 / 25
+    };
+
+    static constexpr double twoOverPi = 0.6366197723675814;
+    static constexpr double pio2[] = { 1.5707963267948966, 6.123233995736766e-17, -1.4973849048591698e-33 };
+    static constexpr double trigMax = 1e8;
+
+    // sin r = r + r^3 P(r^2), cos r = 1 - r^2 / 2 + r^4 Q(r^2) on |r| <= pi / 4
+    static constexpr double sinPoly[] = {
+        -1.66666666666666324348e-01, 8.33333333332248946124e-03, -1.98412698298579493134e-04,
+        2.75573137070700676789e-06, -2.50507602534068634195e-08, 1.58969099521155010221e-10
+    };
+    static constexpr double cosPoly[] = {
+        4.16666666666666019037e-02, -1.38888888888741095749e-03, 2.48015872894767294178e-05,
+        -2.75573143513906633035e-07, 2.08757232129817482790e-09, -1.13596475577881948265e-11
+    };
+
+    // tanh x = x P(x^2) on |x| < 0.55, the Taylor series
+    static constexpr double tanhSmall = 0.55;
+    static constexpr double tanhPoly[] = {
+        1.0, -3.33333333333333315e-01, 1.33333333333333331e-01, -5.39682539682539708e-02, 2.18694885361552030e-02,
+        -8.86323552990219733e-03, 3.59212803657248114e-03, -1.45583438705131833e-03, 5.90027440945585947e-04,
+        -2.39129114243552478e-04, 9.69153795692945095e-05, -3.92783238833168327e-05, 1.59189050693289637e-05,
+        -6.45168921565543065e-06, 2.61477115129075465e-06, -1.05972683201046543e-06, 4.29491107827380574e-07,
+        -1.74066189635716480e-07, 7.05463694640096814e-08
+    };
+};
+
+
+template <>
+struct _vmathConst<float>
+{
+    static constexpr int mantissa = 23;
+    static constexpr int32_t bias = 127;
+    static constexpr float magic = 12582912.0f;                     // 1.5 * 2^23
+    static constexpr float minNormal = 1.17549435e-38f;
+    static constexpr float subnormalScale = 33554432.0f;            // 2^25
+    static constexpr float subnormalShift = 25;
+    static constexpr float sqrt2 = 1.41421356f;
+
+    static constexpr float expMax = 88.7228394f;
+    static constexpr float expMin = -103.972084f;
+    static constexpr float log2e = 1.44269504f;
+    static constexpr float ln2Hi = 6.9313812256e-01f;
+    static constexpr float ln2Lo = 9.0580006145e-06f;
+
+    static constexpr float expPoly[] = {
+        1.0f, 1.0f, 1.0f / 2, 1.0f / 6, 1.0f / 24, 1.0f / 120, 1.0f / 720, 1.0f / 5040
+    };
+
+    static constexpr float logPoly[] = {
+        6.6666662693e-01f, 4.0000972152e-01f, 2.8498786688e-01f, 2.4279078841e-01f
+    };
+
+    static constexpr float twoOverPi = 0.636619772f;
+    static constexpr float pio2[] = { 1.5707963705e+00f, -4.3711388287e-08f, -1.7151245100e-15f };
+    static constexpr float trigMax = 1e5f;
+
+    static constexpr float sinPoly[] = { -1.6666654611e-1f, 8.3321608736e-3f, -1.9515295891e-4f };
+    static constexpr float cosPoly[] = { 4.166664568298827e-2f, -1.388731625493765e-3f, 2.443315711809948e-5f };
+
+    static constexpr float tanhSmall = 0.55f;
+    static constexpr float tanhPoly[] = {
+        1.0f, -3.33333333e-01f, 1.33333333e-01f, -5.39682540e-02f, 2.18694885e-02f, -8.86323553e-03f,
+        3.59212804e-03f, -1.45583439e-03f, 5.90027441e-04f
+    };
+};
+
+
+#if defined(_VMATH_SIMD)
+
+template <typename T, size_t N>
+typename _simd<T>::V _vpoly(typename _simd<T>::V x, const T (&c)[N])
+{
+    typedef _simd<T> S;
+
+    typename S::V p = S::set(c[N - 1]);
+    for (size_t i = N - 1; i-- > 0;)
+        p = S::fma(p, x, S::set(c[i]));
+
+    return p;
+}
+
+
+/**
+ * @brief 2^k for integral k in the normal range, built in the exponent bits.
+ *
+ * @tparam T
+ */
+template <typename T>
+typename _simd<T>::V _vpow2(typename _simd<T>::V k)
+{
+    typedef _simd<T> S;
+    typedef _vmathConst<T> C;
+
+    typename S::I n = S::isub(S::bits(S::add(k, S::set(C::magic))), S::bits(S::set(C::magic)));
+    return S::fromBits(S::shl(S::iadd(n, S::iset(C::bias)), C::mantissa));
+}
+
+
+/**
+ * @brief e^(x + lo), for a small correction lo of x.
+ *
+ * @tparam T
+ */
+template <typename T>
+typename _simd<T>::V _vexpKernel(typename _simd<T>::V x, typename _simd<T>::V lo)
+{
+    typedef _simd<T> S;
+    typedef _vmathConst<T> C;
+    typedef typename S::V V;
+
+    V n = S::round(S::mul(x, S::set(C::log2e)));
+    V r = S::fma(n, S::set(-C::ln2Hi), x);
+    r = S::add(S::fma(n, S::set(-C::ln2Lo), r), lo);
+
+    // two factors, so that 2^n may be subnormal or 2^1024
+    V n1 = S::round(S::mul(n, S::set(T(0.5))));
+    V p = _vpoly<T>(r, C::expPoly);
+    p = S::mul(S::mul(p, _vpow2<T>(n1)), _vpow2<T>(S::sub(n, n1)));
+
+    p = S::select(S::lt(S::set(C::expMax), x), S::set(std::numeric_limits<T>::infinity()), p);
+    return S::select(S::lt(x, S::set(C::expMin)), S::set(T(0)), p);
+}
+
+
+/**
+ * @brief x = 2^k (1 + f) with 1 + f in [sqrt(2) / 2, sqrt(2)), for positive
+ * finite x.
+ *
+ * @tparam T
+ */
+template <typename T>
+void _vlogReduce(typename _simd<T>::V x, typename _simd<T>::V& k, typename _simd<T>::V& f)
+{
+    typedef _simd<T> S;
+    typedef _vmathConst<T> C;
+    typedef typename S::V V;
+    typedef typename S::M M;
+
+    M tiny = S::lt(x, S::set(C::minNormal));
+    x = S::select(tiny, S::mul(x, S::set(C::subnormalScale)), x);
+
+    typename S::I b = S::bits(x);
+    typename S::I e = S::isub(S::shr(b, C::mantissa), S::iset(C::bias));
+    k = S::sub(S::fromBits(S::iadd(e, S::bits(S::set(C::magic)))), S::set(C::magic));
+    k = S::select(tiny, S::sub(k, S::set(C::subnormalShift)), k);
+
+    V one = S::set(T(1));
+    V m = S::fromBits(S::ior(S::iand(b, S::iset(((decltype(C::bias))1 << C::mantissa) - 1)), S::bits(one)));
+    M big = S::lt(S::set(C::sqrt2), m);
+    m = S::select(big, S::mul(m, S::set(T(0.5))), m);
+    k = S::select(big, S::add(k, one), k);
+
+    f = S::sub(m, one);
+}
+
+
+/**
+ * @brief log x = hi + lo for positive finite x, to about 2^-66 absolute, for
+ * pow. With s = f / (2 + f), log(1 + f) = 2 s + 2/3 s^3 + 2/5 s^5 + ..., where
+ * s and the s^3 term are carried in double-double.
+ *
+ * @tparam T
+ */
+template <typename T>
+void _vlogExtended(typename _simd<T>::V x, typename _simd<T>::V& hi, typename _simd<T>::V& lo)
+{
+    typedef _simd<T> S;
+    typedef _vmathConst<T> C;
+    typedef typename S::V V;
+
+    V k, f;
+    _vlogReduce<T>(x, k, f);
+
+    V two = S::set(T(2));
+    V d = S::add(two, f);
+    V dLo = S::add(S::sub(two, d), f);
+    V s = S::div(f, d);
+    V sLo = S::div(S::fma(S::sub(S::set(T(0)), s), dLo, S::fma(S::sub(S::set(T(0)), s), d, f)), d);
+
+    // s^3 and 2/3 s^3
+    V z = S::mul(s, s);
+    V zLo = S::fma(s, s, S::sub(S::set(T(0)), z));
+    V c = S::mul(s, z);
+    V cLo = S::fma(s, z, S::sub(S::set(T(0)), c));
+    cLo = S::fma(s, zLo, S::fma(S::mul(S::set(T(3)), z), sLo, cLo));
+    // an FMA, so that compilers cannot contract the product into the sum below
+    V p = S::fma(c, S::set(C::twoThirds[0]), S::set(T(0)));
+    V pLo = S::fma(c, S::set(C::twoThirds[0]), S::sub(S::set(T(0)), p));
+    pLo = S::fma(cLo, S::set(C::twoThirds[0]), S::fma(c, S::set(C::twoThirds[1]), pLo));
+
+    V rest = S::mul(S::mul(c, z), _vpoly<T>(z, C::logSeries));
+
+    // k ln2Hi + 2 s + p, summed exactly
+    V t = S::mul(k, S::set(C::ln2Hi));
+    V s2 = S::add(s, s);
+    V h1 = S::add(t, s2);
+    V b1 = S::sub(h1, t);
+    V e1 = S::add(S::sub(t, S::sub(h1, b1)), S::sub(s2, b1));
+    V h2 = S::add(h1, p);
+    V b2 = S::sub(h2, h1);
+    V e2 = S::add(S::sub(h1, S::sub(h2, b2)), S::sub(p, b2));
+
+    lo = S::add(S::add(e1, e2), S::add(S::add(sLo, sLo), pLo));
+    lo = S::add(lo, S::fma(k, S::set(C::ln2Lo), rest));
+    hi = S::add(h2, lo);
+    lo = S::sub(lo, S::sub(hi, h2));
+}
+
+
+template <typename T>
+typename _simd<T>::V _vexp(typename _simd<T>::V x)
+{
+    typedef _simd<T> S;
+    return _vexpKernel<T>(x, S::set(T(0)));
+}
+
+
+template <typename T>
+typename _simd<T>::V _vlog(typename _simd<T>::V x)
+{
+    typedef _simd<T> S;
+    typedef _vmathConst<T> C;
+    typedef typename S::V V;
+
+    // log(1 + f) = f - f^2 / 2 + s (f^2 / 2 + z P(z)), s = f / (2 + f), z = s^2
+    V k, f;
+    _vlogReduce<T>(x, k, f);
+
+    V s = S::div(f, S::add(S::set(T(2)), f));
+    V z = S::mul(s, s);
+    V hfsq = S::mul(S::mul(S::set(T(0.5)), f), f);
+    V tail = S::fma(s, S::fma(z, _vpoly<T>(z, C::logPoly), hfsq), S::mul(k, S::set(C::ln2Lo)));
+    V res = S::fma(k, S::set(C::ln2Hi), S::sub(f, S::sub(hfsq, tail)));
+
+    V inf = S::set(std::numeric_limits<T>::infinity());
+    res = S::select(S::eq(x, inf), inf, res);
+    res = S::select(S::lt(x, S::set(T(0))), S::set(std::numeric_limits<T>::quiet_NaN()), res);
+    res = S::select(S::eq(x, S::set(T(0))), S::set(-std::numeric_limits<T>::infinity()), res);
+    return S::select(S::unord(x), x, res);
+}
+
+
+/**
+ * @brief x^y for x != 0 and finite x, y. Negative x give NaN unless y is an
+ * integer.
+ *
+ * @tparam T
+ */
+template <typename T>
+typename _simd<T>::V _vpow(typename _simd<T>::V x, typename _simd<T>::V y)
+{
+    typedef _simd<T> S;
+    typedef typename S::V V;
+
+    V hi, lo;
+    _vlogExtended<T>(S::abs(x), hi, lo);
+
+    V p = S::mul(y, hi);
+    V pLo = S::fma(y, lo, S::fma(y, hi, S::sub(S::set(T(0)), p)));
+    V res = _vexpKernel<T>(p, pLo);
+
+    V zero = S::set(T(0));
+    typename S::M negative = S::lt(x, zero);
+    V half = S::round(S::mul(y, S::set(T(0.5))));
+    typename S::M odd = S::eq(S::abs(S::fma(half, S::set(T(-2)), y)), S::set(T(1)));
+    typename S::M fraction = S::lt(zero, S::abs(S::sub(y, S::round(y))));
+
+    res = S::select(S::land(negative, odd), S::mul(res, S::set(T(-1))), res);
+    return S::select(S::land(negative, fraction), S::set(std::numeric_limits<T>::quiet_NaN()), res);
+}
+
+
+template <typename T>
+typename _simd<T>::V _vtanh(typename _simd<T>::V x)
+{
+    typedef _simd<T> S;
+    typedef _vmathConst<T> C;
+    typedef typename S::V V;
+
+    V a = S::abs(x);
+    V one = S::set(T(1));
+
+    V e = _vexp<T>(S::add(a, a));
+    V large = S::sub(one, S::div(S::set(T(2)), S::add(e, one)));
+    V small = S::mul(a, _vpoly<T>(S::mul(a, a), C::tanhPoly));
+    V res = S::select(S::lt(a, S::set(C::tanhSmall)), small, large);
+
+    return S::fromBits(S::ior(S::bits(res), S::iand(S::bits(x), S::bits(S::set(T(-0.0))))));
+}
+
+
+/**
+ * @brief sin x and cos x for |x| <= trigMax; larger arguments are left to the
+ * caller.
+ *
+ * @tparam T
+ */
+template <typename T>
+void _vsincos(typename _simd<T>::V x, typename _simd<T>::V& s, typename _simd<T>::V& c)
+{
+    typedef _simd<T> S;
+    typedef _vmathConst<T> C;
+    typedef typename S::V V;
+    typedef typename S::I I;
+
+    // x = q pi / 2 + r, |r| <= pi / 4; the first product is exact with the FMA
+    V q = S::round(S::mul(x, S::set(C::twoOverPi)));
+    V r = S::fma(q, S::set(-C::pio2[0]), x);
+    r = S::fma(q, S::set(-C::pio2[1]), r);
+    r = S::fma(q, S::set(-C::pio2[2]), r);
+
+    V z = S::mul(r, r);
+    V one = S::set(T(1));
+    V sr = S::fma(S::mul(z, r), _vpoly<T>(z, C::sinPoly), r);
+    V hz = S::mul(z, S::set(T(0.5)));
+    V w = S::sub(one, hz);
+    V cr = S::add(w, S::fma(S::mul(z, z), _vpoly<T>(z, C::cosPoly), S::sub(S::sub(one, w), hz)));
+
+    // the low bits of q + magic are q mod 4
+    I qi = S::bits(S::add(q, S::set(C::magic)));
+    typename S::M swap = S::inz(S::iand(qi, S::iset(1)));
+    int sign = 8 * sizeof(T) - 2;
+
+    s = S::select(swap, cr, sr);
+    c = S::select(swap, sr, cr);
+    s = S::fromBits(S::ixor(S::bits(s), S::shl(S::iand(qi, S::iset(2)), sign)));
+    c = S::fromBits(S::ixor(S::bits(c), S::shl(S::iand(S::iadd(qi, S::iset(1)), S::iset(2)), sign)));
+    s = S::select(S::eq(x, S::set(T(0))), x, s);        // sin(-0) = -0
+}
+
+
+/**
+ * @brief Replace the lanes of res where |x| > trigMax (or x is infinite) by
+ * f(x), from <cmath>.
+ *
+ * @tparam T
+ * @tparam F
+ */
+template <typename T, typename F>
+typename _simd<T>::V _vtrigLarge(typename _simd<T>::V x, typename _simd<T>::V res, F f)
+{
+    typedef _simd<T> S;
+
+    if (!S::any(S::lt(S::set(_vmathConst<T>::trigMax), S::abs(x))))
+        return res;
+
+    T xs[S::width], rs[S::width];
+    S::store(xs, x);
+    S::store(rs, res);
+    for (size_t l = 0; l < S::width; l++)
+        if (!(std::abs(xs[l]) <= _vmathConst<T>::trigMax))
+            rs[l] = f(xs[l]);
+
+    return S::load(rs);
+}
+
+
+/**
+ * @brief Apply kernel to x[0 .. n) in registers of S::width, out may be x. The
+ * remainder goes through a padded register.
+ *
+ * @tparam T
+ * @tparam K
+ */
+template <typename T, typename K>
+void _vmap(K kernel, const T* x, T* out, size_t n)
+{
+    typedef _simd<T> S;
+
+    size_t i = 0;
+    for (; i + S::width <= n; i += S::width)
+        S::store(out + i, kernel(S::load(x + i)));
+
+    if (i < n)
+    {
+        T buffer[S::width] = {};
+        for (size_t l = 0; i + l < n; l++)
+            buffer[l] = x[i + l];
+        S::store(buffer, kernel(S::load(buffer)));
+        for (size_t l = 0; i + l < n; l++)
+            out[i + l] = buffer[l];
+    }
+}
+
+
+/**
+ * @brief _vmap for kernels of two arguments.
+ *
+ * @tparam T
+ * @tparam K
+ */
+template <typename T, typename K>
+void _vmap2(K kernel, const T* x, const T* y, T* out, size_t n)
+{
+    typedef _simd<T> S;
+
+    size_t i = 0;
+    for (; i + S::width <= n; i += S::width)
+        S::store(out + i, kernel(S::load(x + i), S::load(y + i)));
+
+    if (i < n)
+    {
+        T xb[S::width] = {}, yb[S::width] = {};
+        for (size_t l = 0; i + l < n; l++)
+        {
+            xb[l] = x[i + l];
+            yb[l] = y[i + l];
+        }
+        S::store(xb, kernel(S::load(xb), S::load(yb)));
+        for (size_t l = 0; i + l < n; l++)
+            out[i + l] = xb[l];
+    }
+}
+
+
+/**
+ * @brief x^y with the special cases (zeros, infinities, NaN) left to std::pow.
+ *
+ * @tparam T
+ */
+template <typename T>
+typename _simd<T>::V _vpowFull(typename _simd<T>::V x, typename _simd<T>::V y)
+{
+    typedef _simd<T> S;
+
+    typename S::V res = _vpow<T>(x, y);
+    typename S::V inf = S::set(std::numeric_limits<T>::infinity());
+
+    if (!S::any(S::lor(S::lor(S::eq(x, S::set(T(0))), S::unord(S::mul(x, y))),
+                       S::lor(S::eq(S::abs(x), inf), S::eq(S::abs(y), inf)))))
+        return res;
+
+    T xs[S::width], ys[S::width], rs[S::width];
+    S::store(xs, x);
+    S::store(ys, y);
+    S::store(rs, res);
+    for (size_t l = 0; l < S::width; l++)
+        if (xs[l] == 0 || std::isnan(xs[l] * ys[l]) || std::isinf(xs[l]) || std::isinf(ys[l]))
+            rs[l] = std::pow(xs[l], ys[l]);
+
+    return S::load(rs);
+}
+
+
+template <typename T>
+constexpr bool _vmathSimd()
+{
+    return std::is_same<T, float>::value || std::is_same<T, double>::value;
+}
+
+#else
+
+template <typename T>
+constexpr bool _vmathSimd()
+{
+    return false;
+}
+
+#endif
+
+
+/**
+ * @brief out[i] = sin(x[i]) for i < n. out may be x.
+ *
+ * @tparam T
+ * @param x
+ * @param out
+ * @param n
+ */
+template <typename T>
+void vsin(const T* x, T* out, size_t n)
+{
+#if defined(_VMATH_SIMD)
+    if constexpr (_vmathSimd<T>())
+    {
+        typedef typename _simd<T>::V V;
+        _vmap<T>([](V v) {
+            V s, c;
+            _vsincos<T>(v, s, c);
+            return _vtrigLarge<T>(v, s, [](T a) { return std::sin(a); });
+        }, x, out, n);
+        return;
+    }
+#endif
+
+    using std::sin;
+    for (size_t i = 0; i < n; i++)
+        out[i] = sin(x[i]);
+}
+
+
+/**
+ * @brief out[i] = cos(x[i]) for i < n. out may be x.
+ *
+ * @tparam T
+ * @param x
+ * @param out
+ * @param n
+ */
+template <typename T>
+void vcos(const T* x, T* out, size_t n)
+{
+#if defined(_VMATH_SIMD)
+    if constexpr (_vmathSimd<T>())
+    {
+        typedef typename _simd<T>::V V;
+        _vmap<T>([](V v) {
+            V s, c;
+            _vsincos<T>(v, s, c);
+            return _vtrigLarge<T>(v, c, [](T a) { return std::cos(a); });
+        }, x, out, n);
+        return;
+    }
+#endif
+
+    using std::cos;
+    for (size_t i = 0; i < n; i++)
+        out[i] = cos(x[i]);
+}
+
+
+/**
+ * @brief s[i] = sin(x[i]) and c[i] = cos(x[i]) for i < n, sharing the argument
+ * reduction. s or c may be x.
+ *
+ * @tparam T
+ * @param x
+ * @param s
+ * @param c
+ * @param n
+ */
+template <typename T>
+void vsincos(const T* x, T* s, T* c, size_t n)
+{
+#if defined(_VMATH_SIMD)
+    if constexpr (_vmathSimd<T>())
+    {
+        typedef _simd<T> S;
+        typedef typename S::V V;
+
+        auto kernel = [](V v, T* s, T* c) {
+            V vs, vc;
+            _vsincos<T>(v, vs, vc);
+            S::store(s, _vtrigLarge<T>(v, vs, [](T a) { return std::sin(a); }));
+            S::store(c, _vtrigLarge<T>(v, vc, [](T a) { return std::cos(a); }));
+        };
+
+        size_t i = 0;
+        for (; i + S::width <= n; i += S::width)
+            kernel(S::load(x + i), s + i, c + i);
+
+        if (i < n)
+        {
+            T xb[S::width] = {}, sb[S::width], cb[S::width];
+            for (size_t l = 0; i + l < n; l++)
+                xb[l] = x[i + l];
+            kernel(S::load(xb), sb, cb);
+            for (size_t l = 0; i + l < n; l++)
+            {
+                s[i + l] = sb[l];
+                c[i + l] = cb[l];
+            }
+        }
+        return;
+    }
+#endif
+
+    using std::sin; using std::cos;
+    for (size_t i = 0; i < n; i++)
+    {
+        T a = x[i];
+        s[i] = sin(a);
+        c[i] = cos(a);
+    }
+}
+
+
+/**
+ * @brief out[i] = e^x[i] for i < n. out may be x.
+ *
+ * @tparam T
+ * @param x
+ * @param out
+ * @param n
+ */
+template <typename T>
+void vexp(const T* x, T* out, size_t n)
+{
+#if defined(_VMATH_SIMD)
+    if constexpr (_vmathSimd<T>())
+    {
+        _vmap<T>([](typename _simd<T>::V v) { return _vexp<T>(v); }, x, out, n);
+        return;
+    }
+#endif
+
+    using std::exp;
+    for (size_t i = 0; i < n; i++)
+        out[i] = exp(x[i]);
+}
+
+
+/**
+ * @brief out[i] = log(x[i]) for i < n, the natural logarithm. out may be x.
+ *
+ * @tparam T
+ * @param x
+ * @param out
+ * @param n
+ */
+template <typename T>
+void vlog(const T* x, T* out, size_t n)
+{
+#if defined(_VMATH_SIMD)
+    if constexpr (_vmathSimd<T>())
+    {
+        _vmap<T>([](typename _simd<T>::V v) { return _vlog<T>(v); }, x, out, n);
+        return;
+    }
+#endif
+
+    using std::log;
+    for (size_t i = 0; i < n; i++)
+        out[i] = log(x[i]);
+}
+
+
+/**
+ * @brief out[i] = tanh(x[i]) for i < n. out may be x.
+ *
+ * @tparam T
+ * @param x
+ * @param out
+ * @param n
+ */
+template <typename T>
+void vtanh(const T* x, T* out, size_t n)
+{
+#if defined(_VMATH_SIMD)
+    if constexpr (_vmathSimd<T>())
+    {
+        _vmap<T>([](typename _simd<T>::V v) { return _vtanh<T>(v); }, x, out, n);
+        return;
+    }
+#endif
+
+    using std::tanh;
+    for (size_t i = 0; i < n; i++)
+        out[i] = tanh(x[i]);
+}
+
+
+/**
+ * @brief out[i] = x[i]^y[i] for i < n. out may be x or y. float arguments are
+ * raised in double, which rounds correctly in all but rare cases.
+ *
+ * @tparam T
+ * @param x
+ * @param y
+ * @param out
+ * @param n
+ */
+template <typename T>
+void vpow(const T* x, const T* y, T* out, size_t n)
+{
+#if defined(_VMATH_SIMD)
+    if constexpr (std::is_same<T, float>::value)
+    {
+        double xd[64], yd[64];
+        for (size_t i = 0; i < n; i += 64)
+        {
+            size_t w = n - i < 64 ? n - i : 64;
+            for (size_t l = 0; l < w; l++)
+            {
+                xd[l] = x[i + l];
+                yd[l] = y[i + l];
+            }
+
+            // log and exp in double are accurate enough for a float result
+            _vmap2<double>([](_simd<double>::V a, _simd<double>::V b) {
+                return _vexp<double>(_simd<double>::mul(b, _vlog<double>(a)));
+            }, xd, yd, xd, w);
+
+            for (size_t l = 0; l < w; l++)
+                out[i + l] = x[i + l] > 0 && std::isfinite(x[i + l]) && std::isfinite(y[i + l])
+                    ? (float)xd[l] : std::pow(x[i + l], y[i + l]);
+        }
+        return;
+    }
+    else if constexpr (std::is_same<T, double>::value)
+    {
+        _vmap2<double>([](_simd<double>::V a, _simd<double>::V b) { return _vpowFull<double>(a, b); }, x, y, out, n);
+        return;
+    }
+#endif
+
+    using std::pow;
+    for (size_t i = 0; i < n; i++)
+        out[i] = pow(x[i], y[i]);
+}
+
+
+} // namespace DES
+
+
+#endif
@@ -0,0 +1,76 @@
+#define DIFFEQ_DOUBLE_PRECISION
+#include "diffeq.h"
+#include "check.h"
+
+#define T double
+
+using namespace DES;
+
+
+// y' = -a y + b over [0, 2], G = y(2), whose gradient is known in closed form:
+// y(t) = y0 e^(-a t) + b / a (1 - e^(-a t))
+void decay()
+{
+    const T a = 0.8, b = 0.3, y0 = 1.5, tf = 2;
+
+    iv_t<T> iv = {0.0, y0};
+    timeBound_t<T> bounds = {0.0, tf};
+
+    ParametricODESystem<T> sys(iv, parametricFunction_t<T>([](const std::vector<T>& args, const std::vector<T>& p, std::vector<T>& out) {
+        out[0] = -p[0] * args[1] + p[1];
+    }), {a, b}, bounds, 0.01);
+
+    std::function<std::vector<T>(const std::vector<T>&)> dGdy = [](const std::vector<T>&) { return std::vector<T>{1}; };
+
+    T e = std::exp(-a * tf);
+    T dy0 = e;
+    T db = (1 - e) / a;
+    T da = -tf * y0 * e - b / (a * a) * (1 - e) + b / a * tf * e;
+
+    // the recomputed steps are the same steps, so the gradient does not depend
+    // on the number of checkpoints
+    adjoint_t<T> all = solveAdjoint(sys, dGdy, 200);
+
+    for (size_t checkpoints : {200, 5, 1})
+    {
+        adjoint_t<T> grad = solveAdjoint(sys, dGdy, checkpoints);
+        check(grad.dParams == all.dParams && grad.dInitial == all.dInitial, "decay: same gradient for any checkpoints");
+
+        checkBelow("decay: y(t_f)", grad.y[1] - (y0 * e + b / a * (1 - e)), 1e-9);
+        checkBelow("decay: dG/dy0", grad.dInitial[0] - dy0, 1e-8);
+        checkBelow("decay: dG/da", grad.dParams[0] - da, 1e-6);
+        checkBelow("decay: dG/db", grad.dParams[1] - db, 1e-6);
+    }
+}
+
+
+// harmonic oscillator x'' = -w^2 x, x(0) = 1, v(0) = 0, G = x(t_f) = cos(w t_f):
+// dG/dw = -t_f sin(w t_f), dG/dx0 = cos(w t_f), dG/dv0 = sin(w t_f) / w
+void oscillator()
+{
+    const T w = 1.3, tf = 3;
+
+    iv_t<T> iv = {0.0, 1.0, 0.0};
+    timeBound_t<T> bounds = {0.0, tf};
+
+    ParametricODESystem<T> sys(iv, parametricFunction_t<T>([](const std::vector<T>& args, const std::vector<T>& p, std::vector<T>& out) {
+        out[0] = args[2];
+        out[1] = -p[0] * p[0] * args[1];
+    }), {w}, bounds, 0.005);
+
+    adjoint_t<T> grad = solveAdjoint(sys, std::function<std::vector<T>(const std::vector<T>&)>(
+        [](const std::vector<T>&) { return std::vector<T>{1, 0}; }), 10);
+
+    checkBelow("oscillator: dG/dw", grad.dParams[0] + tf * std::sin(w * tf), 1e-6);
+    checkBelow("oscillator: dG/dx0", grad.dInitial[0] - std::cos(w * tf), 1e-8);
+    checkBelow("oscillator: dG/dv0", grad.dInitial[1] - std::sin(w * tf) / w, 1e-8);
+}
+
+
+int main()
+{
+    decay();
+    oscillator();
+
+    return report();
+}
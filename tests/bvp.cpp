@@ -0,0 +1,106 @@
+#define DIFFEQ_DOUBLE_PRECISION
+#include "diffeq.h"
+#include "check.h"
+
+#include <algorithm>
+#include <stdexcept>
+#define T double
+
+using namespace DES;
+
+
+T maxError(DataFrame<T>& res, std::function<T(T)> exact)
+{
+    T e = 0;
+    for (size_t i = 0; i < res.getNumRows(); i++)
+        e = std::max(e, std::fabs(res.getRow(i)[1] - exact(res.getRow(i)[0])));
+
+    return e;
+}
+
+
+// y'' = 100 y, y(0) = y(1) = 1: y = cosh(10 (t - 1/2)) / cosh 5. The growing
+// mode e^(10 t) makes single shooting lose digits, segments keep it in check
+void fastModes()
+{
+    iv_t<T> iv = {0.0, 1.0, 0.0};
+    timeBound_t<T> bounds = {0.0, 1.0};
+
+    ODESystem<T> ode(iv, systemFunction_t<T>([](const std::vector<T>& a, std::vector<T>& out) {
+        out[0] = a[2];
+        out[1] = 100 * a[1];
+    }), bounds, 0);
+
+    boundaryFunction_t<T> bc([](const std::vector<T>& ya, const std::vector<T>& yb, std::vector<T>& out) {
+        out[0] = ya[1] - 1;
+        out[1] = yb[1] - 1;
+    });
+
+    DataFrame<T> res = solveBVP(ode, bc, bvpOptions_t<T>(10));
+
+    checkBelow("fast modes: t end", res.getRow(res.getNumRows() - 1)[0] - 1, 1e-12);
+    checkBelow("fast modes: error", maxError(res, [](T t) { return std::cosh(10 * (t - 0.5)) / std::cosh(5.0); }), 1e-8);
+}
+
+
+// Bratu's problem y'' + e^y = 0, y(0) = y(1) = 0, lower solution
+// y = -2 log(cosh((t - 1/2) theta / 2) / cosh(theta / 4)) with
+// theta = sqrt(2) cosh(theta / 4), from the guess y = 0
+void bratu()
+{
+    T theta = 1;
+    for (int k = 0; k < 100; k++)
+        theta = std::sqrt(2.0) * std::cosh(theta / 4);
+
+    iv_t<T> iv = {0.0, 0.0, 0.0};
+    timeBound_t<T> bounds = {0.0, 1.0};
+
+    ODESystem<T> ode(iv, systemFunction_t<T>([](const std::vector<T>& a, std::vector<T>& out) {
+        out[0] = a[2];
+        out[1] = -std::exp(a[1]);
+    }), bounds, 0);
+
+    boundaryFunction_t<T> bc([](const std::vector<T>& ya, const std::vector<T>& yb, std::vector<T>& out) {
+        out[0] = ya[1];
+        out[1] = yb[1];
+    });
+
+    DataFrame<T> res = solveBVP(ode, bc, bvpOptions_t<T>(4));
+
+    checkBelow("bratu: error", maxError(res, [theta](T t) {
+        return -2 * std::log(std::cosh((t - 0.5) * theta / 2) / std::cosh(theta / 4));
+    }), 1e-8);
+}
+
+
+void noSegments()
+{
+    iv_t<T> iv = {0.0, 0.0, 0.0};
+    timeBound_t<T> bounds = {0.0, 1.0};
+
+    ODESystem<T> ode(iv, systemFunction_t<T>([](const std::vector<T>& a, std::vector<T>& out) {
+        out[0] = a[2];
+        out[1] = -a[1];
+    }), bounds, 0);
+
+    boundaryFunction_t<T> bc([](const std::vector<T>& ya, const std::vector<T>& yb, std::vector<T>& out) {
+        out[0] = ya[1];
+        out[1] = yb[1] - 1;
+    });
+
+    bool thrown = false;
+    try { solveBVP(ode, bc, bvpOptions_t<T>(0)); }
+    catch (std::invalid_argument&) { thrown = true; }
+
+    check(thrown, "no segments throws");
+}
+
+
+int main()
+{
+    fastModes();
+    bratu();
+    noSegments();
+
+    return report();
+}
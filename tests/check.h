@@ -0,0 +1,44 @@
+#ifndef DIFFEQ_TESTS_CHECK_H
+#define DIFFEQ_TESTS_CHECK_H
+
+#include <cmath>
+#include <cstdio>
+
+
+static int _failures = 0;
+
+
+/**
+ * @brief Record a check, printing it with the measured value and its bound.
+ *
+ * @param ok
+ * @param what
+ * @param value
+ * @param bound
+ */
+inline void check(bool ok, const char* what, double value = 0, double bound = 0)
+{
+    std::printf("%s  %-48s %12.4e  (bound %.1e)\n", ok ? "ok  " : "FAIL", what, value, bound);
+    if (!ok)
+        _failures++;
+}
+
+
+/**
+ * @brief Check that |value| is below bound; NaN fails.
+ */
+inline void checkBelow(const char* what, double value, double bound)
+{
+    check(std::fabs(value) <= bound, what, std::fabs(value), bound);
+}
+
+
+inline int report()
+{
+    if (_failures)
+        std::printf("%d check(s) failed\n", _failures);
+    return _failures ? 1 : 0;
+}
+
+
+#endif
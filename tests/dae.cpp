@@ -0,0 +1,179 @@
+#define DIFFEQ_DOUBLE_PRECISION
+#include "diffeq.h"
+#include "check.h"
+
+#include <algorithm>
+#include <stdexcept>
+#define T double
+
+using namespace DES;
+
+
+// y1' = -y1 + y2, 0 = y2 - cos t, with y1(0) = 1: a constraint that moves with t
+void timeDependentConstraint()
+{
+    for (T tol : {1e-6, 1e-8, 1e-10})
+    {
+        iv_t<T> iv = {0.0, 1.0, 1.0};
+        timeBound_t<T> bounds = {0.0, 1.0};
+
+        ODESystem<T> dae(iv, systemFunction_t<T>([](const std::vector<T>& a, std::vector<T>& out) {
+            out[0] = -a[1] + a[2];
+            out[1] = a[2] - std::cos(a[0]);
+        }), bounds, 0);
+        dae.setMassMatrix({1, 0, 0, 0});
+
+        options_t<T> options;
+        options.tolerance = tolerance_t<T>(tol, tol);
+
+        DataFrame<T> res = _RB23(dae, options);
+        std::vector<T> last = res.getRow(res.getNumRows() - 1);
+        T exact = (std::cos(1.0) + std::sin(1.0) + std::exp(-1.0)) / 2;
+
+        checkBelow("time dependent constraint: t end", last[0] - 1, 1e-12);
+        checkBelow("time dependent constraint: y1 error / tol", (last[1] - exact) / tol, 10);
+        checkBelow("time dependent constraint: y2 error / tol", (last[2] - std::cos(1.0)) / tol, 10);
+        checkBelow("time dependent constraint: steps * tol^(1/3)", res.getNumRows() * std::cbrt(tol), 10);
+    }
+}
+
+
+// output on a grid is interpolated within the steps, and must keep the tolerance
+void denseOutput()
+{
+    T tol = 1e-7;
+
+    iv_t<T> iv = {0.0, 1.0, 1.0};
+    timeBound_t<T> bounds = {0.0, 1.0};
+
+    ODESystem<T> dae(iv, systemFunction_t<T>([](const std::vector<T>& a, std::vector<T>& out) {
+        out[0] = -a[1] + a[2];
+        out[1] = a[2] - std::cos(a[0]);
+    }), bounds, 0);
+    dae.setMassMatrix({1, 0, 0, 0});
+
+    options_t<T> options(tolerance_t<T>(tol, tol));
+    for (int i = 0; i <= 100; i++)
+        options.saveat.push_back(0.01 * i);
+
+    DataFrame<T> res = _RB23(dae, options);
+
+    T e1 = 0, e2 = 0;
+    for (size_t i = 0; i < res.getNumRows(); i++)
+    {
+        std::vector<T> row = res.getRow(i);
+        T exact = (std::cos(row[0]) + std::sin(row[0]) + std::exp(-row[0])) / 2;
+        e1 = std::max(e1, std::fabs(row[1] - exact));
+        e2 = std::max(e2, std::fabs(row[2] - std::cos(row[0])));
+    }
+
+    check(res.getNumRows() == 101, "dense output: rows", (double)res.getNumRows(), 101);
+    checkBelow("dense output: y1 error / tol", e1 / tol, 10);
+    checkBelow("dense output: y2 error / tol", e2 / tol, 10);
+}
+
+
+// algebraic variable set inconsistently, fixed by the solver before the first step
+void consistentInitialization()
+{
+    iv_t<T> iv = {0.0, 1.0, 5.0};
+    timeBound_t<T> bounds = {0.0, 1.0};
+
+    ODESystem<T> dae(iv, systemFunction_t<T>([](const std::vector<T>& a, std::vector<T>& out) {
+        out[0] = -a[1] + a[2];
+        out[1] = a[2] - std::cos(a[0]);
+    }), bounds, 0);
+    dae.setMassMatrix({1, 0, 0, 0});
+
+    DataFrame<T> res = _RB23(dae, options_t<T>());
+    checkBelow("consistent initialization: y2(0) - 1", res.getRow(0)[2] - 1, 1e-10);
+}
+
+
+// the explicit methods cannot honour a mass matrix, and must not ignore it
+void explicitMethodsRefuse()
+{
+    iv_t<T> iv = {0.0, 1.0, 1.0};
+    timeBound_t<T> bounds = {0.0, 1.0};
+
+    ODESystem<T> dae(iv, systemFunction_t<T>([](const std::vector<T>& a, std::vector<T>& out) {
+        out[0] = -a[1] + a[2];
+        out[1] = a[2] - std::cos(a[0]);
+    }), bounds, 0.01);
+    dae.setMassMatrix({1, 0, 0, 0});
+
+    for (algorithm_t alg : {ALGORITHM_EULER, ALGORITHM_RK4, ALGORITHM_RKF45})
+    {
+        bool thrown = false;
+        try { solve(dae, alg); }
+        catch (std::invalid_argument&) { thrown = true; }
+
+        check(thrown, "mass matrix with an explicit method throws");
+    }
+
+    DataFrame<T> res = solve(dae, ALGORITHM_RB23);
+    T exact = (std::cos(1.0) + std::sin(1.0) + std::exp(-1.0)) / 2;
+    checkBelow("mass matrix with RB23 through solve", res.getRow(res.getNumRows() - 1)[1] - exact, 1e-4);
+}
+
+
+// Cartesian pendulum of unit length in index 1 form, with the tension lambda
+// algebraic: x'' = -lambda x, y'' = -lambda y - g, 0 = u^2 + v^2 - lambda - g y
+// (using x^2 + y^2 = 1). Compared with the angle form theta'' = -g sin theta.
+void pendulum()
+{
+    const T g = 9.81, tol = 1e-8;
+
+    iv_t<T> iv = {0.0, 1.0, 0.0, 0.0, 0.0, 0.0};
+    timeBound_t<T> bounds = {0.0, 3.0};
+
+    ODESystem<T> dae(iv, systemFunction_t<T>([g](const std::vector<T>& a, std::vector<T>& out) {
+        T x = a[1], y = a[2], u = a[3], v = a[4], lambda = a[5];
+        out[0] = u;
+        out[1] = v;
+        out[2] = -lambda * x;
+        out[3] = -lambda * y - g;
+        out[4] = u * u + v * v - lambda * (x * x + y * y) - g * y;
+    }), bounds, 0);
+
+    std::vector<T> M(25, 0);
+    for (size_t i = 0; i < 4; i++)
+        M[i * 5 + i] = 1;
+    dae.setMassMatrix(M);
+
+    options_t<T> options;
+    options.tolerance = tolerance_t<T>(tol, tol);
+
+    DataFrame<T> res = _RB23(dae, options);
+    std::vector<T> last = res.getRow(res.getNumRows() - 1);
+
+    // theta from the downward vertical, x = sin theta, y = -cos theta
+    iv_t<T> ivAngle = {0.0, M_PI / 2, 0.0};
+    ODESystem<T> angle(ivAngle, systemFunction_t<T>([g](const std::vector<T>& a, std::vector<T>& out) {
+        out[0] = a[2];
+        out[1] = -g * std::sin(a[1]);
+    }), bounds, 0);
+
+    DataFrame<T> ref = _RKF45(angle, tolerance_t<T>(1e-12, 1e-12));
+    T theta = ref.getRow(ref.getNumRows() - 1)[1];
+
+    T energy = (last[3] * last[3] + last[4] * last[4]) / 2 + g * last[2];
+
+    checkBelow("pendulum: t end", last[0] - 3, 1e-12);
+    checkBelow("pendulum: x - sin theta", last[1] - std::sin(theta), 1e-5);
+    checkBelow("pendulum: y + cos theta", last[2] + std::cos(theta), 1e-5);
+    checkBelow("pendulum: length drift", last[1] * last[1] + last[2] * last[2] - 1, 1e-6);
+    checkBelow("pendulum: energy drift", energy, 1e-5);
+}
+
+
+int main()
+{
+    timeDependentConstraint();
+    denseOutput();
+    consistentInitialization();
+    explicitMethodsRefuse();
+    pendulum();
+
+    return report();
+}
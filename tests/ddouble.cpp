@@ -0,0 +1,84 @@
+#define DIFFEQ_DOUBLE_DOUBLE_PRECISION
+#include "diffeq.h"
+#include "check.h"
+
+#include <limits>
+#include <random>
+#define T ddouble
+
+using namespace DES;
+
+
+// relative error of a against the double-double constant (hi, lo)
+double relative(T a, double hi, double lo)
+{
+    T ref(hi, lo);
+    return (double)((a - ref) / ref);
+}
+
+
+// the exact product must hold whether it comes from fma or from the split
+void exactProduct()
+{
+    std::mt19937_64 gen(1);
+    std::uniform_real_distribution<double> mantissa(-1, 1);
+    std::uniform_int_distribution<int> exponent(-400, 400);
+
+    size_t wrong = 0;
+    for (size_t i = 0; i < 100000; i++)
+    {
+        double a = std::ldexp(mantissa(gen), exponent(gen));
+        double b = std::ldexp(mantissa(gen), exponent(gen));
+
+        double e;
+        double p = _twoProd(a, b, e);
+        if (e != std::fma(a, b, -p))
+            wrong++;
+    }
+
+    check(wrong == 0, "two product exact", (double)wrong, 0);
+}
+
+
+void arithmetic()
+{
+    checkBelow("1 / 3 * 3 - 1", (double)(T(1) / 3 * 3 - 1), 1e-31);
+    checkBelow("sqrt 2", relative(sqrt(T(2)), 1.414213562373095145e+00, -9.667293313452913451e-17), 1e-31);
+    checkBelow("exp 1", relative(exp(T(1)), 2.718281828459045091e+00, 1.445646891729250158e-16), 1e-30);
+    checkBelow("log exp 1 - 1", (double)(log(exp(T(1))) - 1), 1e-30);
+    checkBelow("sin pi / 6 - 1 / 2", (double)(sin(_DD_PI / 6) - T(1) / 2), 1e-30);
+
+    T max = std::numeric_limits<T>::max();
+    check(std::isfinite((double)max), "numeric_limits max is finite");
+    check((long)(T(1e18) + T(0.75)) == 1000000000000000000L, "truncation keeps lo");
+}
+
+
+// y' = y over [0, 1] with RK4, whose error at h = 2^-10 is about -e h^4 / 120
+// = -2e-14: near double rounding, so only a solve in ddouble resolves it
+void solve()
+{
+    iv_t<T> iv = {T(0), T(1)};
+    timeBound_t<T> bounds = {T(0), T(1)};
+
+    ODESystem<T> ode(iv, systemFunction_t<T>([](const std::vector<T>& a, std::vector<T>& out) {
+        out[0] = a[1];
+    }), bounds, T(1) / 1024);
+
+    DataFrame<T> res = _RK4(ode);
+    std::vector<T> last = res.getRow(res.getNumRows() - 1);
+
+    T error = last[1] - exp(last[0]);
+    checkBelow("RK4 y' = y: t end - 1", (double)(last[0] - 1), 1e-28);
+    check((double)error < -1e-15 && (double)error > -1e-13, "RK4 y' = y: error of order h^4 / 120", (double)error, 1e-13);
+}
+
+
+int main()
+{
+    exactProduct();
+    arithmetic();
+    solve();
+
+    return report();
+}
@@ -0,0 +1,105 @@
+#define DIFFEQ_DOUBLE_PRECISION
+#include "diffeq.h"
+#include "check.h"
+#define T double
+
+using namespace DES;
+
+
+std::vector<T> times(DataFrame<T>& res, size_t col, T near)
+{
+    std::vector<T> t;
+    for (size_t i = 0; i < res.getNumRows(); i++)
+        if (std::fabs(res.getRow(i)[col]) <= near)
+            t.push_back(res.getRow(i)[0]);
+
+    return t;
+}
+
+
+// u = cos t crosses zero at pi/2 + k pi: an event without an action only
+// records the crossings, with or without an output grid
+void recordCrossings()
+{
+    for (algorithm_t alg : {ALGORITHM_RKF45, ALGORITHM_RB23})
+    {
+        for (bool grid : {false, true})
+        {
+            iv_t<T> iv = {0.0, 1.0, 0.0};
+            timeBound_t<T> bounds = {0.0, 10.0};
+
+            ODESystem<T> ode(iv, systemFunction_t<T>([](const std::vector<T>& a, std::vector<T>& out) {
+                out[0] = a[2];
+                out[1] = -a[1];
+            }), bounds, 0);
+
+            options_t<T> options(tolerance_t<T>(1e-10, 1e-10));
+            options.events.push_back(event_t<T>(function_t<T>([](std::vector<T> a) { return a[1]; })));
+            if (grid)
+                for (int i = 0; i <= 100; i++)
+                    options.saveat.push_back(0.1 * i);
+
+            DataFrame<T> res = solve(ode, alg, options);
+            std::vector<T> crossings = times(res, 1, 1e-7);
+
+            check(crossings.size() == 3, grid ? "crossings recorded with saveat" : "crossings recorded", (double)crossings.size(), 3);
+            for (size_t k = 0; k < crossings.size(); k++)
+                checkBelow("crossing time", crossings[k] - (M_PI / 2 + k * M_PI), 1e-7);
+
+            if (grid)
+                check(res.getNumRows() == 104, "saveat rows plus event rows", (double)res.getNumRows(), 104);
+
+            bool ordered = true;
+            for (size_t i = 1; i < res.getNumRows(); i++)
+                ordered = ordered && res.getRow(i)[0] >= res.getRow(i - 1)[0];
+            check(ordered, "rows in time order");
+        }
+    }
+}
+
+
+// ball dropped from 1 m, bouncing with restitution 1/2: impacts at t1,
+// 2 t1 and 2.5 t1 with t1 = sqrt(2 / g), and a terminal event at t = 1.2
+void bouncingBall()
+{
+    const T g = 9.81, t1 = std::sqrt(2 / g);
+
+    for (algorithm_t alg : {ALGORITHM_RKF45, ALGORITHM_RB23})
+    {
+        iv_t<T> iv = {0.0, 1.0, 0.0};
+        timeBound_t<T> bounds = {0.0, 2.0};
+
+        ODESystem<T> ode(iv, systemFunction_t<T>([g](const std::vector<T>& a, std::vector<T>& out) {
+            out[0] = a[2];
+            out[1] = -g;
+        }), bounds, 0);
+
+        options_t<T> options(tolerance_t<T>(1e-10, 1e-10));
+        options.events.push_back(event_t<T>(function_t<T>([](std::vector<T> a) { return a[1]; }),
+            DIRECTION_FALLING, false, [](std::vector<T>& y) { y[2] = -y[2] / 2; }));
+        options.events.push_back(event_t<T>(function_t<T>([](std::vector<T> a) { return a[0] - 1.2; }),
+            DIRECTION_RISING, true));
+
+        // a whole bounce must not fit in one step
+        options.maxStep = 0.05;
+
+        DataFrame<T> res = solve(ode, alg, options);
+        std::vector<T> impacts = times(res, 1, 1e-7);
+
+        check(impacts.size() == 3, "impacts", (double)impacts.size(), 3);
+        T expected[] = {t1, 2 * t1, 2.5 * t1};
+        for (size_t k = 0; k < impacts.size() && k < 3; k++)
+            checkBelow("impact time", impacts[k] - expected[k], 1e-7);
+
+        checkBelow("terminal event time", res.getRow(res.getNumRows() - 1)[0] - 1.2, 1e-9);
+    }
+}
+
+
+int main()
+{
+    recordCrossings();
+    bouncingBall();
+
+    return report();
+}
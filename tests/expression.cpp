@@ -0,0 +1,62 @@
+#define DIFFEQ_DOUBLE_DOUBLE_PRECISION
+#include "diffeq.h"
+#include "check.h"
+
+#define T ddouble
+
+using namespace DES;
+
+
+// y' = -k y + c t with literals k and c written in ddouble: the right hand side
+// and the Jacobian must carry all 31 digits, not those of a double
+void literalPrecision()
+{
+    auto [y] = states<1>();
+    auto t = timeSymbol();
+
+    const T k = T(1) / 10, c = T(2) / 3;
+    auto model = equations(-k * y + t * c);
+
+    std::vector<T> args = {T(3), T(1) / 7}, out(1), J(1);
+    model.function<T>()(args, out);
+    model.jacobian<T>()(args, J);
+
+    T exact = -(T(1) / 10) * (T(1) / 7) + T(3) * (T(2) / 3);
+    checkBelow("ddouble literal in the function", (double)((out[0] - exact) / exact), 1e-30);
+    checkBelow("ddouble literal in the Jacobian", (double)((J[0] + T(1) / 10) * 10), 1e-30);
+
+    // a double literal still gives the double value
+    auto rounded = equations(y * 0.1);
+    rounded.function<T>()(args, out);
+    checkBelow("double literal", (double)(out[0] - T(0.1) * args[1]), 1e-31);
+}
+
+
+// the same equations solved with the expression and with a lambda
+void solveAgainstLambda()
+{
+    auto [x, v] = states<2>();
+    const T w2 = T(4) / 3;
+    auto model = equations(v, -w2 * x);
+
+    iv_t<T> iv = {T(0), T(1), T(0)};
+    timeBound_t<T> bounds = {T(0), T(1)};
+
+    ODESystem<T> expr(iv, model.function<T>(), bounds, T(1) / 64);
+    ODESystem<T> lambda(iv, systemFunction_t<T>([w2](const std::vector<T>& a, std::vector<T>& out) {
+        out[0] = a[2];
+        out[1] = -w2 * a[1];
+    }), bounds, T(1) / 64);
+
+    std::vector<T> a = _RK4_i(expr), b = _RK4_i(lambda);
+    check(a[1] == b[1] && a[2] == b[2], "RK4 with expression equals RK4 with lambda");
+}
+
+
+int main()
+{
+    literalPrecision();
+    solveAgainstLambda();
+
+    return report();
+}
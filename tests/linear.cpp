@@ -0,0 +1,81 @@
+#define DIFFEQ_DOUBLE_PRECISION
+#include "diffeq.h"
+#include "check.h"
+
+#include <algorithm>
+#define T double
+
+using namespace DES;
+
+
+// y1' = y2, y2' = -9 y1 + 2, y(0) = (1, 0): y1 = 2/9 + 7/9 cos 3t, stepped far
+// beyond the stability limit of any explicit method
+void forcedOscillator()
+{
+    iv_t<T> iv = {0.0, 1.0, 0.0};
+    timeBound_t<T> bounds = {0.0, 10.0};
+
+    LinearODESystem<T> system(iv, {0, 1, -9, 0}, {0, 2}, bounds, 2.5);
+    DataFrame<T> res = solve(system, ALGORITHM_EXPM);
+
+    T e = 0;
+    for (size_t i = 0; i < res.getNumRows(); i++)
+    {
+        std::vector<T> row = res.getRow(i);
+        e = std::max(e, std::fabs(row[1] - (2.0 / 9 + 7.0 / 9 * std::cos(3 * row[0]))));
+        e = std::max(e, std::fabs(row[2] + 7.0 / 3 * std::sin(3 * row[0])));
+    }
+
+    check(res.getNumRows() == 5, "forced oscillator: rows", (double)res.getNumRows(), 5);
+    checkBelow("forced oscillator: error", e, 1e-13);
+}
+
+
+// eigenvalues -1 and -1e6 with coupling, at h = 1. The stiff mode is damped
+// exactly, but the 20 squarings for |hA| = 1e6 amplify the rounding of the
+// scaled exponential, to a relative error of about |hA| eps / 10 per step
+void stiff()
+{
+    iv_t<T> iv = {0.0, 1.0, 1.0};
+    timeBound_t<T> bounds = {0.0, 3.0};
+
+    // A = [-1, 1; 0, -1e6], y1 = (1 + c) e^-t - c e^(-1e6 t), y2 = e^(-1e6 t), c = 1 / (1e6 - 1)
+    LinearODESystem<T> system(iv, {-1, 1, 0, -1e6}, bounds, 1);
+    DataFrame<T> res = solve(system, ALGORITHM_EXPM);
+    std::vector<T> last = res.getRow(res.getNumRows() - 1);
+
+    T c = 1 / (1e6 - 1);
+    checkBelow("stiff: y1 relative error", (last[1] - (1 + c) * std::exp(-3.0)) / std::exp(-3.0), 1e-10);
+    checkBelow("stiff: y2", last[2], 1e-300);
+}
+
+
+// the propagator of a rotation is the rotation matrix, and its forcing column
+// h phi_1(hA) b
+void propagator()
+{
+    iv_t<T> iv = {0.0, 1.0, 0.0};
+    timeBound_t<T> bounds = {0.0, 1.0};
+
+    LinearODESystem<T> system(iv, {0, 1, -1, 0}, {1, 0}, bounds, 0.1);
+    const std::vector<T>& P = system.getPropagator(0.7);
+
+    T c = std::cos(0.7), s = std::sin(0.7);
+    T expected[] = {c, s, s, -s, c, c - 1};
+
+    T e = 0;
+    for (size_t k = 0; k < 6; k++)
+        e = std::max(e, std::fabs(P[k] - expected[k]));
+
+    checkBelow("propagator of a rotation", e, 1e-15);
+}
+
+
+int main()
+{
+    forcedOscillator();
+    stiff();
+    propagator();
+
+    return report();
+}
@@ -0,0 +1,84 @@
+#define DIFFEQ_DOUBLE_PRECISION
+#include "diffeq.h"
+#include "check.h"
+
+#include <algorithm>
+#include <stdexcept>
+#define T double
+
+using namespace DES;
+
+
+ODESystem<T> oscillator(T tEnd)
+{
+    iv_t<T> iv = {0.0, 1.0, 0.0};
+    timeBound_t<T> bounds = {0.0, tEnd};
+
+    return ODESystem<T>(iv, systemFunction_t<T>([](const std::vector<T>& a, std::vector<T>& out) {
+        out[0] = a[2];
+        out[1] = -a[1];
+    }), bounds, 0);
+}
+
+
+// y'' = -y over [0, 20] on 16 slices, with a coarse RK4 of step 0.5 that is off
+// by about 1e-3: the converged solution has the accuracy of the fine solver
+void harmonicOscillator()
+{
+    ODESystem<T> ode = oscillator(20);
+
+    DataFrame<T> res = parareal(ode,
+        propagator_t<T>(ALGORITHM_RK4, 0.5),
+        propagator_t<T>(ALGORITHM_RKF45, options_t<T>(tolerance_t<T>(1e-11, 1e-11))),
+        pararealOptions_t<T>(16, tolerance_t<T>(1e-9, 1e-9)));
+
+    T e = 0;
+    bool ordered = true;
+    for (size_t i = 0; i < res.getNumRows(); i++)
+    {
+        std::vector<T> row = res.getRow(i);
+        e = std::max(e, std::fabs(row[1] - std::cos(row[0])));
+        e = std::max(e, std::fabs(row[2] + std::sin(row[0])));
+        ordered = ordered && (i == 0 || row[0] > res.getRow(i - 1)[0]);
+    }
+
+    checkBelow("oscillator: t end", res.getRow(res.getNumRows() - 1)[0] - 20, 1e-12);
+    checkBelow("oscillator: error", e, 1e-7);
+    check(ordered, "oscillator: rows in time order");
+}
+
+
+// with one slice the fine solution of the first iteration is the answer
+void oneSlice()
+{
+    ODESystem<T> ode = oscillator(5);
+    propagator_t<T> fine(ALGORITHM_RKF45, options_t<T>(tolerance_t<T>(1e-10, 1e-10)));
+
+    DataFrame<T> res = parareal(ode, propagator_t<T>(ALGORITHM_RK4, 1.0), fine, pararealOptions_t<T>(1));
+    DataFrame<T> ref = fine(ode);
+
+    std::vector<T> a = res.getRow(res.getNumRows() - 1), b = ref.getRow(ref.getNumRows() - 1);
+    check(a == b, "one slice is the fine solve");
+}
+
+
+void noSlices()
+{
+    ODESystem<T> ode = oscillator(1);
+
+    bool thrown = false;
+    try { parareal(ode, propagator_t<T>(ALGORITHM_RK4, 0.1), propagator_t<T>(ALGORITHM_RK4, 0.01), pararealOptions_t<T>(0)); }
+    catch (std::invalid_argument&) { thrown = true; }
+
+    check(thrown, "no slices throws");
+}
+
+
+int main()
+{
+    harmonicOscillator();
+    oneSlice();
+    noSlices();
+
+    return report();
+}
@@ -0,0 +1,149 @@
+#define DIFFEQ_DOUBLE_PRECISION
+#include "diffeq.h"
+#include "check.h"
+
+#include <algorithm>
+#include <stdexcept>
+#define T double
+
+using namespace DES;
+
+
+// y' = -1000 (y - cos t) - sin t, y(0) = 1, whose solution is cos t
+void stiffLinear()
+{
+    for (T tol : {1e-6, 1e-9})
+    {
+        iv_t<T> iv = {0.0, 1.0};
+        timeBound_t<T> bounds = {0.0, 10.0};
+
+        ODESystem<T> ode(iv, systemFunction_t<T>([](const std::vector<T>& a, std::vector<T>& out) {
+            out[0] = -1000 * (a[1] - std::cos(a[0])) - std::sin(a[0]);
+        }), bounds, 0);
+
+        options_t<T> options;
+        options.tolerance = tolerance_t<T>(tol, tol);
+
+        DataFrame<T> res = _RB23(ode, options);
+        std::vector<T> last = res.getRow(res.getNumRows() - 1);
+
+        checkBelow("stiff linear: t end", last[0] - 10, 1e-12);
+        checkBelow("stiff linear: error / tol", (last[1] - std::cos(10.0)) / tol, 10);
+    }
+}
+
+
+// Robertson's chemical kinetics: y1 + y2 + y3 is conserved, and y(40) is the
+// reference solution of Hairer and Wanner's test set
+void robertson()
+{
+    iv_t<T> iv = {0.0, 1.0, 0.0, 0.0};
+    timeBound_t<T> bounds = {0.0, 40.0};
+
+    ODESystem<T> ode(iv, systemFunction_t<T>([](const std::vector<T>& a, std::vector<T>& out) {
+        out[0] = -0.04 * a[1] + 1e4 * a[2] * a[3];
+        out[1] = 0.04 * a[1] - 1e4 * a[2] * a[3] - 3e7 * a[2] * a[2];
+        out[2] = 3e7 * a[2] * a[2];
+    }), bounds, 0);
+
+    options_t<T> options;
+    options.tolerance = tolerance_t<T>({1e-10, 1e-14, 1e-10}, {1e-8, 1e-8, 1e-8});
+
+    DataFrame<T> res = _RB23(ode, options);
+    std::vector<T> last = res.getRow(res.getNumRows() - 1);
+
+    checkBelow("robertson: conservation", last[1] + last[2] + last[3] - 1, 1e-10);
+    checkBelow("robertson: y1 relative error", (last[1] - 0.7158270687193) / 0.7158270687193, 1e-6);
+    checkBelow("robertson: y2 relative error", (last[2] - 0.9185534764763e-5) / 0.9185534764763e-5, 1e-6);
+    checkBelow("robertson: y3 relative error", (last[3] - 0.2841637457459) / 0.2841637457459, 1e-6);
+}
+
+
+// Brusselator on N cells, with (u, v) of each cell next to each other, so the
+// Jacobian is block tridiagonal with 2 x 2 blocks (Hairer and Wanner IV.10)
+ODESystem<T> brusselator(size_t N)
+{
+    iv_t<T> iv = {0.0};
+    for (size_t k = 0; k < N; k++)
+    {
+        T x = (T)(k + 1) / (N + 1);
+        iv.vec.push_back(1 + std::sin(2 * M_PI * x));
+        iv.vec.push_back(3);
+    }
+    timeBound_t<T> bounds = {0.0, 10.0};
+
+    return ODESystem<T>(iv, systemFunction_t<T>([N](const std::vector<T>& a, std::vector<T>& out) {
+        T c = 0.02 * (N + 1) * (N + 1);
+        for (size_t k = 0; k < N; k++)
+        {
+            T u = a[2 * k + 1], v = a[2 * k + 2];
+            T ul = k > 0 ? a[2 * k - 1] : 1, vl = k > 0 ? a[2 * k] : 3;
+            T ur = k + 1 < N ? a[2 * k + 3] : 1, vr = k + 1 < N ? a[2 * k + 4] : 3;
+
+            out[2 * k] = 1 + u * u * v - 4 * u + c * (ul - 2 * u + ur);
+            out[2 * k + 1] = 3 * u - u * u * v + c * (vl - 2 * v + vr);
+        }
+    }), bounds, 0);
+}
+
+
+// W factored by blocks, as a band and as a full matrix gives the same solution.
+// Two cells make a block of 4, still coupled only to the neighbouring blocks.
+void blockTridiagonal()
+{
+    const size_t N = 40;
+    options_t<T> options(tolerance_t<T>(1e-8, 1e-8));
+
+    ODESystem<T> full = brusselator(N), band = brusselator(N), blocks = brusselator(N);
+    band.setSparsity(bandedSparsity(2 * N, 3, 3));
+    blocks.setSparsity(blockTridiagonalSparsity(N / 2, 4));
+
+    check(_iterationMatrix_t<T>(blocks).blocks, "block tridiagonal W is factored by blocks");
+
+    DataFrame<T> resFull = _RB23(full, options), resBand = _RB23(band, options), resBlocks = _RB23(blocks, options);
+    std::vector<T> a = resFull.getRow(resFull.getNumRows() - 1);
+    std::vector<T> b = resBand.getRow(resBand.getNumRows() - 1);
+    std::vector<T> c = resBlocks.getRow(resBlocks.getNumRows() - 1);
+
+    T db = 0, dc = 0;
+    for (size_t i = 1; i <= 2 * N; i++)
+    {
+        db = std::max(db, std::fabs(b[i] - a[i]));
+        dc = std::max(dc, std::fabs(c[i] - a[i]));
+    }
+
+    checkBelow("brusselator: band - full", db, 1e-8);
+    checkBelow("brusselator: blocks - full", dc, 1e-8);
+}
+
+
+// a right hand side that turns NaN must stop the solve, not loop on a NaN step
+void notFinite()
+{
+    for (T start : {0.0, 1.0})
+    {
+        iv_t<T> iv = {start, 1.0};
+        timeBound_t<T> bounds = {start, start + 1};
+
+        ODESystem<T> ode(iv, systemFunction_t<T>([start](const std::vector<T>& a, std::vector<T>& out) {
+            out[0] = a[0] > start + 0.5 ? std::nan("") : -a[1];
+        }), bounds, 0);
+
+        bool thrown = false;
+        try { _RB23(ode, options_t<T>()); }
+        catch (std::runtime_error&) { thrown = true; }
+
+        check(thrown, "NaN right hand side throws");
+    }
+}
+
+
+int main()
+{
+    stiffLinear();
+    robertson();
+    blockTridiagonal();
+    notFinite();
+
+    return report();
+}
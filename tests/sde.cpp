@@ -0,0 +1,115 @@
+#define DIFFEQ_DOUBLE_PRECISION
+#include "diffeq.h"
+#include "check.h"
+
+#include <stdexcept>
+#define T double
+
+using namespace DES;
+
+
+// without noise SRA1 is a Runge-Kutta method: y' = -y, y(0) = 1
+void zeroNoise()
+{
+    for (T tol : {1e-4, 1e-6})
+    {
+        iv_t<T> iv = {0.0, 1.0};
+        timeBound_t<T> bounds = {0.0, 1.0};
+
+        SDESystem<T> sde(iv, {function_t<T>([](std::vector<T> a) { return -a[1]; })},
+            {function_t<T>([](std::vector<T> a) { return 0.0; })}, bounds, 0, 1);
+
+        DataFrame<T> res = _SRA1(sde, options_t<T>(tolerance_t<T>(tol, tol)));
+        std::vector<T> last = res.getRow(res.getNumRows() - 1);
+
+        checkBelow("zero noise: t end", last[0] - 1, 1e-12);
+        checkBelow("zero noise: error / tol", (last[1] - std::exp(-1.0)) / tol, 10);
+    }
+}
+
+
+// Ornstein-Uhlenbeck dy = -y dt + s dW, y(0) = 1: y(1) has mean e^-1 and
+// variance s^2 (1 - e^-2) / 2
+void ornsteinUhlenbeck()
+{
+    const T s = 0.5;
+    const size_t paths = 4000;
+
+    iv_t<T> iv = {0.0, 1.0};
+    timeBound_t<T> bounds = {0.0, 1.0};
+
+    SDESystem<T> sde(iv, {function_t<T>([](std::vector<T> a) { return -a[1]; })},
+        {function_t<T>([s](std::vector<T> a) { return s; })}, bounds, 0, 7);
+
+    T sum = 0, sum2 = 0;
+    for (size_t p = 0; p < paths; p++)
+    {
+        sde.setPath(p);
+        DataFrame<T> res = _SRA1(sde, options_t<T>(tolerance_t<T>(1e-4, 1e-4)));
+        T y = res.getRow(res.getNumRows() - 1)[1];
+        sum += y;
+        sum2 += y * y;
+    }
+
+    T mean = sum / paths;
+    T var = sum2 / paths - mean * mean;
+    T exactVar = s * s * (1 - std::exp(-2.0)) / 2;
+
+    // four standard errors of the mean, and of the variance of a normal sample
+    checkBelow("Ornstein-Uhlenbeck: mean", mean - std::exp(-1.0), 4 * std::sqrt(exactVar / paths));
+    checkBelow("Ornstein-Uhlenbeck: variance", var - exactVar, 4 * exactVar * std::sqrt(2.0 / paths));
+}
+
+
+// a drift that turns NaN must stop the solve, not loop on rejected steps
+void notFinite()
+{
+    iv_t<T> iv = {0.0, 1.0};
+    timeBound_t<T> bounds = {0.0, 1.0};
+
+    SDESystem<T> sde(iv, {function_t<T>([](std::vector<T> a) { return a[0] > 0.5 ? std::nan("") : -a[1]; })},
+        {function_t<T>([](std::vector<T> a) { return 0.1; })}, bounds, 0, 1);
+
+    bool thrown = false;
+    try { _SRA1(sde); }
+    catch (std::runtime_error&) { thrown = true; }
+
+    check(thrown, "NaN drift throws");
+}
+
+
+// output times and events are not supported, and must not be ignored
+void unsupportedOptions()
+{
+    iv_t<T> iv = {0.0, 1.0};
+    timeBound_t<T> bounds = {0.0, 1.0};
+
+    SDESystem<T> sde(iv, {function_t<T>([](std::vector<T> a) { return -a[1]; })},
+        {function_t<T>([](std::vector<T> a) { return 0.1; })}, bounds, 0, 1);
+
+    options_t<T> saveat;
+    saveat.saveat = {0.5, 1.0};
+
+    options_t<T> events;
+    events.events.push_back(event_t<T>(function_t<T>([](std::vector<T> a) { return a[1] - 0.5; })));
+
+    for (options_t<T>* options : {&saveat, &events})
+    {
+        bool thrown = false;
+        try { solve(sde, ALGORITHM_SRA1, *options); }
+        catch (std::invalid_argument&) { thrown = true; }
+
+        check(thrown, options == &saveat ? "saveat throws" : "events throw");
+    }
+}
+
+
+int main()
+{
+    zeroNoise();
+    ornsteinUhlenbeck();
+    notFinite();
+    unsupportedOptions();
+
+    return report();
+}